@@ -40,6 +40,8 @@ typedef struct
 
 U32 MeshAdd(Vertex* vertices, unsigned int count);
 void MeshRemove(U32 meshId);
+void MeshSetOccluder(U32 meshId, Vec3* positions, unsigned int count);
+void MeshPackNormals(Vertex* vertices, Vec3* normals, unsigned int count);
 ]]
 
 -- Generate constructors + metatables for types
@@ -72,13 +74,42 @@ end
 
 -- Define a Lua-friendly interface for mesh creation
 mesh = {
-    add = function(verts)     
+    -- normals is optional; if given, it must be a table of Vec3 matching verts
+    add = function(verts, normals)     
         -- Pass vertices to C++
         local vertices = ffi.new("Vertex[?]", #verts)
         for i,v in ipairs(verts) do
             vertices[i-1] = v
         end
+
+        if normals ~= nil then
+            if #normals ~= #verts then
+                error(string.format("mesh.add: got %d normals for %d vertices", #normals, #verts), 2)
+            end
+
+            local packedNormals = ffi.new("Vec3[?]", #normals)
+            for i,n in ipairs(normals) do
+                packedNormals[i-1] = n
+            end
+            ffi.C.MeshPackNormals(vertices, packedNormals, #verts)
+        end
+
         return ffi.C.MeshAdd(vertices, #verts)
     end,
-    remove = ffi.C.MeshRemove
+    remove = ffi.C.MeshRemove,
+
+    -- positions is a triangle list of Vec3 inside the mesh's solid parts;
+    -- whatever it covers on screen is not drawn
+    setOccluder = function(meshId, positions)
+        if #positions % 3 ~= 0 then
+            error(string.format("mesh.setOccluder: got %d positions, which is not a triangle list", #positions), 2)
+        end
+
+        local occluder = ffi.new("Vec3[?]", #positions)
+        for i,p in ipairs(positions) do
+            occluder[i-1] = p
+        end
+
+        ffi.C.MeshSetOccluder(meshId, occluder, #positions)
+    end
 }
\ No newline at end of file
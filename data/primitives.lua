@@ -128,4 +128,32 @@ function WindowWallCell(verts, origin, size, colour, windowSize, zOriented)
         Cuboid(verts, origin + Vec3(0, frameHeight, 0), Vec3(size.z, size.y - 2*frameHeight, frameWidth), colour)
         Cuboid(verts, origin + Vec3(0, frameHeight, size.x - frameWidth), Vec3(size.z, size.y - 2*frameHeight, frameWidth), colour)
     end
+end
+
+-- Quad as two triangles of positions, for occluders; corners go around the edge
+function Quad(t, a, b, c, d)
+    table.insert(t, a)
+    table.insert(t, b)
+    table.insert(t, c)
+
+    table.insert(t, a)
+    table.insert(t, c)
+    table.insert(t, d)
+end
+
+-- Outer faces of an axis-aligned box, for occluders
+function BoxSides(t, origin, size)
+    local function corner(x, y, z)
+        return origin + Vec3(size.x * x, size.y * y, size.z * z)
+    end
+
+    Quad(t, corner(0, 0, 0), corner(1, 0, 0), corner(1, 1, 0), corner(0, 1, 0))
+    Quad(t, corner(0, 0, 1), corner(1, 0, 1), corner(1, 1, 1), corner(0, 1, 1))
+    Quad(t, corner(0, 0, 0), corner(0, 0, 1), corner(0, 1, 1), corner(0, 1, 0))
+    Quad(t, corner(1, 0, 0), corner(1, 0, 1), corner(1, 1, 1), corner(1, 1, 0))
+end
+
+-- Horizontal rectangle at origin.y, for occluders
+function Slab(t, origin, size)
+    Quad(t, origin, origin + Vec3(size.x, 0, 0), origin + Vec3(size.x, 0, size.z), origin + Vec3(0, 0, size.z))
 end
\ No newline at end of file
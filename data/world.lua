@@ -15,9 +15,21 @@ function MakeBuilding(levelCount, wallHeight, windowCount, cellWidth, windowWidt
     local origin = Vec3(200, 58, 450)
     local windowSize = Vec2(windowWidth, windowWidth + 0.2)
 
+    -- Occluder hull: only the solid parts, as the windows can be seen through
+    local hull = {}
+    local width = windowCount*cellWidth
+    local frameHeight = math.max((wallHeight - windowSize.y)/2, 0)
+
     for level = 0, levelCount-1 do
         local levelOrigin = origin + Vec3(0, wallHeight * level, 0)
         Cuboid(verts, levelOrigin + Vec3(thickness, 0, thickness), Vec3(windowCount*cellWidth - 2*thickness, 0.1, windowCount*cellWidth - 2*thickness), Colour(80, 80, 80, 255))
+        Slab(hull, levelOrigin + Vec3(thickness, 0.1, thickness), Vec3(width - 2*thickness, 0, width - 2*thickness))
+
+        -- The walls are solid above and below the windows all the way round
+        if frameHeight > 0 then
+            BoxSides(hull, levelOrigin, Vec3(width, frameHeight, width))
+            BoxSides(hull, levelOrigin + Vec3(0, wallHeight - frameHeight, 0), Vec3(width, frameHeight, width))
+        end
 
         local colourScale = math.lerp(80, 120, (level+1)/levelCount)
         local colour = Colour(colourScale, colourScale, colourScale, 255)
@@ -35,6 +47,7 @@ function MakeBuilding(levelCount, wallHeight, windowCount, cellWidth, windowWidt
 
     -- Final ceiling
     Cuboid(verts, origin + Vec3(0, levelCount*wallHeight, 0), Vec3(windowCount*cellWidth, 0.1, windowCount*cellWidth), Colour(80, 80, 80, 255))
+    Slab(hull, origin + Vec3(0, levelCount*wallHeight + 0.1, 0), Vec3(width, 0, width))
     -- Corner pillars
     local pillarSize = 0.5
     Cuboid(verts, origin + Vec3(thickness, 0, thickness), Vec3(pillarSize, levelCount*wallHeight, pillarSize), Colour(60, 60, 60, 255))
@@ -43,6 +56,7 @@ function MakeBuilding(levelCount, wallHeight, windowCount, cellWidth, windowWidt
     Cuboid(verts, origin + Vec3(windowCount*cellWidth - (pillarSize + thickness), 0, windowCount*cellWidth - (pillarSize + thickness)), Vec3(pillarSize, levelCount*wallHeight, pillarSize), Colour(60, 60, 60, 255))
 
     lastBuilding = mesh.add(verts)
+    mesh.setOccluder(lastBuilding, hull)
     print("New building!")
 end
 
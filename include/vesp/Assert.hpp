@@ -1,14 +1,22 @@
 #pragma once
 
 #include "vesp/Types.hpp"
+
+#ifdef _MSC_VER
 #include <intrin.h>
+#endif
 
 namespace vesp 
 {
 	void AssertFail(RawStringPtr error, RawStringPtr file, U32 line);
 }
 
-#define VESP_BREAK() __debugbreak()
+// The tests also build with GCC and Clang
+#ifdef _MSC_VER
+	#define VESP_BREAK() __debugbreak()
+#else
+	#define VESP_BREAK() __builtin_trap()
+#endif
 
 #define VESP_ENFORCE(cond) \
 	do \
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "vesp/util/GlobalSystem.hpp"
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+#include "vesp/Assert.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace vesp
+{
+	enum class AssetState : U8
+	{
+		Queued,
+		Decoded,
+		Ready,
+		Failed
+	};
+
+	// Type-erased part of a request; owned jointly by the loader and the
+	// handle returned to the caller.
+	struct AssetRequestBase
+	{
+		virtual ~AssetRequestBase() {}
+
+		// Runs on a worker thread with the contents of the file.
+		virtual bool Decode(ArrayView<U8> data) = 0;
+		// Runs on the main thread, counted against the upload budget.
+		virtual void Complete() = 0;
+		// Runs on the main thread if the file could not be read or decoded.
+		virtual void Fail() = 0;
+
+		String path;
+		std::atomic<AssetState> state{AssetState::Queued};
+	};
+
+	template <typename T>
+	struct AssetRequest : public AssetRequestBase
+	{
+		bool Decode(ArrayView<U8> data) override
+		{
+			return !this->decoder || this->decoder(data, this->asset);
+		}
+
+		void Complete() override
+		{
+			if (this->callback)
+				this->callback(this->asset);
+		}
+
+		void Fail() override
+		{
+			if (this->failure)
+				this->failure();
+		}
+
+		T asset;
+		std::function<bool (ArrayView<U8>, T&)> decoder;
+		std::function<void (T&)> callback;
+		std::function<void ()> failure;
+	};
+
+	template <typename T>
+	class AssetHandle
+	{
+	public:
+		friend class AssetLoader;
+
+		AssetHandle() {}
+
+		bool IsValid() const
+		{
+			return this->request_ != nullptr;
+		}
+
+		bool IsPending() const
+		{
+			auto state = this->GetState();
+			return state == AssetState::Queued || state == AssetState::Decoded;
+		}
+
+		bool IsReady() const
+		{
+			return this->GetState() == AssetState::Ready;
+		}
+
+		bool HasFailed() const
+		{
+			return this->GetState() == AssetState::Failed;
+		}
+
+		AssetState GetState() const
+		{
+			VESP_ASSERT(this->IsValid());
+			return this->request_->state;
+		}
+
+		T& Get()
+		{
+			VESP_ASSERT(this->IsReady());
+			return this->request_->asset;
+		}
+
+	private:
+		std::shared_ptr<AssetRequest<T>> request_;
+	};
+
+	// Reads and decodes files on a pool of worker threads. Decoders run on the
+	// workers and must only touch the asset they are given; callbacks run on
+	// the main thread during Pulse, which is where GPU uploads belong.
+	class AssetLoader : public util::GlobalSystem<AssetLoader, MemoryTag::Assets>
+	{
+	public:
+		AssetLoader(U32 workerCount = 0);
+		~AssetLoader();
+
+		template <typename T>
+		AssetHandle<T> Load(StringView path, 
+			std::function<bool (ArrayView<U8>, T&)> decoder,
+			std::function<void (T&)> callback = nullptr,
+			std::function<void ()> failure = nullptr)
+		{
+			auto request = std::make_shared<AssetRequest<T>>();
+			request->path = path.CopyToVector();
+			request->decoder = std::move(decoder);
+			request->callback = std::move(callback);
+			request->failure = std::move(failure);
+
+			this->Enqueue(request);
+
+			AssetHandle<T> handle;
+			handle.request_ = std::move(request);
+			return handle;
+		}
+
+		// Runs completed callbacks until the upload budget for the frame is spent.
+		void Pulse();
+		// Blocks until every outstanding request has completed.
+		void Flush();
+
+		// Runs `task` on a worker ahead of any queued file reads. Tasks
+		// must not wait for other work queued here.
+		void Schedule(std::function<void ()> task);
+
+		void SetUploadBudget(F32 milliseconds);
+		U32 GetPendingCount() const;
+		U32 GetWorkerCount() const;
+
+	private:
+		typedef std::shared_ptr<AssetRequestBase> RequestPtr;
+
+		void Enqueue(RequestPtr request);
+		void WorkerMain();
+		bool CompleteOne();
+
+		Vector<std::thread> workers_;
+
+		std::mutex queueMutex_;
+		std::condition_variable queueCondition_;
+		Deque<RequestPtr> queue_;
+		Deque<std::function<void ()>> tasks_;
+		bool quit_ = false;
+
+		std::mutex completedMutex_;
+		std::condition_variable completedCondition_;
+		Deque<RequestPtr> completed_;
+
+		U32 pending_ = 0;
+		F32 uploadBudget_ = 2.0f;
+	};
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "vesp/util/Delegate.hpp"
 #include "vesp/util/GlobalSystem.hpp"
 
 #include "vesp/graphics/Colour.hpp"
@@ -15,9 +16,7 @@
 
 namespace vesp {
 
-	class Console : 
-		public InputHandler,
-		public util::GlobalSystem<Console>
+	class Console : public util::GlobalSystem<Console, MemoryTag::Console>
 	{
 	public:
 		static const size_t MaxHistoryLength = 100;
@@ -75,6 +74,9 @@ namespace vesp {
 
 		UniquePtr<script::Module> module_;
 
+		util::Subscription consoleSubscription_;
+		util::Subscription renderGuiSubscription_;
+
 		bool active_ = false;
 		bool inputNeedsFocus_ = false;
 		bool scrollToBottom_ = false;
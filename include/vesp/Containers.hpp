@@ -1,6 +1,7 @@
 #pragma once
 
-// Implemented as standard library containers until otherwise needed
+// Implemented as standard library containers until otherwise needed; they
+// allocate through the memory tracker
 #pragma warning(push)
 #pragma warning(disable: 4530)
 #include <vector>
@@ -11,20 +12,22 @@
 #pragma warning(pop)
 
 #include "vesp/Types.hpp"
+#include "vesp/Memory.hpp"
 
 namespace vesp
 {
 	template <typename T>
-	using Vector = std::vector<T>;
+	using Vector = std::vector<T, TrackedAllocator<T>>;
 
 	template <typename K, typename T>
-	using UnorderedMap = std::unordered_map<K, T>;
+	using UnorderedMap = std::unordered_map<K, T, std::hash<K>, std::equal_to<K>, 
+		TrackedAllocator<std::pair<K const, T>>>;
 
 	template <typename T, int N>
 	using Array = std::array<T, N>;
 
 	template <typename T>
-	using Deque = std::deque<T>;
+	using Deque = std::deque<T, TrackedAllocator<T>>;
 
 	template <typename T>
 	struct ArrayView
@@ -1,24 +1,111 @@
 #pragma once
 
 #include "vesp/Containers.hpp"
+#include "vesp/Events.hpp"
 #include "vesp/Types.hpp"
+#include "vesp/util/Delegate.hpp"
 #include "vesp/util/GlobalSystem.hpp"
 
-#include <functional>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
 
 namespace vesp
 {
+	// Handlers are subscribed and events fired on the main thread. Any
+	// thread may Post; posted events are delivered by DispatchQueued.
 	class EventManager : public util::GlobalSystem<EventManager>
 	{
 	public:
+		// Bytes of posted events that each of the two queues can hold
+		static const U32 QueueCapacity = 64 * 1024;
+
 		EventManager();
 
-		typedef std::function<bool (void const*)> EventHandler;
+		// The event type is named explicitly, so handlers taking a
+		// different payload fail to compile. Handlers are stored as
+		// delegates and share their size limit.
+		template <typename T, typename Function>
+		util::Subscription Subscribe(Function function)
+		{
+			auto index = EventIndex<T>::Value;
+			auto id = this->handlers_[index].Add(
+				[function](void const* event) -> bool { return function(*static_cast<T const*>(event)); });
+
+			return {index, id};
+		}
+
+		// Safe from inside a handler, including the one being removed
+		void Unsubscribe(util::Subscription subscription);
+
+		template <typename T>
+		bool Fire(T const& event)
+		{
+			bool ret = true;
+			this->handlers_[EventIndex<T>::Value].Visit([&](Handler const& f) {
+				ret &= f(&event);
+			});
+
+			return ret;
+		}
+
+		// Copies the event into the current frame's queue without locking.
+		// Returns false, and the event is dropped, when the queue is full.
+		template <typename T>
+		bool Post(T const& event)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Posted events are copied as bytes");
+			static_assert(alignof(T) <= sizeof(Block), "Posted events are aligned to a block");
+
+			auto record = this->Reserve(EventIndex<T>::Value, sizeof(T));
+			if (!record)
+				return false;
+
+			std::memcpy(reinterpret_cast<U8*>(record + 1), &event, sizeof(T));
+			record->committed.store(1, std::memory_order_release);
+			return true;
+		}
+
+		// Swaps the queues and delivers everything posted since the last
+		// call, grouped by event type and in posted order within a type.
+		// Events posted by the handlers are delivered next time.
+		void DispatchQueued();
 
-		void Subscribe(RawStringPtr eventName, EventHandler function);
-		bool Fire(RawStringPtr eventName, void const* argument = nullptr);
-	
 	private:
-		UnorderedMap<U32, Vector<EventHandler>> events_;
+		struct alignas(16) Block
+		{
+			U8 bytes[16];
+		};
+
+		// Precedes each posted event, which starts at the next block
+		struct alignas(16) Record
+		{
+			std::atomic<U32> committed;
+			U32 index;
+			// Blocks used by the record, including this header
+			U32 blocks;
+		};
+
+		static_assert(sizeof(Record) == sizeof(Block), "Record header must fill one block");
+
+		Record* Reserve(U32 index, size_t size);
+
+		void BindConsole();
+		// Times dispatch through delegates against std::function
+		void Benchmark(U32 iterations);
+
+		// Each slot only ever holds handlers of the event type listed at
+		// its position in Events
+		typedef util::Delegate<bool (void const*)> Handler;
+		Array<util::DelegateList<bool (void const*)>, Events::Count> handlers_;
+
+		// The top bit selects the queue producers write to; the rest is the
+		// write position in blocks. Keeping both in one word means that a
+		// reservation lands entirely before or after a swap.
+		std::atomic<U64> writeState_;
+		Array<Vector<Block>, 2> queues_;
+
+		// Block offsets of the records being dispatched, per event type
+		Array<Vector<U32>, Events::Count> batches_;
 	};
 }
\ No newline at end of file
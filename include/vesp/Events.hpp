@@ -0,0 +1,103 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/util/ConstHash.hpp"
+
+#include <tuple>
+#include <type_traits>
+
+// Declares the ID of an event type, hashed from its name at compile time
+#define VESP_EVENT(name) \
+	static const vesp::U32 Id = vesp::util::ConstHash(name); \
+	static vesp::RawStringPtr GetName() { return name; }
+
+namespace vesp
+{
+	// Event types double as their payloads; fields added to a struct are
+	// passed to its handlers by reference
+	namespace events
+	{
+		struct ConsoleReadyForBinding
+		{
+			VESP_EVENT("Console.ReadyForBinding")
+		};
+
+		struct EngineQuit
+		{
+			VESP_EVENT("Engine.Quit")
+		};
+
+		struct WindowFocus
+		{
+			VESP_EVENT("Window.Focus")
+		};
+
+		struct WindowUnfocus
+		{
+			VESP_EVENT("Window.Unfocus")
+		};
+
+		struct RenderGui
+		{
+			VESP_EVENT("Render.Gui")
+		};
+
+		// Posted by the asset workers once a file has been read and decoded
+		struct AssetDecoded
+		{
+			VESP_EVENT("Asset.Decoded")
+
+			// util::MurmurHash of the asset's path
+			U32 pathHash;
+			bool succeeded;
+		};
+	}
+
+	template <typename... Types>
+	struct EventList
+	{
+		static const U32 Count = sizeof...(Types);
+
+		template <U32 Index>
+		using At = typename std::tuple_element<Index, std::tuple<Types...>>::type;
+	};
+
+	// Position of the first type in the list with this ID, or the list's
+	// length when there is none
+	template <U32 Id, typename List>
+	struct EventIndexOf;
+
+	template <U32 Id, typename First, typename... Rest>
+	struct EventIndexOf<Id, EventList<First, Rest...>>
+	{
+		static const U32 Value = First::Id == Id ? 0 : 1 + EventIndexOf<Id, EventList<Rest...>>::Value;
+	};
+
+	template <U32 Id>
+	struct EventIndexOf<Id, EventList<>>
+	{
+		static const U32 Value = 0;
+	};
+
+	// Every event type, in the order of the dispatch table
+	typedef EventList<
+		events::ConsoleReadyForBinding,
+		events::EngineQuit,
+		events::WindowFocus,
+		events::WindowUnfocus,
+		events::RenderGui,
+		events::AssetDecoded
+	> Events;
+
+	// Dispatch table slot of an event type. Fails to compile for types that
+	// are not listed, or whose ID collides with an earlier event's.
+	template <typename T>
+	struct EventIndex
+	{
+		static const U32 Value = EventIndexOf<T::Id, Events>::Value;
+
+		static_assert(Value < Events::Count, "Event type is not listed in Events");
+		static_assert(std::is_same<Events::At<Value < Events::Count ? Value : 0>, T>::value,
+			"Event ID collides with another event; rename one of them");
+	};
+}
\ No newline at end of file
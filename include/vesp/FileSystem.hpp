@@ -62,9 +62,46 @@ namespace vesp
 			FILE* file_;
 		};
 
+		// Read-only view of a whole file mapped into memory. Pages are mapped
+		// copy-on-write, so the data may be modified without touching the file.
+		struct MappedFile
+		{
+		public:
+			friend class FileSystem;
+
+			MappedFile();
+			MappedFile(MappedFile&& rhs);
+			~MappedFile();
+
+			MappedFile(MappedFile const&) = delete;
+
+			MappedFile& operator=(MappedFile&& rhs);
+
+			ArrayView<U8> GetData();
+			size_t Size() const;
+			bool Exists() const;
+
+		private:
+			void* file_ = nullptr;
+			void* mapping_ = nullptr;
+			U8* data_ = nullptr;
+			size_t size_ = 0;
+		};
+
 		File Open(StringView fileName, Mode::Enum mode);
+		MappedFile Map(StringView fileName);
 
 		void Close(File& file);
+		void Unmap(MappedFile& file);
 		bool Exists(StringView fileName) const;
+
+		// Last write time in an opaque, monotonically increasing unit; 0 if
+		// the file does not exist.
+		U64 GetModifiedTime(StringView fileName) const;
+
+		// Succeeds if the directory already exists.
+		bool MakeDirectory(StringView path);
+		// Replaces the destination if it exists.
+		bool Rename(StringView from, StringView to);
 	};
 }
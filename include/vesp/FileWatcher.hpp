@@ -0,0 +1,70 @@
+#pragma once
+
+#include "vesp/util/GlobalSystem.hpp"
+#include "vesp/util/Timer.hpp"
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+
+#include <functional>
+
+struct _OVERLAPPED;
+
+namespace vesp
+{
+	// Watches a directory tree for changes to registered files. Change
+	// notifications come from the OS where possible; if those are not
+	// available, the modification times of the registered files are polled.
+	class FileWatcher : public util::GlobalSystem<FileWatcher>
+	{
+	public:
+		typedef std::function<void (StringView path)> Callback;
+
+		// Editors often write a file several times when saving it, so
+		// callbacks only run once a file has been quiet for this long.
+		static const U32 DebounceMilliseconds = 100;
+		static const U32 PollMilliseconds = 500;
+
+		FileWatcher(StringView root);
+		~FileWatcher();
+
+		// Paths are relative to the working directory and must lie below
+		// the root, e.g. "data/shaders/default.vsh".
+		void Watch(StringView path, Callback callback);
+		bool IsWatched(StringView path) const;
+
+		// Runs the callbacks of files that have changed.
+		void Pulse();
+
+	private:
+		struct WatchedFile
+		{
+			String path;
+			Vector<Callback> callbacks;
+			U64 modifiedTime = 0;
+			F32 changedAt = -1.0f;
+		};
+
+		// Windows paths are case-insensitive and accept either separator,
+		// so files are keyed by a lowercase path with forward slashes
+		String GetKey(StringView path) const;
+		void MarkChanged(StringView path);
+		void MarkAllChanged();
+
+		bool StartNotifications();
+		void StopNotifications();
+		bool QueueNotifications();
+		void ReadNotifications();
+		void PollModifiedTimes();
+
+		String root_;
+		UnorderedMap<String, WatchedFile> files_;
+		util::Timer clock_;
+		F32 lastPoll_ = 0.0f;
+
+		void* directory_ = nullptr;
+		UniquePtr<_OVERLAPPED> overlapped_;
+		Vector<U32> buffer_;
+	};
+}
\ No newline at end of file
@@ -6,6 +6,8 @@
 
 #include "vesp/math/Vector.hpp"
 
+#include "vesp/util/Delegate.hpp"
+
 struct tagMSG;
 
 #define ACTIONS \
@@ -34,12 +36,6 @@ namespace vesp
 	static const vesp::RawStringPtr ActionNames[] = { ACTIONS };
 #undef ACTION
 
-	class InputHandler 
-	{
-	public:
-		typedef void (InputHandler::*Function)(float state);
-	};
-
 	class InputManager : public util::GlobalSystem<InputManager>
 	{
 	public:
@@ -53,10 +49,15 @@ namespace vesp
 
 		void Pulse();
 
+		typedef util::Delegate<void (F32)> InputHandler;
+
+		util::Subscription Subscribe(Action action, InputHandler handler);
+		void Unsubscribe(util::Subscription subscription);
+
 		template <typename T>
-		void Subscribe(Action action, InputHandler* instance, void (T::*f)(float))
+		util::Subscription Subscribe(Action action, T* instance, void (T::*f)(float))
 		{
-			this->SubscribeInternal(action, instance, static_cast<InputHandler::Function>(f));
+			return this->Subscribe(action, [instance, f](F32 state) { (instance->*f)(state); });
 		}
 
 		void AddGuiLock();
@@ -64,7 +65,6 @@ namespace vesp
 		bool HasGuiLock();
 		
 	private:
-		void SubscribeInternal(Action action, InputHandler* instance, InputHandler::Function handler);
 		void ResetCursorToCentre();
 
 		void BindConsole();
@@ -72,16 +72,14 @@ namespace vesp
 
 		Array<U16, static_cast<U32>(Action::EndOfEnum)> state_;
 
-		struct Callback
-		{
-			InputHandler* instance;
-			InputHandler::Function handler;
-		};
-		Array<Vector<Callback>, static_cast<U32>(Action::EndOfEnum)> callbacks_;
+		Array<util::DelegateList<void (F32)>, static_cast<U32>(Action::EndOfEnum)> callbacks_;
 
 		U32 guiLockCount_ = 0;
 		util::Timer lastFrameTimer_;
 
+		util::Subscription bindConsoleSubscription_;
+		util::Subscription renderGuiSubscription_;
+
 		bool windowActive_ = false;
 	};
 }
@@ -1,10 +1,19 @@
 #pragma once
 
 #include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
 #include "vesp/FileSystem.hpp"
+#include "vesp/LogBinary.hpp"
 
 #include "vesp/util/GlobalSystem.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
 #define VESP_LOG_TYPES \
 	LOG_TYPE(Info), \
 	LOG_TYPE(Warn), \
@@ -21,16 +30,124 @@ namespace vesp
 	};
 #undef LOG_TYPE
 
-	class Logger : public util::GlobalSystem<Logger>
+	// Log calls format their message into a ring of records and return;
+	// a writer thread timestamps, batches and writes them out. Safe to
+	// call from any thread.
+	class Logger : public util::GlobalSystem<Logger, MemoryTag::Console>
 	{
 	public:
+		static const U32 MaxRecentLines = 64;
+		// Longer messages are truncated
+		static const U32 MaxMessageLength = 1000;
+		// Must be a power of two
+		static const U32 RecordCount = 1024;
+		// Written lines are flushed at least this often, and at once for
+		// errors
+		static const U32 FlushIntervalMs = 500;
+
 		Logger(RawStringPtr path);
 		~Logger();
 
 		void WriteLog(LogType type, RawStringPtr fmt, ...);
 
+		// Records the format, a timestamp and the arguments without
+		// formatting them. The format must be a string literal, and each
+		// argument an integer, float, pointer, C string or StringView;
+		// anything else fails to compile. Lines are formatted on the
+		// writer thread, or kept as they are in binary mode.
+		template <size_t N, typename... Args>
+		void WriteDeferred(LogType type, StringByte const (&fmt)[N], Args const&... args)
+		{
+			auto pos = this->Claim();
+			auto& record = this->records_[pos & (RecordCount - 1)];
+
+			record.time = GetTime();
+			record.type = type;
+			record.format = fmt;
+
+			LogArguments arguments(reinterpret_cast<U8*>(record.text), MaxMessageLength);
+			int expand[] = {0, (arguments.Add(args), 0)...};
+			(void)expand;
+			record.length = U16(arguments.GetSize());
+
+			this->Publish(pos, type);
+		}
+
+		// Blocks until every line logged so far is written and flushed.
+		// Fatal lines do this before returning.
+		void Flush();
+
+		// Hands lines the writer has finished to the console; called once
+		// per frame from the main thread
+		void Pulse();
+
+		// The last MaxRecentLines lines written, oldest first
+		Vector<String> GetRecentLines() const;
+
+		// Sends deferred lines to a binary log instead of the text log and
+		// console; decode it with log.decode
+		void SetBinaryMode(bool enabled);
+		// Called once the console exists
+		void BindConsole();
+
+		static RawStringPtr GetTypeName(LogType type);
+		// Microseconds since the Unix epoch
+		static U64 GetTime();
+
 	private:
+		struct Record
+		{
+			// Equal to the position of the record when it is free to be
+			// claimed, and one past it once its message is complete
+			std::atomic<U64> sequence;
+			U64 time;
+			LogType type;
+			// Set for deferred lines, whose text holds packed arguments
+			// of `length` bytes
+			RawStringPtr format;
+			U16 length;
+			StringByte text[MaxMessageLength];
+		};
+
+		struct Message
+		{
+			String text;
+			LogType type;
+		};
+
+		U64 Claim();
+		void Publish(U64 pos, LogType type);
+		void Wake(bool flush);
+		void WriterMain();
+		// Appends completed records to `batch`, after `writerError` if the
+		// writer has one to report; returns whether any of them needs
+		// flushing straight away
+		bool Drain(String& batch, RawStringPtr writerError);
+
 		FileSystem::File logFile_;
+
+		Vector<Record> records_;
+		std::atomic<U64> writePos_;
+		// Writer thread only
+		U64 readPos_ = 0;
+		UniquePtr<BinaryLog> binaryLog_;
+
+		std::atomic<bool> binaryMode_;
+
+		mutable std::mutex mutex_;
+		std::condition_variable wakeCondition_;
+		std::condition_variable writtenCondition_;
+		bool wakeRequested_ = false;
+		bool flushRequested_ = false;
+		bool quit_ = false;
+		U64 writtenPos_ = 0;
+		Deque<String> recentLines_;
+		Vector<Message> pendingMessages_;
+
+		// Main thread only; swapped with pendingMessages_ in Pulse
+		Vector<Message> consoleMessages_;
+
+		std::thread writer_;
 	};
 
 #define Log(type, fmt, ...) vesp::Logger::Get()->WriteLog(type, fmt, __VA_ARGS__)
@@ -39,4 +156,7 @@ namespace vesp
 #define LogError(fmt, ...) Log(vesp::LogType::Error, fmt, __VA_ARGS__)
 #define LogFatal(fmt, ...) Log(vesp::LogType::Fatal, fmt, __VA_ARGS__)
 
+#define LogDeferred(type, fmt, ...) vesp::Logger::Get()->WriteDeferred(type, fmt, __VA_ARGS__)
+#define LogInfoDeferred(fmt, ...) LogDeferred(vesp::LogType::Info, fmt, __VA_ARGS__)
+
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+#include "vesp/FileSystem.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+namespace vesp
+{
+	// Arguments of a deferred log call, packed as a type byte followed by
+	// the value. Integers and floats are widened to 64 bits; strings are
+	// copied with their terminator, since the caller's buffer may be gone
+	// by the time the line is formatted. Arguments that do not fit are
+	// dropped, and their conversions are left unformatted.
+	class LogArguments
+	{
+	public:
+		enum Type : U8
+		{
+			Signed,
+			Unsigned,
+			Float,
+			Pointer,
+			Text
+		};
+
+		LogArguments(U8* data, size_t capacity)
+			: data_(data), capacity_(capacity)
+		{
+		}
+
+		template <typename T>
+		typename std::enable_if<std::is_integral<T>::value>::type Add(T value)
+		{
+			if (std::is_signed<T>::value)
+				this->AddValue(Signed, S64(value));
+			else
+				this->AddValue(Unsigned, U64(value));
+		}
+
+		template <typename T>
+		typename std::enable_if<std::is_floating_point<T>::value>::type Add(T value)
+		{
+			this->AddValue(Float, F64(value));
+		}
+
+		template <typename T>
+		void Add(T* value)
+		{
+			this->AddValue(Pointer, U64(uintptr_t(value)));
+		}
+
+		void Add(RawStringPtr value);
+		void Add(StringByte* value);
+		void Add(StringView value);
+
+		size_t GetSize() const;
+
+		// Formats `fmt` as printf would with the packed arguments. Length
+		// modifiers are replaced to suit the packed types, and conversions
+		// that do not suit them are corrected, so `%d` with a 64-bit value
+		// is fine. `*` widths are not supported; pass a StringView to `%s`
+		// in place of `%.*s`. Returns the length written.
+		static size_t Format(StringByte* out, size_t capacity, RawStringPtr fmt, ArrayView<U8> arguments);
+
+	private:
+		template <typename T>
+		void AddValue(Type type, T value)
+		{
+			if (this->size_ + 1 + sizeof(T) > this->capacity_)
+				return;
+
+			this->data_[this->size_++] = type;
+			std::memcpy(this->data_ + this->size_, &value, sizeof(T));
+			this->size_ += sizeof(T);
+		}
+
+		void AddString(StringByte const* data, size_t length);
+
+		U8* data_;
+		size_t capacity_;
+		size_t size_ = 0;
+	};
+
+	// Binary logs start with this header, followed by tagged blocks.
+	// All integers after the header are LEB128 varints:
+	//   Format: 0, id, length, bytes
+	//   Line:   1, microseconds since the previous line (the first line
+	//           counts from the header's start time), type, format id,
+	//           argument length, then the arguments as packed by
+	//           LogArguments
+	// Formats are defined before the first line that uses them.
+	struct LogFileHeader
+	{
+		static const U32 Magic = 0x4C505356; // "VSPL"
+		static const U32 CurrentVersion = 1;
+
+		U32 magic;
+		U32 version;
+		// Microseconds since the Unix epoch
+		U64 startTime;
+	};
+
+	// Writes deferred log lines without formatting them; only used from
+	// the logger's writer thread
+	class BinaryLog
+	{
+	public:
+		BinaryLog(StringView path, U64 startTime);
+		~BinaryLog();
+
+		bool Exists() const;
+
+		void Add(U64 time, U8 type, RawStringPtr format, ArrayView<U8> arguments);
+		void Write(bool flush);
+
+		// Writes the lines of a binary log as text; returns false if it is
+		// missing or not a binary log
+		static bool Decode(StringView path, StringView outputPath);
+
+	private:
+		void WriteVarint(U64 value);
+		U32 GetFormatId(RawStringPtr format);
+
+		FileSystem::File file_;
+		Vector<U8> buffer_;
+		UnorderedMap<RawStringPtr, U32> formatIds_;
+		U64 lastTime_;
+	};
+}
\ No newline at end of file
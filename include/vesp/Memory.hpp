@@ -0,0 +1,158 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+namespace vesp
+{
+	// Subsystems that memory is attributed to
+	struct MemoryTag
+	{
+		enum Enum : U8
+		{
+			General,
+			Graphics,
+			Terrain,
+			ScalarField,
+			Script,
+			Lua,
+			Console,
+			Assets,
+			Profiler,
+			Count
+		};
+	};
+
+	// Counts live bytes, peak bytes and allocations per tag. Allocations
+	// are attributed to the innermost MemoryScope on the allocating thread
+	// and freed from the tag they were made under.
+	class MemoryTracker
+	{
+	public:
+		struct TagStats
+		{
+			U64 liveBytes;
+			U64 peakBytes;
+			U64 allocations;
+			// Allocations during the last frame
+			U64 frameAllocations;
+		};
+
+		static void* Allocate(size_t size, size_t alignment);
+		static void Free(void* ptr);
+
+		// For memory that is allocated elsewhere, like the Lua heap
+		static void SetLiveBytes(MemoryTag::Enum tag, U64 bytes);
+
+		static MemoryTag::Enum GetCurrentTag();
+		static RawStringPtr GetTagName(MemoryTag::Enum tag);
+		static TagStats GetStats(MemoryTag::Enum tag);
+
+		// Called once a frame from the main thread
+		static void EndFrame();
+		static void DrawTable();
+
+	private:
+		friend class MemoryScope;
+
+		// Padded so that threads allocating under different tags do not
+		// contend for a cache line
+		struct alignas(64) Tag
+		{
+			std::atomic<U64> liveBytes;
+			std::atomic<U64> peakBytes;
+			std::atomic<U64> allocations;
+			// Main thread only
+			U64 frameStart;
+			U64 frameAllocations;
+		};
+
+		static void AddLiveBytes(Tag& tag, U64 bytes);
+
+		static thread_local MemoryTag::Enum currentTag_;
+		static Tag tags_[MemoryTag::Count];
+	};
+
+	class MemoryScope
+	{
+	public:
+		MemoryScope(MemoryTag::Enum tag)
+			: previous_(MemoryTracker::currentTag_)
+		{
+			MemoryTracker::currentTag_ = tag;
+		}
+
+		~MemoryScope()
+		{
+			MemoryTracker::currentTag_ = this->previous_;
+		}
+
+		MemoryScope(MemoryScope const&) = delete;
+		MemoryScope& operator=(MemoryScope const&) = delete;
+
+	private:
+		MemoryTag::Enum previous_;
+	};
+
+	// Standard allocator over the tracker, used by the container aliases
+	template <typename T>
+	struct TrackedAllocator
+	{
+		typedef T value_type;
+
+		TrackedAllocator() = default;
+
+		template <typename Y>
+		TrackedAllocator(TrackedAllocator<Y> const&)
+		{
+		}
+
+		T* allocate(size_t count)
+		{
+			return static_cast<T*>(MemoryTracker::Allocate(count * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T* ptr, size_t)
+		{
+			MemoryTracker::Free(ptr);
+		}
+
+		template <typename Y>
+		bool operator==(TrackedAllocator<Y> const&) const
+		{
+			return true;
+		}
+
+		template <typename Y>
+		bool operator!=(TrackedAllocator<Y> const&) const
+		{
+			return false;
+		}
+	};
+
+	template<class T>
+	struct AlignedDeleter
+	{
+		void operator()(T* data) const
+		{
+			data->~T();
+			MemoryTracker::Free(data);
+		}
+	};
+
+	template <typename T>
+	using AlignedUniquePtr = UniquePtr<T, AlignedDeleter<T>>;
+
+	template <typename T, typename... Args>
+	AlignedUniquePtr<T> MakeAlignedUnique(Args&&... args)
+	{
+		auto ptr = reinterpret_cast<T*>(MemoryTracker::Allocate(sizeof(T), alignof(T)));
+		new (ptr) T(args...);
+		return AlignedUniquePtr<T> {ptr};
+	}
+}
+
+#define VESP_MEMORY_SCOPE(tag) vesp::MemoryScope MS##__LINE__(vesp::MemoryTag::tag)
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "vesp/util/GlobalSystem.hpp"
+#include "vesp/util/Timer.hpp"
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+
+#include <atomic>
+
+namespace vesp
+{
+	// A running count, cheap to bump from any thread. Define counters with
+	// static storage; each is reported per frame and as a total.
+	class Counter
+	{
+	public:
+		// Names are snake_case and exported with a vesp_ prefix
+		Counter(RawStringPtr name, RawStringPtr description);
+
+		void Add(U64 value = 1);
+
+	private:
+		friend class Metrics;
+		U32 index_;
+	};
+
+	// A value at a point in time; the last write wins
+	class Gauge
+	{
+	public:
+		Gauge(RawStringPtr name, RawStringPtr description);
+
+		void Set(F64 value);
+		F64 Get() const;
+
+	private:
+		std::atomic<F64> value_;
+	};
+
+	class Metrics : public util::GlobalSystem<Metrics, MemoryTag::Profiler>
+	{
+	public:
+		static const U32 MaxCounters = 256;
+
+		Metrics();
+
+		// Totals every thread's counts; called once per frame
+		void Pulse();
+		// Counter and gauge table for the profiler window
+		void DrawTable();
+
+		// Prometheus text exposition format
+		String Export();
+		// Written through a temporary file, so readers never see half of it
+		bool Dump(StringView path);
+
+	private:
+		// Each thread bumps its own slots with plain loads and stores; only
+		// Pulse reads them from elsewhere. Blocks live for the whole run, so
+		// counts from threads that have exited are kept.
+		struct ThreadCounters
+		{
+			Array<std::atomic<U64>, MaxCounters> values;
+			std::atomic<bool> owned;
+			ThreadCounters* next;
+		};
+
+		friend class Counter;
+		friend class Gauge;
+
+		static U32 RegisterCounter(RawStringPtr name, RawStringPtr description);
+		static void RegisterGauge(Gauge const* gauge, RawStringPtr name, RawStringPtr description);
+
+		static std::atomic<U64>& GetThreadSlot(U32 index);
+		static ThreadCounters* RegisterThread();
+
+		static thread_local ThreadCounters* threadCounters_;
+		static std::atomic<ThreadCounters*> threads_;
+
+		Array<U64, MaxCounters> totals_;
+		Array<U64, MaxCounters> frameValues_;
+
+		String exportPath_;
+		F32 exportInterval_ = 0.0f;
+		util::Timer exportTimer_;
+	};
+
+	inline std::atomic<U64>& Metrics::GetThreadSlot(U32 index)
+	{
+		auto counters = threadCounters_;
+		if (!counters)
+			counters = RegisterThread();
+
+		return counters->values[index];
+	}
+
+	inline void Counter::Add(U64 value)
+	{
+		// Only this thread writes the slot, so no read-modify-write is needed
+		auto& slot = Metrics::GetThreadSlot(this->index_);
+		slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	inline void Gauge::Set(F64 value)
+	{
+		this->value_.store(value, std::memory_order_relaxed);
+	}
+
+	inline F64 Gauge::Get() const
+	{
+		return this->value_.load(std::memory_order_relaxed);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+#include "vesp/FileSystem.hpp"
+#include "vesp/ProfileCounters.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace vesp
+{
+	// One begin or end of a profiled section. A null title marks the end
+	// of the innermost open section.
+	struct ProfileRecord
+	{
+		RawStringPtr title;
+		U64 time;
+	};
+
+	// Binary captures start with this header, followed by tagged blocks.
+	// All integers after the header are LEB128 varints:
+	//   String: 0, id, length, bytes
+	//   Thread: 1, lane, name string id (0 when unnamed)
+	//   Frame:  2, start, duration, main thread lane
+	//   Events: 3, lane, count, then per event the title string id (0 for
+	//           an end) and the ticks since the lane's previous event
+	//   Counters: 4, title string id, calls, mask of the events available,
+	//           then the frame's count of each available event
+	// Times are in ticks since the start of the first captured frame.
+	struct ProfileCaptureHeader
+	{
+		static const U32 Magic = 0x43505356; // "VSPC"
+		static const U32 CurrentVersion = 3;
+
+		U32 magic;
+		U32 version;
+		F64 secondsPerTick;
+	};
+
+	// Writes a fixed number of frames to disk from its own thread, so
+	// frames only pay for copying their records.
+	class ProfileCapture
+	{
+	public:
+		enum class Format
+		{
+			// Chrome trace event JSON, which Perfetto also loads
+			Json,
+			Binary
+		};
+
+		struct Lane
+		{
+			U32 id;
+			RawStringPtr name;
+			// Leading begins of sections that were open at the previous
+			// frame's end; only written for the first frame
+			U32 carried;
+			Vector<ProfileRecord> records;
+		};
+
+		struct Frame
+		{
+			U64 start;
+			U64 end;
+			U32 mainLane;
+			Vector<Lane> lanes;
+			Vector<ProfileSectionCounters> counters;
+		};
+
+		ProfileCapture(StringView path, Format format, U32 frameCount, F64 secondsPerTick);
+		// Waits for every queued frame to be written
+		~ProfileCapture();
+
+		bool IsOpen() const;
+		RawStringPtr GetPath() const;
+		// Frames still to be pushed
+		U32 GetRemaining() const;
+		// True once every frame has been written
+		bool IsDone() const;
+
+		void Push(Frame&& frame);
+
+		// Converts a binary capture to the JSON format; returns false if it
+		// is missing or not a binary capture
+		static bool Decode(StringView path, StringView outputPath);
+
+	private:
+		void WriterMain();
+
+		void WriteJson(Frame const& frame);
+		void WriteBinary(Frame const& frame);
+		U32 GetFirstRecord(Lane const& lane) const;
+		void WriteVarint(U64 value);
+		U32 GetStringId(RawStringPtr string);
+		void Flush(bool force);
+
+		String path_;
+		Format format_;
+		U32 remaining_;
+		F64 secondsPerTick_;
+		FileSystem::File file_;
+
+		std::thread writer_;
+		std::mutex queueMutex_;
+		std::condition_variable queueCondition_;
+		Deque<Frame> queue_;
+		bool finished_ = false;
+		std::atomic<bool> done_;
+
+		// Writer thread only
+		Vector<U8> buffer_;
+		U64 base_ = 0;
+		U32 writtenFrames_ = 0;
+		UnorderedMap<RawStringPtr, U32> stringIds_;
+		UnorderedMap<U32, RawStringPtr> laneNames_;
+		UnorderedMap<U32, U64> laneTimes_;
+	};
+}
\ No newline at end of file
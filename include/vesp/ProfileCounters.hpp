@@ -0,0 +1,57 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+
+namespace vesp
+{
+	// Hardware event counts of the calling thread. Cycles are always
+	// available; the other events come from processor counters that have
+	// been configured for the system and assigned a slot with SetSlot.
+	// Events that could not be read are missing from `available`.
+	struct ProfileCounters
+	{
+		enum Event
+		{
+			Cycles,
+			Instructions,
+			L1Misses,
+			LLCMisses,
+			BranchMisses,
+			EventCount
+		};
+
+		static const U32 NoSlot = U32(-1);
+
+		Array<U64, EventCount> values;
+		U32 available;
+
+		static ProfileCounters Read();
+
+		static RawStringPtr GetEventName(U32 event);
+		// Returns EventCount when no event has this name
+		static U32 FindEvent(StringView name);
+		// Reads `event` from a hardware counter slot, or stops reading it
+		// when the slot is NoSlot. Threads pick this up on their next read.
+		static void SetSlot(U32 event, U32 slot);
+
+		bool Has(U32 event) const;
+		// Events per thousand instructions, or a negative value when either
+		// count is unavailable
+		F32 GetPerThousandInstructions(U32 event) const;
+		F32 GetInstructionsPerCycle() const;
+
+		// Both keep only the events available on each side
+		ProfileCounters& operator+=(ProfileCounters const& rhs);
+		ProfileCounters operator-(ProfileCounters const& rhs) const;
+	};
+
+	// Counts accumulated by one section over a number of calls
+	struct ProfileSectionCounters
+	{
+		RawStringPtr title;
+		U32 calls;
+		ProfileCounters counters;
+	};
+}
\ No newline at end of file
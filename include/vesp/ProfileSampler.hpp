@@ -0,0 +1,97 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace vesp
+{
+	// Periodically interrupts one thread and records its call stack,
+	// filed under the innermost profiler section open at the time. This
+	// covers code that has no profile blocks, such as Lua and vendored
+	// libraries. Samples are aggregated into a call tree per section.
+	class ProfileSampler
+	{
+	public:
+		static const U32 MaxFrames = 64;
+		// Bytes of the sampled thread's stack copied per sample; frames
+		// beyond this are cut off
+		static const U32 StackCopySize = 256 * 1024;
+
+		// The sampled thread's open sections, as it records them. They are
+		// only read while that thread is suspended.
+		struct SectionStack
+		{
+			RawStringPtr const* titles;
+			U32 const* depth;
+			U32 capacity;
+		};
+
+		// Samples the calling thread `frequency` times a second, up to 1000
+		ProfileSampler(U32 frequency, SectionStack sections);
+		~ProfileSampler();
+
+		bool IsRunning() const;
+		U32 GetSampleCount() const;
+
+		// Writes folded stacks ("section;caller;callee count" per line),
+		// which flamegraph.pl and speedscope read
+		bool Save(StringView path);
+		// Draws the flame graph of one section
+		void Draw();
+
+	private:
+		struct Node
+		{
+			U32 function;
+			U32 firstChild;
+			U32 nextSibling;
+			U32 count;
+		};
+
+		struct Tree
+		{
+			RawStringPtr section;
+			Vector<Node> nodes;
+			U32 depth;
+		};
+
+		void SamplerMain();
+		U32 CaptureStack(U64* frames, RawStringPtr& section);
+		void AddSample(RawStringPtr section, U32 const* functions, U32 count);
+		U32 GetFunction(U64 address);
+
+		void SaveNode(Tree const& tree, U32 index, String& prefix, String& output) const;
+		void DrawNode(Tree const& tree, U32 index, F32 x, F32 y, F32 width) const;
+
+		U32 frequency_;
+		SectionStack sections_;
+
+		void* thread_ = nullptr;
+		U64 stackBase_ = 0;
+		Vector<U8> stackCopy_;
+
+		std::thread sampler_;
+		std::atomic<bool> running_;
+		std::atomic<bool> quit_;
+
+		// Guards the samples and function names; never held while the
+		// sampled thread is suspended
+		mutable std::mutex mutex_;
+		U32 sampleCount_ = 0;
+		Vector<Tree> trees_;
+		UnorderedMap<RawStringPtr, U32> treeIndices_;
+		Vector<String> functions_;
+
+		// Sampler thread only; keyed by function start and by address
+		UnorderedMap<U64, U32> functionIndices_;
+		UnorderedMap<U64, U32> addressFunctions_;
+
+		// Main thread only
+		U32 selectedTree_ = 0;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "vesp/ProfileCapture.hpp"
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+
+namespace vesp
+{
+	// Rolling statistics for every section, keyed by its call path: the
+	// lane it ran on and the titles of the sections enclosing it. Samples
+	// are the total time a path took within a frame.
+	class ProfileStats
+	{
+	public:
+		// Frames of history kept per path
+		static const U32 WindowSize = 1000;
+		// Power of two buckets from 1 us up
+		static const U32 BucketCount = 24;
+
+		struct Summary
+		{
+			U32 count;
+			F32 mean;
+			F32 min;
+			F32 max;
+			F32 p50;
+			F32 p95;
+			F32 p99;
+		};
+
+		struct Path
+		{
+			RawStringPtr title;
+			U32 lane;
+			U32 depth;
+
+			// Durations in seconds, oldest overwritten first
+			Array<F32, WindowSize> samples;
+			U32 sampleCount;
+			U32 nextSample;
+			Array<U32, BucketCount> histogram;
+			F64 sum;
+
+			// Accumulated over the frame being added
+			F32 frameTotal;
+			U32 frameCalls;
+			U32 lastCalls;
+			U64 touchedFrame;
+		};
+
+		ProfileStats();
+
+		// Starts a frame; the main lane's sections are children of it
+		void BeginFrame(U32 mainLane, F32 frameSeconds);
+		// Feeds one lane's records for the frame. Sections are counted in
+		// the frame they end in; leading carried begins only rebuild paths.
+		void AddLane(U32 lane, ProfileRecord const* records, U32 count, F64 secondsPerTick);
+		// Commits a sample for every path seen during the frame
+		void EndFrame();
+
+		Summary Summarise(Path const& path);
+		Vector<Path const*> const& GetPaths() const;
+
+		void Reset();
+
+	private:
+		static U64 GetRootPath(U32 lane);
+		static U64 GetChildPath(U64 parent, RawStringPtr title);
+
+		Path& GetPath(U64 key, RawStringPtr title, U32 lane, U32 depth);
+		void AddTime(Path& path, F32 seconds);
+		void AddSample(Path& path, F32 seconds);
+
+		UnorderedMap<U64, Path> paths_;
+		// First seen order, which keeps children below their parents
+		Vector<Path const*> order_;
+		Vector<Path*> touched_;
+		Vector<F32> scratch_;
+
+		U64 frameIndex_ = 0;
+		U32 mainLane_ = 0;
+		U64 framePath_ = 0;
+	};
+}
\ No newline at end of file
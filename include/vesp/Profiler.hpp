@@ -1,59 +1,270 @@
 #pragma once
 
+#include "vesp/util/Delegate.hpp"
 #include "vesp/util/GlobalSystem.hpp"
 #include "vesp/util/Timer.hpp"
 
 #include "vesp/Containers.hpp"
+#include "vesp/ProfileCapture.hpp"
+#include "vesp/ProfileCounters.hpp"
+#include "vesp/ProfileSampler.hpp"
+#include "vesp/ProfileStats.hpp"
+#include "vesp/Types.hpp"
+
+#include <atomic>
+#include <mutex>
 
 namespace vesp
 {
-	class Profiler : public util::GlobalSystem<Profiler>
+	class Profiler : public util::GlobalSystem<Profiler, MemoryTag::Profiler>
 	{
 	public:
+		// Records buffered per thread between frame ends; must be a power of
+		// two. Sections past this are dropped, not reallocated for.
+		static const U32 ThreadCapacity = 16384;
+
 		Profiler();
+		~Profiler();
 
+		// Names the calling thread's timeline lane. Can be called before the
+		// profiler exists.
+		static void SetThreadName(RawStringPtr name);
+
+		// Safe to call from any thread
 		void BeginSection(RawStringPtr title);
 		void EndSection();
 
+		// Safe to call from any thread; adds to this frame's totals for the
+		// section
+		void AddCounters(RawStringPtr title, ProfileCounters const& counters);
+
+		// Called from the main thread; collects every thread's sections
 		void BeginFrame();
 		void EndFrame();
 
 	private:
-		void Draw();
+		// Capture only appends these, the section tree is built on demand
+		typedef ProfileRecord Record;
+
+		// Open section titles kept for the sampler, which files samples
+		// under the innermost one
+		static const U32 SampledDepth = 32;
+
+		// A single producer ring written by its thread and drained at each
+		// frame end. Buffers are never freed while the profiler lives; a
+		// thread that exits hands its buffer to the next one to register.
+		struct ThreadBuffer
+		{
+			Vector<Record> records;
+			std::atomic<U32> write;
+			std::atomic<U32> read;
+			std::atomic<U32> dropped;
+			std::atomic<bool> owned;
+			std::atomic<RawStringPtr> name;
+			ThreadBuffer* next;
+			U32 id;
 
+			// Owning thread only, or while it is suspended
+			U32 openSections;
+			U32 droppedDepth;
+			Array<RawStringPtr, SampledDepth> openTitles;
+
+			// Frame end only: sections still open at the last drain, and the
+			// records of the two frames
+			Vector<Record> open;
+			Array<Vector<Record>, 2> frames;
+			Array<U32, 2> counts;
+			Array<U32, 2> carried;
+			Array<U32, 2> droppedCounts;
+		};
+
+		struct Frame
+		{
+			U64 start;
+			U64 end;
+		};
+
+		// Sections in depth-first order; a section's children follow it and
+		// its subtree spans `size` entries
 		struct Section
 		{
 			RawStringPtr title;
-			Section* parent;
-	
-			util::Timer timer;
-			Vector<UniquePtr<Section>> children;
+			F32 duration;
+			U32 parent;
+			U32 size;
+		};
 
+		// A frame over the hitch threshold, kept with the log leading up to it
+		struct Hitch
+		{
+			U64 frame;
 			F32 duration;
+			Vector<Section> sections;
+			Vector<String> log;
 		};
 
-		void DrawSection(Section* section);
+		static const U32 MaxHitches = 16;
+
+		static U64 GetTime();
+
+		ThreadBuffer* RegisterThread();
+		void Drain(ThreadBuffer& buffer, U32 frame);
+
+		void StartCapture(ProfileCapture::Format format, U32 frameCount);
+		void StartSampling(U32 frequency);
+		void SaveSamples();
+		void UpdateCaptures();
+
+		void UpdateStats(F32 frameSeconds);
+		void UpdateCounters();
+		void RecordHitch(F32 frameSeconds);
+
+		void BuildSections(ThreadBuffer const& buffer, U32 frame, Vector<Section>& sections);
+		void Draw();
+		void DrawTimeline(U32 frame);
+		void DrawStats();
+		void DrawCounters();
+		void DrawHitches();
+		void DrawSection(Vector<Section> const& sections, U32 index);
+
+		static thread_local ThreadBuffer* threadBuffer_;
+
+		// Registration list, pushed to from any thread
+		std::atomic<ThreadBuffer*> threads_;
+		std::atomic<U32> threadCount_;
+		// Main thread copy of the list, ordered by registration
+		Vector<ThreadBuffer*> lanes_;
+		ThreadBuffer* mainThread_ = nullptr;
+
+		Array<Frame, 2> frames_;
+		U32 currentFrame_ = 0;
+
+		Vector<UniquePtr<ProfileCapture>> captures_;
+		UniquePtr<ProfileSampler> sampler_;
+
+		ProfileStats stats_;
+		U64 frameIndex_ = 0;
+		// In milliseconds; 0 disables hitch detection
+		F32 hitchThreshold_ = 50.0f;
+		Deque<Hitch> hitches_;
+
+		std::mutex countersMutex_;
+		Vector<ProfileSectionCounters> pendingCounters_;
+		// Main thread only: the last frame's counters and those since the
+		// statistics were reset
+		Vector<ProfileSectionCounters> frameCounters_;
+		Vector<ProfileSectionCounters> counterTotals_;
+
+		Vector<Section> sections_;
+		Vector<U32> sectionStack_;
+		bool sectionsValid_ = false;
+		F64 secondsPerTick_;
+
+		util::Subscription renderGuiSubscription_;
 
-		UniquePtr<Section> savedRoot_;
-		UniquePtr<Section> root_;
-		Section* currentSection_ = nullptr;
 		bool drawGui_ = false;
 		bool frozen_ = false;
 	};
 
+	inline U64 Profiler::GetTime()
+	{
+		return util::CycleClock::Now();
+	}
+
+	inline void Profiler::BeginSection(RawStringPtr title)
+	{
+		auto buffer = threadBuffer_;
+		if (!buffer)
+			buffer = this->RegisterThread();
+
+		// Once a section is dropped, everything nested in it is dropped too;
+		// otherwise an inner begin that fits after the ring drains would
+		// take the outer section's end
+		if (buffer->droppedDepth)
+		{
+			++buffer->droppedDepth;
+			buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		// Always leave room for the ends of the sections already open
+		auto write = buffer->write.load(std::memory_order_relaxed);
+		auto used = write - buffer->read.load(std::memory_order_acquire);
+		if (used + buffer->openSections + 2 > ThreadCapacity)
+		{
+			++buffer->droppedDepth;
+			buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		if (buffer->openSections < SampledDepth)
+			buffer->openTitles[buffer->openSections] = title;
+
+		buffer->records[write & (ThreadCapacity - 1)] = {title, GetTime()};
+		buffer->write.store(write + 1, std::memory_order_release);
+		++buffer->openSections;
+	}
+
+	inline void Profiler::EndSection()
+	{
+		auto buffer = threadBuffer_;
+		if (buffer->droppedDepth)
+		{
+			--buffer->droppedDepth;
+			return;
+		}
+
+		auto write = buffer->write.load(std::memory_order_relaxed);
+		buffer->records[write & (ThreadCapacity - 1)] = {nullptr, GetTime()};
+		buffer->write.store(write + 1, std::memory_order_release);
+		--buffer->openSections;
+	}
+
 	struct ProfileBlock
 	{
+		// Threads can outlive the profiler, or start before it exists
 		ProfileBlock(RawStringPtr title)
+			: profiler_(Profiler::Get())
 		{
-			Profiler::Get()->BeginSection(title);
+			if (this->profiler_)
+				this->profiler_->BeginSection(title);
 		}
 
 		~ProfileBlock()
 		{
-			Profiler::Get()->EndSection();
+			if (this->profiler_)
+				this->profiler_->EndSection();
 		}
+
+	private:
+		Profiler* profiler_;
+	};
+
+	// A profile block that also reads the hardware counters, for the few
+	// sections worth the cost of reading them twice per call
+	struct ProfileCountedBlock
+	{
+		ProfileCountedBlock(RawStringPtr title)
+			: block_(title), profiler_(Profiler::Get()), title_(title)
+		{
+			if (this->profiler_)
+				this->start_ = ProfileCounters::Read();
+		}
+
+		~ProfileCountedBlock()
+		{
+			if (this->profiler_)
+				this->profiler_->AddCounters(this->title_, ProfileCounters::Read() - this->start_);
+		}
+
+	private:
+		ProfileBlock block_;
+		Profiler* profiler_;
+		RawStringPtr title_;
+		ProfileCounters start_;
 	};
 }
 
 #define VESP_PROFILE_BLOCK(title) vesp::ProfileBlock PB##__LINE__(title)
-#define VESP_PROFILE_FN() VESP_PROFILE_BLOCK(__FUNCTION__)
\ No newline at end of file
+#define VESP_PROFILE_FN() VESP_PROFILE_BLOCK(__FUNCTION__)
+#define VESP_PROFILE_COUNTERS(title) vesp::ProfileCountedBlock PCB##__LINE__(title)
\ No newline at end of file
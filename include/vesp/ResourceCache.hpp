@@ -0,0 +1,203 @@
+#pragma once
+
+#include "vesp/util/GlobalSystem.hpp"
+
+#include "vesp/AssetLoader.hpp"
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+#include "vesp/Assert.hpp"
+
+#include <functional>
+
+namespace vesp
+{
+	// Unique address per resource type, used to check handle casts.
+	template <typename T>
+	void const* GetResourceType()
+	{
+		static const U8 Tag = 0;
+		return &Tag;
+	}
+
+	enum class ResourceState : U8
+	{
+		Loading,
+		Ready,
+		Failed
+	};
+
+	struct ResourceEntry
+	{
+		U32 key;
+		String path;
+		void const* type;
+
+		std::shared_ptr<void> resource;
+		size_t size = 0;
+		U32 refCount = 0;
+		ResourceState state = ResourceState::Loading;
+
+		// Callbacks from every Load made while the resource was in flight
+		Vector<std::function<void (void*)>> callbacks;
+
+		// Resident entries without references form an intrusive LRU list
+		ResourceEntry* lruPrev = nullptr;
+		ResourceEntry* lruNext = nullptr;
+	};
+
+	// Type-erased, reference counted handle to a cached resource. A resource
+	// can only be evicted once no handles refer to it.
+	class ResourceHandle
+	{
+	public:
+		friend class ResourceCache;
+
+		ResourceHandle();
+		ResourceHandle(ResourceHandle const& rhs);
+		ResourceHandle(ResourceHandle&& rhs);
+		~ResourceHandle();
+
+		ResourceHandle& operator=(ResourceHandle rhs);
+
+		bool IsValid() const;
+		bool IsReady() const;
+		bool HasFailed() const;
+		StringView GetPath() const;
+
+		// Returns null until the resource is ready.
+		template <typename T>
+		T* Get() const
+		{
+			VESP_ASSERT(this->IsValid());
+			VESP_ASSERT(this->entry_->type == GetResourceType<T>());
+			return static_cast<T*>(this->entry_->resource.get());
+		}
+
+	private:
+		explicit ResourceHandle(ResourceEntry* entry);
+
+		ResourceEntry* entry_ = nullptr;
+	};
+
+	// Deduplicates loads through the asset loader. Repeated loads of a path,
+	// including ones made while the first is still in flight, share a single
+	// entry. Entries are bucketed by the hash of the path and matched on the
+	// full path and type, so colliding paths each get their own entry.
+	class ResourceCache : public util::GlobalSystem<ResourceCache, MemoryTag::Assets>
+	{
+	public:
+		static const size_t DefaultBudget = 256 * 1024 * 1024;
+
+		ResourceCache(size_t budget = DefaultBudget);
+		~ResourceCache();
+
+		// The callback runs on the main thread once the resource is ready, or
+		// immediately if it already is. The size of a resource defaults to
+		// sizeof(T) and is measured after the callbacks of the first load.
+		template <typename T>
+		ResourceHandle Load(StringView path, 
+			std::function<bool (ArrayView<U8>, T&)> decoder,
+			std::function<void (T&)> callback = nullptr,
+			std::function<size_t (T const&)> sizeOf = nullptr)
+		{
+			auto key = util::MurmurHash(path);
+
+			auto entry = this->Find(key, path, GetResourceType<T>());
+			if (entry)
+			{
+				++this->hits_;
+
+				ResourceHandle handle(entry);
+				if (callback && entry->state == ResourceState::Ready)
+					callback(*static_cast<T*>(entry->resource.get()));
+				else if (callback && entry->state == ResourceState::Loading)
+					entry->callbacks.push_back(WrapCallback(std::move(callback)));
+
+				return handle;
+			}
+
+			++this->misses_;
+			entry = this->Insert(key, path, GetResourceType<T>());
+
+			ResourceHandle handle(entry);
+			if (callback)
+				entry->callbacks.push_back(WrapCallback(std::move(callback)));
+
+			AssetLoader::Get()->Load<std::shared_ptr<T>>(path,
+				[decoder](ArrayView<U8> data, std::shared_ptr<T>& resource)
+				{
+					resource = std::make_shared<T>();
+					return decoder(data, *resource);
+				},
+				[this, entry, sizeOf](std::shared_ptr<T>& resource)
+				{
+					auto measure = [resource, sizeOf]
+					{
+						return sizeOf ? sizeOf(*resource) : sizeof(T);
+					};
+
+					this->Complete(entry, std::move(resource), measure);
+				},
+				[this, entry]
+				{
+					this->Fail(entry);
+				});
+
+			return handle;
+		}
+
+		void SetBudget(size_t budget);
+		size_t GetBudget() const;
+		size_t GetUsage() const;
+
+		// Evicts unreferenced resources until usage is within the budget.
+		void Trim();
+
+	private:
+		friend class ResourceHandle;
+
+		template <typename T>
+		static std::function<void (void*)> WrapCallback(std::function<void (T&)> callback)
+		{
+			return [callback](void* resource)
+			{
+				callback(*static_cast<T*>(resource));
+			};
+		}
+
+		ResourceEntry* Find(U32 key, StringView path, void const* type);
+		ResourceEntry* Insert(U32 key, StringView path, void const* type);
+		// Removes the entry from its bucket, returning ownership of it
+		UniquePtr<ResourceEntry> Detach(ResourceEntry* entry);
+		void Erase(ResourceEntry* entry);
+
+		// Loading entries are never erased, so the loader's callbacks can
+		// hold on to them directly
+		void Complete(ResourceEntry* entry, std::shared_ptr<void> resource, std::function<size_t ()> measure);
+		void Fail(ResourceEntry* entry);
+
+		void AddReference(ResourceEntry* entry);
+		void RemoveReference(ResourceEntry* entry);
+
+		void LinkLru(ResourceEntry* entry);
+		void UnlinkLru(ResourceEntry* entry);
+
+		void LogStats();
+
+		UnorderedMap<U32, Vector<UniquePtr<ResourceEntry>>> entries_;
+		// Failed entries that handles still refer to; they are no longer
+		// found by Load
+		Vector<UniquePtr<ResourceEntry>> failed_;
+
+		ResourceEntry* lruHead_ = nullptr;
+		ResourceEntry* lruTail_ = nullptr;
+
+		size_t budget_;
+		size_t usage_ = 0;
+
+		U32 hits_ = 0;
+		U32 misses_ = 0;
+		U32 evictions_ = 0;
+	};
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "vesp/Containers.hpp"
 #include "vesp/util/MurmurHash.hpp"
 
+#include <cstring>
 #include <string>
 
 namespace vesp 
@@ -23,6 +24,11 @@ namespace vesp
 		{
 		}
 
+		StringView(Vector<StringByte> const& s)
+			: ArrayView(const_cast<StringByte*>(s.data()), s.size())
+		{
+		}
+
 		using ArrayView::ArrayView;
 	};
 
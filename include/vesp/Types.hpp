@@ -47,27 +47,10 @@ namespace vesp
 	template <typename T, typename... Args>
 	using UniquePtr = std::unique_ptr<T, Args...>;
 
-	template<class T>
-	struct AlignedDeleter
-	{
-		void operator()(T* data) const
-		{
-			data->~T();
-			_aligned_free(data);
-		}
-	};
-
-	template <typename T>
-	using AlignedUniquePtr = UniquePtr<T, AlignedDeleter<T>>;
-
-	template <typename T, typename... Args>
-	AlignedUniquePtr<T> MakeAlignedUnique(Args&&... args)
-	{
-		auto ptr = reinterpret_cast<T*>(_aligned_malloc(sizeof(T), alignof(T)));
-		new (ptr) T(args...);
-		return AlignedUniquePtr<T> {ptr};
-	}
 }
 
+// Aligned allocation helpers live with the memory tracker
+#include "vesp/Memory.hpp"
+
 #define UniquePtrWithDeleter(T, ptr, deleter) \
-	std::unique_ptr<T, decltype(&(deleter))>((ptr), &(deleter))
\ No newline at end of file
+	std::unique_ptr<T, decltype(&(deleter))>((ptr), &(deleter))
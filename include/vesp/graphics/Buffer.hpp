@@ -4,6 +4,7 @@
 #include "vesp/Containers.hpp"
 #include "vesp/Log.hpp"
 #include "vesp/Assert.hpp"
+#include "vesp/Metrics.hpp"
 
 #include "vesp/graphics/Vertex.hpp"
 #include "vesp/graphics/Engine.hpp"
@@ -14,18 +15,46 @@
 #include <d3d11.h>
 #pragma warning(pop)
 
+#include <algorithm>
+
 namespace vesp { namespace graphics {
 
+	// Bytes copied into GPU buffers, at creation and by dynamic updates
+	extern Counter UploadedBufferBytes;
+
 	template <typename T>
 	class Buffer
 	{
 	public:
 		bool Create(ArrayView<T> const array, U32 bindFlags, D3D11_USAGE usage = D3D11_USAGE_DEFAULT)
+		{
+			return this->CreateFrom(array, bindFlags, usage);
+		}
+
+		ID3D11Buffer* Get()
+		{
+			return this->buffer_;
+		}
+
+		U32 GetCount()
+		{
+			return this->count_;
+		}
+
+		bool Initialized()
+		{
+			return GetCount() > 0;
+		}
+
+	protected:
+		// Allows derived buffers to store elements of a different type to T
+		template <typename Y>
+		bool CreateFrom(ArrayView<Y> const array, U32 bindFlags, D3D11_USAGE usage)
 		{
 			D3D11_BUFFER_DESC desc;
 			ZeroMemory(&desc, sizeof(desc));
 			desc.Usage = usage;
-			desc.ByteWidth = sizeof(T) * array.size();
+			desc.ByteWidth = sizeof(Y) * array.size();
 			desc.BindFlags = bindFlags;
 			desc.CPUAccessFlags = 
 				bindFlags == D3D11_BIND_CONSTANT_BUFFER ? D3D11_CPU_ACCESS_WRITE : 0;
@@ -45,26 +74,11 @@ namespace vesp { namespace graphics {
 			}
 
 			this->count_ = array.size();
+			UploadedBufferBytes.Add(desc.ByteWidth);
 
 			return true;
 		}
 
-		ID3D11Buffer* Get()
-		{
-			return this->buffer_;
-		}
-
-		U32 GetCount()
-		{
-			return this->count_;
-		}
-
-		bool Initialized()
-		{
-			return GetCount() > 0;
-		}
-
-	protected:
 		CComPtr<ID3D11Buffer> buffer_;
 		U32 count_ = 0;
 	};
@@ -81,8 +95,12 @@ namespace vesp { namespace graphics {
 	{
 	public:
 		bool Create(ArrayView<U32> const array, D3D11_USAGE usage = D3D11_USAGE_DEFAULT);
+		bool Create(ArrayView<U16> const array, D3D11_USAGE usage = D3D11_USAGE_DEFAULT);
 
 		void Use();
+
+	private:
+		DXGI_FORMAT format_ = DXGI_FORMAT_R32_UINT;
 	};
 
 	template <typename T>
@@ -125,8 +143,89 @@ namespace vesp { namespace graphics {
 		{
 			auto p = this->Map();
 			memcpy(p, array.data(), sizeof(T) * array.size());
+			UploadedBufferBytes.Add(sizeof(T) * array.size());
 			this->Unmap();
 		}
 	};
 
+	// Shader readable array rewritten from the CPU, typically every frame.
+	// Grows to fit whatever is loaded into it.
+	template <typename T>
+	class StructuredBuffer
+	{
+	public:
+		bool Load(ArrayView<T> const array)
+		{
+			auto count = std::max(U32(array.size()), 1u);
+			if (count > this->capacity_ && !this->Create(std::max(count, this->capacity_ * 2)))
+				return false;
+
+			if (array.size() == 0)
+				return true;
+
+			D3D11_MAPPED_SUBRESOURCE mappedSubresource;
+			auto hr = Engine::ImmediateContext->Map(
+				this->buffer_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedSubresource);
+			if (FAILED(hr))
+				return false;
+
+			memcpy(mappedSubresource.pData, array.data(), sizeof(T) * array.size());
+			Engine::ImmediateContext->Unmap(this->buffer_, 0);
+			UploadedBufferBytes.Add(sizeof(T) * array.size());
+
+			return true;
+		}
+
+		void UsePS(U32 slot)
+		{
+			Engine::ImmediateContext->PSSetShaderResources(slot, 1, &this->view_.p);
+		}
+
+	private:
+		bool Create(U32 capacity)
+		{
+			this->view_.Release();
+			this->buffer_.Release();
+			this->capacity_ = 0;
+
+			D3D11_BUFFER_DESC desc;
+			ZeroMemory(&desc, sizeof(desc));
+			desc.Usage = D3D11_USAGE_DYNAMIC;
+			desc.ByteWidth = sizeof(T) * capacity;
+			desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+			desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+			desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+			desc.StructureByteStride = sizeof(T);
+
+			auto hr = Engine::Device->CreateBuffer(&desc, nullptr, &this->buffer_);
+			if (FAILED(hr))
+			{
+				LogError("Failed to create structured buffer (count: %u, error: %X)", capacity, hr);
+				return false;
+			}
+
+			D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
+			ZeroMemory(&viewDesc, sizeof(viewDesc));
+			viewDesc.Format = DXGI_FORMAT_UNKNOWN;
+			viewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+			viewDesc.Buffer.FirstElement = 0;
+			viewDesc.Buffer.NumElements = capacity;
+
+			hr = Engine::Device->CreateShaderResourceView(this->buffer_, &viewDesc, &this->view_);
+			if (FAILED(hr))
+			{
+				LogError("Failed to create structured buffer view (error: %X)", hr);
+				this->buffer_.Release();
+				return false;
+			}
+
+			this->capacity_ = capacity;
+			return true;
+		}
+
+		CComPtr<ID3D11Buffer> buffer_;
+		CComPtr<ID3D11ShaderResourceView> view_;
+		U32 capacity_ = 0;
+	};
+
 } }
\ No newline at end of file
@@ -10,6 +10,15 @@
 
 namespace vesp { namespace graphics {
 
+	struct StereoEye
+	{
+		Mat4 view;
+		Mat4 projection;
+		Mat4 viewProjection;
+		// View space x translation from the camera to the eye
+		F32 offset;
+	};
+
 	class Camera
 	{
 	public:
@@ -20,6 +29,27 @@ namespace vesp { namespace graphics {
 
 		Mat4 const& GetView();
 		Mat4 const& GetProjection();
+		Mat4 const& GetViewProjection();
+
+		// Vertical, in degrees
+		F32 GetFieldOfView() const;
+		F32 GetAspectRatio() const;
+		F32 GetNearPlane() const;
+		F32 GetFarPlane() const;
+
+		// Side by side stereo. Both eyes share the camera's orientation, are
+		// offset along its x axis and get half of the target each. Meshes are
+		// drawn once with an instance per eye.
+		void SetStereo(bool enabled);
+		bool IsStereo() const;
+		void SetEyeSeparation(F32 separation);
+
+		U32 GetEyeCount() const;
+		// In mono both eyes match the camera
+		StereoEye const& GetEye(U32 eye);
+
+		// Encloses the frustums of every eye, so culling only happens once
+		Mat4 const& GetCullingViewProjection();
 
 		void* operator new(size_t i);
 		void operator delete(void* p);
@@ -28,9 +58,13 @@ namespace vesp { namespace graphics {
 		struct PerFrameConstants
 		{
 			Mat4 viewProjection;
+			Mat4 eyeViewProjection[2];
+			U32 eyeCount;
+			U32 padding[3];
 		};
 
 		void CalculateMatrices();
+		void CalculateEyes();
 		PerFrameConstants MakeConstants();
 
 		float fov_;
@@ -42,6 +76,11 @@ namespace vesp { namespace graphics {
 		Mat4 projection_;
 		Mat4 viewProjection_;
 
+		bool stereo_ = false;
+		F32 eyeSeparation_ = 0.064f;
+		Array<StereoEye, 2> eyes_;
+		Mat4 cullingViewProjection_;
+
 		ConstantBuffer<PerFrameConstants> constantBuffer_;
 	};
 
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "vesp/graphics/Buffer.hpp"
+#include "vesp/graphics/LightCuller.hpp"
+
+namespace vesp { namespace graphics {
+
+	class Camera;
+
+	// Owns the scene's point lights and feeds the composite pass. Lights are
+	// binned on the CPU every frame and uploaded as three structured buffers:
+	// the lights in view space, a run of indices per cluster, and the indices.
+	class ClusteredLighting
+	{
+	public:
+		// Lights are only assigned up to this distance from the camera
+		static const U32 MaxLightDistance = 1000;
+
+		ClusteredLighting();
+
+		Vector<PointLight>& GetLights();
+
+		// Assigns lights for the camera's view and uploads the results
+		void Update(Camera& camera);
+		// Binds everything the composite shader reads
+		void Use();
+
+	private:
+		struct LightingConstants
+		{
+			Mat4 projection;
+			Mat4 inverseEyeProjection[2];
+			Vec4 eyeOffset;
+			F32 sliceScale;
+			F32 sliceBias;
+			U32 eyeCount;
+			U32 lightCount;
+			U32 clusterCounts[3];
+			U32 padding;
+		};
+
+		void LogStats();
+		void Benchmark(U32 lightCount);
+
+		Vector<PointLight> lights_;
+		LightCuller culler_;
+		F32 assignTime_ = 0.0f;
+
+		// Only rebuilt when the projection changes
+		Vec4 projectionParameters_;
+
+		StructuredBuffer<PointLight> lightBuffer_;
+		StructuredBuffer<LightCuller::Cluster> clusterBuffer_;
+		StructuredBuffer<U32> lightIndexBuffer_;
+		ConstantBuffer<LightingConstants> constantBuffer_;
+	};
+
+} }
\ No newline at end of file
@@ -23,8 +23,11 @@ namespace vesp { namespace graphics {
 	class Mesh;
 	class Window;
 	class Camera;
+	class TextureBuilder;
+	class OcclusionCuller;
+	class ClusteredLighting;
 
-	class Engine : public util::GlobalSystem<Engine>
+	class Engine : public util::GlobalSystem<Engine, MemoryTag::Graphics>
 	{
 	public:
 		Engine(RawStringPtr title);
@@ -38,6 +41,11 @@ namespace vesp { namespace graphics {
 		Window* GetWindow();
 		Camera* GetCamera();
 
+		// Whether the mesh intersects this frame's culling frustum and, if
+		// occlusion culling is on, is not hidden behind the occluders. Only
+		// valid while the scene is being drawn.
+		bool IsVisible(Mesh& mesh);
+
 		void SetBlendingEnabled(bool state);
 		void SetDepthEnabled(bool state);
 
@@ -52,12 +60,20 @@ namespace vesp { namespace graphics {
 		void CreateBlendState();
 		void CreateSamplerState();
 		void CreateTestData();
+		void AddCommands();
 
 		void DestroyDepthStencil();
 		void DestroyRenderTargets();
 
 		std::unique_ptr<Window> window_;
 		std::unique_ptr<Camera> camera_;
+		std::unique_ptr<TextureBuilder> textureBuilder_;
+		std::unique_ptr<OcclusionCuller> occlusionCuller_;
+		bool occlusionEnabled_ = true;
+		// Set for each frame before anything is drawn
+		Mat4 cullingViewProjection_;
+		bool occlusionActive_ = false;
+		std::unique_ptr<ClusteredLighting> lighting_;
 
 		// 0 - backbuffer
 		// 1 - diffuse
@@ -13,6 +13,8 @@ namespace vesp { namespace graphics {
 		U32 components;
 
 		static Image FromPath(StringView path);
+		// Decodes an encoded image; data is null on failure.
+		static Image FromMemory(ArrayView<U8> encoded);
 	};
 
 	static_assert(sizeof(Image) == 16, "Image size incorrect");
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+
+#include "vesp/math/Matrix.hpp"
+#include "vesp/math/Vector.hpp"
+
+namespace vesp { namespace graphics {
+
+	// Laid out to match the shader's structured buffer
+	struct PointLight
+	{
+		Vec3 position;
+		F32 radius;
+		Vec3 colour;
+		F32 intensity;
+	};
+
+	static_assert(sizeof(PointLight) == 32, "PointLight size is wrong");
+
+	// Bins point lights into froxels: screen tiles split into exponentially
+	// spaced depth slices. Each cluster ends up with a contiguous run of
+	// light indices, which is what the shader walks for a pixel.
+	//
+	// The bounds of each cluster are a view space box, tested against light
+	// spheres four clusters at a time. Lights only visit the clusters their
+	// projected bounds can touch.
+	class LightCuller
+	{
+	public:
+		static const U32 TilesX = 16;
+		static const U32 TilesY = 9;
+		static const U32 Slices = 24;
+		static const U32 ClusterCount = TilesX * TilesY * Slices;
+
+		struct Cluster
+		{
+			U32 offset;
+			U32 count;
+		};
+
+		LightCuller();
+
+		// Lights further than farPlane are ignored, and pixels beyond it use
+		// the last slice
+		void SetProjection(F32 fovY, F32 aspectRatio, F32 nearPlane, F32 farPlane);
+
+		// Lights are in world space. The results replace the previous ones.
+		void Assign(ArrayView<PointLight> lights, Mat4 const& view);
+
+		// The assigned lights, moved into view space
+		ArrayView<PointLight> GetViewLights();
+		ArrayView<Cluster> GetClusters();
+		ArrayView<U32> GetLightIndices();
+
+		// slice = log(viewZ) * scale + bias
+		F32 GetSliceScale() const;
+		F32 GetSliceBias() const;
+
+	private:
+		F32 GetSliceDepth(U32 slice) const;
+		void TestRow(U32 row, U32 firstTile, U32 lastTile, Vec4 const& sphere, U32 lightIndex);
+
+		F32 tanHalfFovX_ = 0.0f;
+		F32 tanHalfFovY_ = 0.0f;
+		F32 nearPlane_ = 0.0f;
+		F32 farPlane_ = 0.0f;
+		F32 sliceScale_ = 0.0f;
+		F32 sliceBias_ = 0.0f;
+
+		// Structure of arrays, so each group of four clusters along a row
+		// loads with a single instruction per component
+		Vector<F32> boundsMinX_;
+		Vector<F32> boundsMinY_;
+		Vector<F32> boundsMinZ_;
+		Vector<F32> boundsMaxX_;
+		Vector<F32> boundsMaxY_;
+		Vector<F32> boundsMaxZ_;
+
+		Vector<PointLight> viewLights_;
+		Vector<U32> hits_;
+		Vector<Cluster> clusters_;
+		Vector<U32> lightIndices_;
+	};
+
+} }
\ No newline at end of file
@@ -9,6 +9,7 @@ namespace vesp { namespace graphics {
 
 	class VertexShader;
 	class PixelShader;
+	struct MeshOptimiserStats;
 
 	class Mesh
 	{
@@ -18,9 +19,19 @@ namespace vesp { namespace graphics {
 		bool Create(ArrayView<Vertex> vertices, ArrayView<U32> indices,
 			D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
+		bool Create(ArrayView<Vertex> vertices, ArrayView<U16> indices,
+			D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
 		bool Create(ArrayView<Vertex> vertices, 
 			D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
+		// Runs the triangle list through OptimiseMesh before creating it
+		bool CreateOptimised(ArrayView<Vertex> vertices, 
+			MeshOptimiserStats* stats = nullptr);
+
+		bool CreateOptimised(ArrayView<Vertex> vertices, ArrayView<U32> indices,
+			MeshOptimiserStats* stats = nullptr);
+
 		Vec3 GetPosition();
 		void SetPosition(Vec3 const& position);
 
@@ -33,6 +44,12 @@ namespace vesp { namespace graphics {
 
 		void SetPositionAngle(Vec3 const& position, Quat const& angle);
 
+		Mat4 GetWorld();
+
+		// Object space bounds of the vertices the mesh was created from
+		Vec3 const& GetBoundsMin() const;
+		Vec3 const& GetBoundsMax() const;
+
 		Colour GetColour();
 		void SetColour(Colour colour);
 
@@ -42,6 +59,9 @@ namespace vesp { namespace graphics {
 		void SetVertexShader(StringView const shaderId);
 		void SetPixelShader(StringView const shaderId);
 
+		// Draws an instance per camera eye; screen space meshes turn this off
+		void SetStereoInstancing(bool enabled);
+
 		bool Exists() const;
 
 		void Draw();
@@ -69,8 +89,11 @@ namespace vesp { namespace graphics {
 		Vec3 position_;
 		Quat angle_;
 		Vec3 scale_;
+		Vec3 boundsMin_;
+		Vec3 boundsMax_;
 		Colour colour_ = Colour::White;
 		bool exists_ = false;
+		bool stereoInstancing_ = true;
 	};
 
 } }
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+#include "vesp/FileSystem.hpp"
+
+#include "vesp/math/Vector.hpp"
+#include "vesp/graphics/Vertex.hpp"
+
+namespace vesp { namespace graphics {
+
+	class Mesh;
+	struct OptimisedMesh;
+
+	// On-disk layout of a .vspm file. All offsets are in bytes from the start
+	// of the file and aligned to MeshFileAlignment, so sections can be used
+	// in place from a memory mapping.
+	struct MeshFileHeader
+	{
+		static const U32 Magic = 0x4D505356; // "VSPM"
+		static const U16 CurrentVersion = 1;
+
+		U32 magic;
+		U16 version;
+		U16 indexSize; // 0 (unindexed), 2 or 4
+
+		U32 vertexOffset;
+		U32 vertexCount;
+		U32 indexOffset;
+		U32 indexCount;
+		U32 lodOffset;
+		U32 lodCount;
+
+		Vec3 boundsMin;
+		Vec3 boundsMax;
+	};
+
+	static_assert(sizeof(MeshFileHeader) == 56, "MeshFileHeader size is wrong");
+
+	// Levels of detail share the vertex section and reference disjoint ranges
+	// of the index section. Files without LODs draw the whole index section.
+	struct MeshFileLod
+	{
+		U32 firstIndex;
+		U32 indexCount;
+		F32 maxDistance;
+		U32 reserved;
+	};
+
+	static_assert(sizeof(MeshFileLod) == 16, "MeshFileLod size is wrong");
+
+	static const U32 MeshFileAlignment = 16;
+
+	class MeshFile
+	{
+	public:
+		MeshFile();
+
+		// Maps the file and validates its sections; no data is copied.
+		bool Load(StringView path);
+		bool IsLoaded() const;
+
+		MeshFileHeader const& GetHeader() const;
+		ArrayView<Vertex> GetVertices();
+		ArrayView<U16> GetIndices16();
+		ArrayView<U32> GetIndices32();
+		ArrayView<MeshFileLod> GetLods();
+
+		// Creates the mesh straight from the mapped sections.
+		bool CreateMesh(Mesh& mesh, U32 lod = 0);
+
+		static bool Write(StringView path, OptimisedMesh const& mesh, 
+			ArrayView<MeshFileLod> lods = ArrayView<MeshFileLod>());
+
+	private:
+		template <typename T>
+		ArrayView<T> GetSection(U32 offset, U32 count);
+
+		FileSystem::MappedFile file_;
+		MeshFileHeader const* header_ = nullptr;
+	};
+
+} }
\ No newline at end of file
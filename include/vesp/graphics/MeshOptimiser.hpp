@@ -0,0 +1,77 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/Log.hpp"
+
+#include "vesp/graphics/Vertex.hpp"
+
+namespace vesp { namespace graphics {
+
+	struct MeshOptimiserStats
+	{
+		U32 vertexCountBefore = 0;
+		U32 vertexCountAfter = 0;
+		U32 indexCountBefore = 0;
+		U32 indexCountAfter = 0;
+
+		// Average cache miss ratio (transformed vertices per triangle) for a
+		// FIFO post-transform cache of MeshOptimiserCacheSize entries
+		F32 acmrBefore = 0.0f;
+		F32 acmrAfter = 0.0f;
+
+		// Total vertex and index buffer sizes
+		U32 bytesBefore = 0;
+		U32 bytesAfter = 0;
+
+		// Inline so that code which never logs a summary does not need the
+		// logger
+		void LogSummary(RawStringPtr name) const
+		{
+			LogInfo("%s: %u -> %u vertices, %u -> %u indices, ACMR %.3f -> %.3f, %u -> %u bytes",
+				name,
+				this->vertexCountBefore, this->vertexCountAfter,
+				this->indexCountBefore, this->indexCountAfter,
+				this->acmrBefore, this->acmrAfter,
+				this->bytesBefore, this->bytesAfter);
+		}
+	};
+
+	// Triangle list ready for Mesh::Create. Only one of indices16/indices32 is
+	// populated, depending on whether the vertex count fits in 16 bits.
+	struct OptimisedMesh
+	{
+		Vector<Vertex> vertices;
+		Vector<U16> indices16;
+		Vector<U32> indices32;
+
+		MeshOptimiserStats stats;
+
+		bool Uses16BitIndices() const;
+	};
+
+	static const U32 MeshOptimiserCacheSize = 16;
+
+	// Full pipeline: weld, reorder triangles for the post-transform cache,
+	// reorder vertices for fetch locality, then pick the index width.
+	// The first overload takes unindexed triangle soup.
+	OptimisedMesh OptimiseMesh(ArrayView<Vertex> vertices);
+	OptimisedMesh OptimiseMesh(ArrayView<Vertex> vertices, ArrayView<U32> indices);
+
+	// Individual stages
+	// Merges bit-identical vertices and rewrites indices to match. If indices
+	// is empty, vertices are treated as triangle soup.
+	void WeldVertices(ArrayView<Vertex> vertices, ArrayView<U32> indices,
+		Vector<Vertex>& outVertices, Vector<U32>& outIndices);
+
+	// Reorders triangles using Tom Forsyth's linear-speed vertex cache optimisation.
+	Vector<U32> OptimiseVertexCache(ArrayView<U32> indices, U32 vertexCount);
+
+	// Reorders vertices into first-use order, dropping unreferenced vertices,
+	// and rewrites indices in place.
+	void OptimiseVertexFetch(Vector<Vertex>& vertices, ArrayView<U32> indices);
+
+	F32 CalculateACMR(ArrayView<U32> indices, U32 vertexCount, 
+		U32 cacheSize = MeshOptimiserCacheSize);
+
+} }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+
+#include "vesp/math/Matrix.hpp"
+#include "vesp/math/Vector.hpp"
+
+namespace vesp { namespace graphics {
+
+	struct OcclusionStats
+	{
+		U32 occluderTriangles = 0;
+		U32 rasterisedTriangles = 0;
+		U32 tested = 0;
+		U32 occluded = 0;
+	};
+
+	// Software occlusion culling against a low resolution depth buffer.
+	// A few large occluders are rasterised each frame, after which bounding
+	// boxes can be tested against the result before their meshes are drawn.
+	//
+	// Occluders write the pixels whose centres they cover, at the farthest
+	// depth they reach within each pixel, and boxes are tested at their
+	// nearest depth. The buffer stores post-projection depth, and a per-tile
+	// maximum lets most tests skip the pixels entirely.
+	//
+	// This has no dependency on the device, so it runs anywhere.
+	class OcclusionCuller
+	{
+	public:
+		static const U32 TileWidth = 8;
+		static const U32 TileHeight = 8;
+
+		// The resolution is rounded up to whole tiles
+		OcclusionCuller(U32 width = 320, U32 height = 192);
+
+		// Clears the buffer for a new view
+		void Begin(Mat4 const& viewProjection);
+		void AddOccluder(ArrayView<Vec3> positions, ArrayView<U32> indices, Mat4 const& world);
+		// Builds the tile hierarchy; call after the last occluder and before testing
+		void Finish();
+
+		bool IsVisible(Vec3 const& boundsMin, Vec3 const& boundsMax, Mat4 const& world);
+
+		U32 GetWidth() const;
+		U32 GetHeight() const;
+		ArrayView<F32> GetDepth();
+
+		OcclusionStats const& GetStats() const;
+
+	private:
+		void RasteriseClipped(Vec4 const* vertices);
+		void RasteriseTriangle(Vec3 v0, Vec3 v1, Vec3 v2);
+		Vec3 ToScreen(Vec4 const& clip) const;
+
+		U32 width_;
+		U32 height_;
+		U32 tilesX_;
+		U32 tilesY_;
+
+		Mat4 viewProjection_;
+		Vector<F32> depth_;
+		Vector<F32> tileDepth_;
+		Vector<Vec4> clipVertices_;
+
+		OcclusionStats stats_;
+	};
+
+} }
\ No newline at end of file
@@ -27,10 +27,17 @@ namespace vesp { namespace graphics {
 		ShaderType GetType() const;
 		StringView GetName();
 
+		// Compiles to bytecode through the shader cache without touching the
+		// device, so it may run on any thread. Errors are kept for the caller
+		// to report.
+		bool Compile(StringView const shaderSource);
+		StringView GetCompileErrors();
+
 	protected:
-		void* Compile(StringView const shaderSource);
 		ShaderType type_;
 		String name_;
+		String compileErrors_;
+		Vector<U8> bytecode_;
 	};
 
 	class VertexShader : public Shader
@@ -40,6 +47,8 @@ namespace vesp { namespace graphics {
 
 		bool Load(StringView const shaderSource,
 			ArrayView<D3D11_INPUT_ELEMENT_DESC> inputLayoutElements);
+		// Creates the device objects from previously compiled bytecode.
+		bool Create(ArrayView<D3D11_INPUT_ELEMENT_DESC> inputLayoutElements);
 		void Activate();
 
 	private:
@@ -53,6 +62,8 @@ namespace vesp { namespace graphics {
 		PixelShader(StringView const name);
 
 		bool Load(StringView const shaderSource);
+		// Creates the device objects from previously compiled bytecode.
+		bool Create();
 		void Activate();
 
 	private:
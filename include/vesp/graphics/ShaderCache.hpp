@@ -0,0 +1,58 @@
+#pragma once
+
+#include "vesp/graphics/ShaderCacheStorage.hpp"
+#include "vesp/graphics/ShaderCompiler.hpp"
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+
+#include <atomic>
+
+namespace vesp { namespace graphics {
+
+	// On-disk layout of a cached blob; the bytecode follows the header.
+	struct ShaderCacheHeader
+	{
+		static const U32 Magic = 0x43535356; // "VSSC"
+		static const U32 CurrentVersion = 1;
+
+		U32 magic;
+		U32 version;
+		U64 key;
+		U32 size;
+		U32 reserved;
+	};
+
+	static_assert(sizeof(ShaderCacheHeader) == 24, "ShaderCacheHeader size is wrong");
+
+	// Stores compiled bytecode, keyed by the source and everything that
+	// affects the output. Warm starts skip compilation entirely.
+	class ShaderCache
+	{
+	public:
+		ShaderCache(ShaderCompiler& compiler, ShaderCacheStorage& storage);
+
+		// Safe to call from several threads at once.
+		bool Compile(StringView const source, ShaderCompileOptions const& options,
+			Vector<U8>& bytecode, String& errors);
+
+		U64 GetKey(StringView const source, ShaderCompileOptions const& options) const;
+		// The name the blob for `key` is stored under
+		String GetName(U64 key) const;
+
+		U32 GetHits() const;
+		U32 GetMisses() const;
+
+	private:
+		bool Read(U64 key, Vector<U8>& bytecode);
+		void Write(U64 key, ArrayView<U8> bytecode);
+
+		ShaderCompiler& compiler_;
+		ShaderCacheStorage& storage_;
+
+		std::atomic<U32> hits_{0};
+		std::atomic<U32> misses_{0};
+	};
+
+} }
\ No newline at end of file
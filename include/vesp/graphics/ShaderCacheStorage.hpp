@@ -0,0 +1,38 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+
+namespace vesp { namespace graphics {
+
+	// Where ShaderCache keeps its blobs, by file name. Both calls may come
+	// from several threads at once.
+	class ShaderCacheStorage
+	{
+	public:
+		virtual ~ShaderCacheStorage() {}
+
+		// Returns false if there is no blob with this name
+		virtual bool Read(StringView const name, Vector<U8>& data) = 0;
+		// Replaces any existing blob; readers never see a partial one
+		virtual void Write(StringView const name, ArrayView<U8> data) = 0;
+	};
+
+	// Keeps each blob in a file under a directory, which is created if
+	// it does not exist
+	class FileShaderCacheStorage : public ShaderCacheStorage
+	{
+	public:
+		FileShaderCacheStorage(StringView directory);
+
+		bool Read(StringView const name, Vector<U8>& data) override;
+		void Write(StringView const name, ArrayView<U8> data) override;
+
+		String GetPath(StringView const name) const;
+
+	private:
+		String directory_;
+	};
+
+} }
\ No newline at end of file
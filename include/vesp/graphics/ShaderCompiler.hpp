@@ -0,0 +1,48 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+
+namespace vesp { namespace graphics {
+
+	struct ShaderDefine
+	{
+		String name;
+		String value;
+	};
+
+	struct ShaderCompileOptions
+	{
+		// Only used for diagnostics; not part of the cache key
+		String name;
+		String target;
+		String entryPoint;
+		U32 flags = 0;
+		Vector<ShaderDefine> defines;
+	};
+
+	class ShaderCompiler
+	{
+	public:
+		virtual ~ShaderCompiler() {}
+
+		// Must be safe to call from several threads at once.
+		virtual bool Compile(StringView const source, ShaderCompileOptions const& options,
+			Vector<U8>& bytecode, String& errors) = 0;
+
+		// Identifies the compiler and its version; bytecode produced by a
+		// different compiler is never reused.
+		virtual StringView GetIdentifier() const = 0;
+	};
+
+	class D3DShaderCompiler : public ShaderCompiler
+	{
+	public:
+		bool Compile(StringView const source, ShaderCompileOptions const& options,
+			Vector<U8>& bytecode, String& errors) override;
+
+		StringView GetIdentifier() const override;
+	};
+
+} }
\ No newline at end of file
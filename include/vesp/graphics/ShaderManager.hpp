@@ -3,28 +3,37 @@
 #include "vesp/util/GlobalSystem.hpp"
 
 #include "vesp/graphics/Shader.hpp"
+#include "vesp/graphics/ShaderCompiler.hpp"
+#include "vesp/graphics/ShaderCache.hpp"
 
 #include "vesp/Containers.hpp"
 #include "vesp/String.hpp"
 
 namespace vesp { namespace graphics {
 
-	class ShaderManager : public util::GlobalSystem<ShaderManager>
+	class ShaderManager : public util::GlobalSystem<ShaderManager, MemoryTag::Graphics>
 	{
 	public:
 		ShaderManager();
 
 		void LoadShader(StringView const name, ShaderType type);
+		// Returns null until the shader has loaded
 		Shader* GetShader(StringView const name, ShaderType type) const;
 
 		VertexShader* GetVertexShader(StringView const name) const;
 		PixelShader* GetPixelShader(StringView const name) const;
 
+		ShaderCache* GetShaderCache();
+
 	private:
 		void ReloadAll();
 		U32 GetKey(StringView const name, ShaderType type) const;
 
 		UnorderedMap<U32, UniquePtr<Shader>> shaders_;
+
+		D3DShaderCompiler compiler_;
+		FileShaderCacheStorage cacheStorage_;
+		ShaderCache cache_;
 	};
 
 } }
\ No newline at end of file
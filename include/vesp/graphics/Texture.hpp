@@ -0,0 +1,30 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/graphics/TextureBuilder.hpp"
+
+#pragma warning(push)
+#pragma warning(disable: 4005)
+#include <atlbase.h>
+#include <d3d11.h>
+#pragma warning(pop)
+
+namespace vesp { namespace graphics {
+
+	// Immutable GPU texture created from a built mip chain
+	class Texture
+	{
+	public:
+		bool Create(TextureData& texture);
+
+		void Use(U32 slot);
+		bool Exists() const;
+
+		ID3D11ShaderResourceView* GetView();
+
+	private:
+		CComPtr<ID3D11Texture2D> texture_;
+		CComPtr<ID3D11ShaderResourceView> view_;
+	};
+
+} }
\ No newline at end of file
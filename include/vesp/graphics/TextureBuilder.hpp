@@ -0,0 +1,98 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/String.hpp"
+
+namespace vesp { namespace graphics {
+
+	enum class TextureFormat : U8
+	{
+		R8,
+		RG8,
+		RGBA8,
+		BC1, // RGB, 4 bits per texel
+		BC3, // RGBA, 8 bits per texel
+		BC4, // R, 4 bits per texel
+		BC5  // RG, 8 bits per texel
+	};
+
+	enum class MipFilter : U8
+	{
+		None,
+		Box,
+		Kaiser
+	};
+
+	// Channels the source pixels need, bytes per texel for uncompressed
+	// formats and bytes per 4x4 block for compressed ones.
+	U32 GetSourceChannels(TextureFormat format);
+	bool IsBlockCompressed(TextureFormat format);
+	U32 GetElementSize(TextureFormat format);
+	U32 GetLevelSize(TextureFormat format, U32 width, U32 height);
+	// Block compressed textures need a top level that is a whole number of
+	// blocks; D3D11 refuses to create them otherwise.
+	bool HasValidDimensions(TextureFormat format, U32 width, U32 height);
+
+	struct TextureLevel
+	{
+		U32 width;
+		U32 height;
+		U32 offset;
+		U32 size;
+	};
+
+	struct TextureData
+	{
+		TextureFormat format = TextureFormat::RGBA8;
+		U32 width = 0;
+		U32 height = 0;
+
+		Vector<TextureLevel> levels;
+		Vector<U8> data;
+
+		ArrayView<U8> GetLevel(U32 level);
+		U32 GetRowPitch(U32 level) const;
+	};
+
+	struct TextureBuildOptions
+	{
+		TextureFormat format = TextureFormat::BC1;
+		MipFilter mipFilter = MipFilter::Kaiser;
+	};
+
+	// Halves an image with 1 or 4 interleaved 8-bit channels. Odd sizes
+	// repeat the last row or column.
+	void GenerateMip(ArrayView<U8> source, U32 width, U32 height, U32 channels,
+		MipFilter filter, Vector<U8>& dest);
+
+	// Encodes a whole level, spreading rows of blocks across threads. The
+	// source has GetSourceChannels(format) channels.
+	void CompressLevel(TextureFormat format, ArrayView<U8> source, 
+		U32 width, U32 height, ArrayView<U8> dest);
+
+	// Builds textures from encoded images (anything stb_image reads) and
+	// caches the result on disk, keyed by the image contents and options.
+	class TextureBuilder
+	{
+	public:
+		TextureBuilder(StringView cacheDirectory);
+
+		bool Build(ArrayView<U8> encoded, TextureBuildOptions const& options, 
+			TextureData& texture);
+
+		// The dimensions must be valid for the format.
+		static void BuildFromPixels(ArrayView<U8> pixels, U32 width, U32 height,
+			TextureBuildOptions const& options, TextureData& texture);
+
+		U64 GetKey(ArrayView<U8> encoded, TextureBuildOptions const& options) const;
+		String GetPath(U64 key) const;
+
+	private:
+		bool Read(U64 key, TextureData& texture);
+		void Write(U64 key, TextureData& texture);
+
+		String directory_;
+	};
+
+} }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
 #include "vesp/math/Vector.hpp"
 #include "vesp/graphics/Colour.hpp"
 
@@ -12,6 +13,7 @@ namespace vesp { namespace graphics {
 		Vertex(Vec3 position, Vec3 normal, Vec2 texcoord = Vec2(0.0f, 0.0f));
 		Vertex(Vec3 position, Vec3 normal, Colour colour);
 
+		// Normals are stored octahedrally encoded as two UNORM16 components
 		void SetNormal(Vec3 normal);
 		Vec3 GetNormal() const;
 
@@ -26,4 +28,9 @@ namespace vesp { namespace graphics {
 
 	static_assert(sizeof(Vertex) == 24, "Vertex size is wrong");
 
+	// Batch equivalents of SetNormal/GetNormal; four normals are processed at a time.
+	// Both views must be the same length.
+	void PackNormals(ArrayView<Vertex> vertices, ArrayView<Vec3> normals);
+	void UnpackNormals(ArrayView<Vertex> vertices, ArrayView<Vec3> normals);
+
 } }
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+
+#include "vesp/math/Matrix.hpp"
+#include "vesp/math/Vector.hpp"
+
+namespace vesp { namespace math {
+
+	// Six planes extracted from a D3D-style (0 to 1 depth) projection
+	// matrix. Planes face inwards, so points inside have positive distance.
+	struct Frustum
+	{
+		static Frustum FromMatrix(Mat4 const& matrix);
+
+		// The box is in the space the matrix transforms from; pass
+		// viewProjection * world to test object space bounds
+		bool Intersects(Vec3 const& boundsMin, Vec3 const& boundsMax) const;
+
+		Array<Vec4, 6> planes;
+	};
+
+} }
\ No newline at end of file
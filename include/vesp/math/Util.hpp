@@ -1,5 +1,8 @@
 #pragma once
 
+#include <limits>
+#include <type_traits>
+
 namespace vesp { namespace math {
 
 	template <typename T>
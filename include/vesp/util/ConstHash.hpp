@@ -0,0 +1,14 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+
+namespace vesp { namespace util {
+
+	// FNV-1a, written as a single expression so that hashes of string
+	// literals can be computed at compile time
+	constexpr U32 ConstHash(RawStringPtr str, U32 hash = 2166136261u)
+	{
+		return *str ? ConstHash(str + 1, (hash ^ U8(*str)) * 16777619u) : hash;
+	}
+
+} }
\ No newline at end of file
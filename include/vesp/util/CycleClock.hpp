@@ -0,0 +1,37 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+
+#include <chrono>
+#include <intrin.h>
+
+namespace vesp { namespace util {
+
+	// Cheap timestamps for hot paths. Reads the CPU's time stamp counter
+	// when it ticks at a constant rate regardless of power state, and falls
+	// back to the steady clock otherwise. Ticks are only comparable with
+	// other ticks from the same run.
+	class CycleClock
+	{
+	public:
+		// Measures the counter against the steady clock; call once at
+		// startup, before anything keeps timestamps around
+		static void Calibrate();
+
+		static U64 Now()
+		{
+			if (useCounter_)
+				return __rdtsc();
+
+			return U64(std::chrono::steady_clock::now().time_since_epoch().count());
+		}
+
+		static F64 GetSecondsPerTick();
+		static bool UsesCounter();
+
+	private:
+		static bool useCounter_;
+		static F64 secondsPerTick_;
+	};
+
+} }
\ No newline at end of file
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/Containers.hpp"
+#include "vesp/Assert.hpp"
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace vesp { namespace util {
+
+	template <typename Signature>
+	class Delegate;
+
+	// A callable stored inline, without touching the heap. It holds any
+	// trivially copyable function object of up to four pointers, which
+	// covers lambdas capturing `this` and a few references or values, and
+	// calls it through a single function pointer.
+	template <typename R, typename... Args>
+	class Delegate<R (Args...)>
+	{
+	public:
+		static const size_t Capacity = 4 * sizeof(void*);
+
+		Delegate()
+			: invoke_(nullptr)
+		{
+		}
+
+		template <typename Function>
+		Delegate(Function function)
+			: invoke_(&Invoke<Function>)
+		{
+			static_assert(sizeof(Function) <= Capacity, "Function is too large for a delegate; capture less or by pointer");
+			static_assert(alignof(Function) <= alignof(Storage), "Function is overaligned for a delegate");
+			static_assert(std::is_trivially_copyable<Function>::value, "Delegates only hold trivially copyable functions");
+
+			new (&this->storage_) Function(std::move(function));
+		}
+
+		R operator()(Args... args) const
+		{
+			VESP_ASSERT(this->invoke_);
+			return this->invoke_(&this->storage_, std::forward<Args>(args)...);
+		}
+
+		explicit operator bool() const
+		{
+			return this->invoke_ != nullptr;
+		}
+
+	private:
+		typedef typename std::aligned_storage<Capacity, alignof(void*)>::type Storage;
+
+		template <typename Function>
+		static R Invoke(void const* storage, Args... args)
+		{
+			return (*static_cast<Function const*>(storage))(std::forward<Args>(args)...);
+		}
+
+		R (*invoke_)(void const*, Args...);
+		Storage storage_;
+	};
+
+	// Identifies one delegate in a DelegateList; zero is never issued
+	struct Subscription
+	{
+		U32 slot;
+		U32 id;
+	};
+
+	// Delegates that can be removed by the ID they were added with, including
+	// from inside one of the delegates while the list is being visited
+	template <typename Signature>
+	class DelegateList
+	{
+	public:
+		U32 Add(Delegate<Signature> delegate)
+		{
+			this->entries_.push_back({this->nextId_, delegate});
+			return this->nextId_++;
+		}
+
+		// Returns false if no delegate has this ID
+		bool Remove(U32 id)
+		{
+			for (auto& entry : this->entries_)
+			{
+				if (entry.id != id)
+					continue;
+
+				entry.id = 0;
+				entry.delegate = Delegate<Signature>();
+
+				if (!this->visiting_)
+					this->Compact();
+				else
+					this->needsCompaction_ = true;
+
+				return true;
+			}
+
+			return false;
+		}
+
+		// Calls `visit` with each delegate in the order they were added.
+		// Delegates added during the visit are included.
+		template <typename Visitor>
+		void Visit(Visitor&& visit)
+		{
+			++this->visiting_;
+			for (size_t i = 0; i < this->entries_.size(); ++i)
+			{
+				if (!this->entries_[i].id)
+					continue;
+
+				// Called through a copy: an Add can reallocate the entries,
+				// and a Remove clears them, while the delegate is running
+				auto delegate = this->entries_[i].delegate;
+				visit(delegate);
+			}
+			--this->visiting_;
+
+			if (!this->visiting_ && this->needsCompaction_)
+				this->Compact();
+		}
+
+		bool IsEmpty() const
+		{
+			return this->entries_.empty();
+		}
+
+	private:
+		struct Entry
+		{
+			U32 id;
+			Delegate<Signature> delegate;
+		};
+
+		void Compact()
+		{
+			this->entries_.erase(
+				std::remove_if(this->entries_.begin(), this->entries_.end(),
+					[](Entry const& entry) { return entry.id == 0; }),
+				this->entries_.end());
+			this->needsCompaction_ = false;
+		}
+
+		Vector<Entry> entries_;
+		U32 nextId_ = 1;
+		U32 visiting_ = 0;
+		bool needsCompaction_ = false;
+	};
+
+} }
\ No newline at end of file
@@ -1,22 +1,27 @@
 #pragma once
 
+#include "vesp/Memory.hpp"
+
 namespace vesp { namespace util {
 
-	template <typename T>
+	// Allocations made while a system is created are attributed to Tag
+	template <typename T, MemoryTag::Enum Tag = MemoryTag::General>
 	class GlobalSystem
 	{
 	public:
 		template <typename... Values>
 		static void Create(Values&&... values)
 		{
-			ptr_ = reinterpret_cast<T*>(_aligned_malloc(sizeof(T), alignof(T)));
+			MemoryScope scope(Tag);
+			ptr_ = reinterpret_cast<T*>(MemoryTracker::Allocate(sizeof(T), alignof(T)));
 			new (ptr_) T(values...);
 		}
 
 		static void Destroy()
 		{
 			ptr_->~T();
-			_aligned_free(ptr_);
+			MemoryTracker::Free(ptr_);
+			ptr_ = nullptr;
 		}
 
 		static T* Get()
@@ -28,7 +33,7 @@ namespace vesp { namespace util {
 		static T* ptr_;
 	};
 
-	template <typename T>
-	T* GlobalSystem<T>::ptr_;
+	template <typename T, MemoryTag::Enum Tag>
+	T* GlobalSystem<T, Tag>::ptr_;
 
 } }
\ No newline at end of file
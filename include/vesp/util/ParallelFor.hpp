@@ -0,0 +1,63 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+#include "vesp/AssetLoader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace vesp { namespace util {
+
+	// Runs fn(index) for every index in [0, count) on the calling thread and
+	// the asset loader's workers, or on the calling thread alone if there is
+	// no asset loader. Indices are handed out in batches so that uneven work
+	// still balances. The caller works through the batches too, so this
+	// finishes even when every worker is busy.
+	template <typename Fn>
+	void ParallelFor(U32 count, U32 batchSize, Fn const& fn)
+	{
+		struct Batches
+		{
+			std::atomic<U32> next{0};
+			std::atomic<U32> finished{0};
+		};
+
+		auto const batchCount = (count + batchSize - 1) / batchSize;
+
+		// Workers that only start once every batch is taken still touch
+		// this, so it outlives the call. `fn` is only used for batches the
+		// caller waits on.
+		auto batches = std::make_shared<Batches>();
+		auto work = [batches, batchCount, count, batchSize, &fn]
+		{
+			for (;;)
+			{
+				auto batch = batches->next++;
+				if (batch >= batchCount)
+					return;
+
+				auto end = std::min(count, (batch + 1) * batchSize);
+				for (auto index = batch * batchSize; index < end; ++index)
+					fn(index);
+
+				++batches->finished;
+			}
+		};
+
+		auto loader = AssetLoader::Get();
+		if (loader && batchCount > 1)
+		{
+			auto helperCount = std::min(loader->GetWorkerCount(), batchCount - 1);
+			for (U32 i = 0; i < helperCount; ++i)
+				loader->Schedule(work);
+		}
+
+		work();
+
+		while (batches->finished < batchCount)
+			std::this_thread::yield();
+	}
+
+} }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "vesp/util/CycleClock.hpp"
+
 #include <chrono>
 
 namespace vesp { namespace util {
@@ -46,4 +48,42 @@ namespace vesp { namespace util {
 		std::chrono::high_resolution_clock::time_point startTime_;
 	};
 
+	// Timer on CycleClock ticks; much cheaper to read where the counter is
+	// usable, with the same interface as Timer
+	struct CycleTimer
+	{
+	public:
+		CycleTimer()
+		{
+			this->Restart();
+		}
+
+		void Restart()
+		{
+			this->startTime_ = CycleClock::Now();
+		}
+
+		template <typename Ratio, typename T = float>
+		T GetElapsed() const
+		{
+			auto seconds = F64(CycleClock::Now() - this->startTime_) * CycleClock::GetSecondsPerTick();
+			return T(seconds * Ratio::den / Ratio::num);
+		}
+
+	#define TIMER_ALIAS(name, ...)\
+		template <typename T = float> \
+		T Get##name() const { return this->GetElapsed<__VA_ARGS__, T>(); }
+
+		TIMER_ALIAS(Hours, std::ratio<3600, 1>)
+		TIMER_ALIAS(Minutes, std::ratio<60, 1>)
+		TIMER_ALIAS(Seconds, std::ratio<1, 1>)
+		TIMER_ALIAS(Milliseconds, std::milli)
+		TIMER_ALIAS(Microseconds, std::micro)
+
+	#undef TIMER_ALIAS
+
+	private:
+		U64 startTime_;
+	};
+
 } }
\ No newline at end of file
@@ -4,21 +4,24 @@
 
 #include "vesp/graphics/Mesh.hpp"
 #include "vesp/graphics/Image.hpp"
+#include "vesp/graphics/OcclusionCuller.hpp"
 
+#include "vesp/ResourceCache.hpp"
 #include "vesp/String.hpp"
 
 namespace vesp { namespace world {
 
-	class HeightMapTerrain : public util::GlobalSystem<HeightMapTerrain>
+	class HeightMapTerrain : public util::GlobalSystem<HeightMapTerrain, MemoryTag::Terrain>
 	{
 	public:
 		HeightMapTerrain();
 
 		void Load();
+		void AddOccluders(graphics::OcclusionCuller& culler);
 		void Draw();
 
 	private:
-		graphics::Image heightMap_;
+		ResourceHandle terrain_;
 		graphics::Mesh terrainMesh_;
 	};
 
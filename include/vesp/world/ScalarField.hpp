@@ -20,8 +20,10 @@ namespace vesp { namespace world {
 		template <typename Functor>
 		void LoadFromFunction(U32 xSize, U32 ySize, U32 zSize, Functor&& f)
 		{
-			auto data = std::make_unique<world::ScalarField::Scalar[]>(xSize*ySize*zSize);
-			auto dataPtr = data.get();
+			VESP_MEMORY_SCOPE(ScalarField);
+
+			Vector<Scalar> data(xSize*ySize*zSize);
+			auto dataPtr = data.data();
 
 			for (auto z = 0u; z < zSize; z++)
 			{
@@ -35,7 +37,7 @@ namespace vesp { namespace world {
 					}
 				}
 			}
-			this->Load(data.get(), xSize, ySize, zSize);
+			this->Load(data.data(), xSize, ySize, zSize);
 		}
 
 		Vector<graphics::Vertex> Polygonise(Scalar isolevel);
@@ -49,6 +51,7 @@ namespace vesp { namespace world {
 		typedef struct
 		{
 			Vec3 p[8];
+			Vec3 grad[8];
 			Scalar val[8];
 		} GRIDCELL;
 
@@ -56,7 +59,8 @@ namespace vesp { namespace world {
 		U32 ySize_;
 		U32 zSize_;
 
-		UniquePtr<Scalar[]> data_;
-		void PolygoniseCell(GRIDCELL grid, Scalar isolevel, Vector<graphics::Vertex>& vertices);
+		Vector<Scalar> data_;
+		void PolygoniseCell(GRIDCELL grid, Scalar isolevel,
+			Vector<graphics::Vertex>& vertices, Vector<Vec3>& normals);
 	};
 } }
\ No newline at end of file
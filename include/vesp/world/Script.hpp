@@ -3,12 +3,13 @@
 #include "vesp/script/Module.hpp"
 
 #include "vesp/graphics/Mesh.hpp"
+#include "vesp/graphics/OcclusionCuller.hpp"
 
 #include "vesp/util/GlobalSystem.hpp"
 
 namespace vesp { namespace world {
 
-class Script : public util::GlobalSystem<Script>
+class Script : public util::GlobalSystem<Script, MemoryTag::Script>
 {
 public:
 	Script();
@@ -17,16 +18,31 @@ public:
 	
 	U32 AddMesh(graphics::Mesh&& mesh);
 	void RemoveMesh(U32 meshId);
+	// Positions are a triangle list in the mesh's object space. They must
+	// lie within opaque parts of the mesh, or they will hide things that
+	// can be seen.
+	void SetOccluder(U32 meshId, ArrayView<Vec3> positions);
+	void AddOccluders(graphics::OcclusionCuller& culler);
 	void Draw();
 
 	void Pulse();
 
 private:
 	void BindConsole();
+	void RunFile(StringView path);
 
 	UniquePtr<script::Module> module_;
+	// Bumped by every reload; a new module can reuse the old one's address
+	U32 generation_ = 0;
+
+	struct Occluder
+	{
+		Vector<Vec3> positions;
+		Vector<U32> indices;
+	};
 
 	UnorderedMap<U32, graphics::Mesh> meshes_;
+	UnorderedMap<U32, Occluder> occluders_;
 	U32 nextMeshId_ = 0;
 };
 
@@ -38,4 +38,78 @@ project "Vespertine"
 		}
 
 	configuration { "gmake" }
-		buildoptions { "-std=c++11" }
\ No newline at end of file
+		buildoptions { "-std=c++11" }
+
+-- Unit tests of the modules that do not need the platform layer, so they
+-- build and run anywhere; tests/Support.cpp stands in for the engine
+-- systems those modules reach. Run the executable; it returns non-zero if
+-- any test fails.
+TEST_SOURCES = {
+	"src/vesp/String.cpp",
+	"src/vesp/math/Matrix.cpp",
+	"src/vesp/util/MurmurHash.cpp",
+	"src/vesp/graphics/Colour.cpp",
+	"src/vesp/graphics/MeshOptimiser.cpp",
+	"src/vesp/graphics/OcclusionCuller.cpp",
+	"src/vesp/graphics/ShaderCache.cpp",
+	"src/vesp/graphics/Vertex.cpp",
+}
+
+project "VespertineTests"
+	kind "ConsoleApp"
+	language "C++"
+	targetdir "bin/%{cfg.buildcfg}"
+	location "."
+
+	includedirs(VENDOR_INCLUDES)
+	includedirs { "include/", "tests/" }
+	files { "tests/**.hpp", "tests/**.cpp" }
+	files(TEST_SOURCES)
+	flags { "FatalWarnings", "MultiProcessorCompile" }
+	defines { "NOMINMAX", "_USE_MATH_DEFINES", "VESP_ASSERT_ENABLED" }
+	exceptionhandling "Off"
+	rtti "Off"
+
+	filter "configurations:Debug"
+		defines { "DEBUG" }
+		flags { "Symbols" }
+
+	filter "configurations:Release"
+		defines { "NDEBUG" }
+		optimize "On"
+
+	configuration { "gmake" }
+		buildoptions { "-std=c++11", "-Wall", "-Wno-unknown-pragmas" }
+
+-- Timings of the hot paths that do not need the platform layer. Build the
+-- Release configuration; the program prints its figures.
+BENCHMARK_SOURCES = {
+	"src/vesp/graphics/OcclusionCuller.cpp",
+	"src/vesp/math/Matrix.cpp",
+}
+
+project "VespertineBenchmarks"
+	kind "ConsoleApp"
+	language "C++"
+	targetdir "bin/%{cfg.buildcfg}"
+	location "."
+
+	includedirs(VENDOR_INCLUDES)
+	includedirs { "include/" }
+	files { "benchmarks/**.cpp", "tests/Support.cpp" }
+	files(BENCHMARK_SOURCES)
+	flags { "FatalWarnings", "MultiProcessorCompile" }
+	defines { "NOMINMAX", "_USE_MATH_DEFINES" }
+	exceptionhandling "Off"
+	rtti "Off"
+
+	filter "configurations:Debug"
+		defines { "DEBUG", "VESP_ASSERT_ENABLED" }
+		flags { "Symbols" }
+
+	filter "configurations:Release"
+		defines { "NDEBUG" }
+		optimize "On"
+
+	configuration { "gmake" }
+		buildoptions { "-std=c++11", "-Wall", "-Wno-unknown-pragmas" }
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "vesp/AssetLoader.hpp"
+#include "vesp/EventManager.hpp"
+#include "vesp/FileSystem.hpp"
+#include "vesp/Profiler.hpp"
+#include "vesp/Log.hpp"
+#include "vesp/Metrics.hpp"
+
+#include "vesp/util/MurmurHash.hpp"
+#include "vesp/util/Timer.hpp"
+
+#include <algorithm>
+
+namespace vesp
+{
+	namespace
+	{
+		Gauge PendingAssets("assets_pending", "Asset requests awaiting completion");
+	}
+
+	AssetLoader::AssetLoader(U32 workerCount)
+	{
+		if (workerCount == 0)
+		{
+			// hardware_concurrency() may return 0 when it cannot tell
+			workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+		}
+
+		for (U32 i = 0; i < workerCount; ++i)
+			this->workers_.emplace_back([this] { this->WorkerMain(); });
+	}
+
+	AssetLoader::~AssetLoader()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->queueMutex_);
+			this->quit_ = true;
+		}
+		this->queueCondition_.notify_all();
+
+		for (auto& worker : this->workers_)
+			worker.join();
+	}
+
+	void AssetLoader::Pulse()
+	{
+		VESP_PROFILE_FN();
+
+		// Always complete at least one request so that a single expensive
+		// upload cannot stall the queue forever
+		util::CycleTimer timer;
+		while (this->CompleteOne())
+		{
+			if (timer.GetMilliseconds() >= this->uploadBudget_)
+				break;
+		}
+
+		PendingAssets.Set(F64(this->pending_));
+	}
+
+	void AssetLoader::Flush()
+	{
+		while (this->pending_ > 0)
+		{
+			{
+				std::unique_lock<std::mutex> lock(this->completedMutex_);
+				this->completedCondition_.wait(lock, [&] { 
+					return !this->completed_.empty(); 
+				});
+			}
+
+			while (this->CompleteOne())
+				;
+		}
+	}
+
+	void AssetLoader::Schedule(std::function<void ()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->queueMutex_);
+			this->tasks_.push_back(std::move(task));
+		}
+		this->queueCondition_.notify_one();
+	}
+
+	void AssetLoader::SetUploadBudget(F32 milliseconds)
+	{
+		this->uploadBudget_ = milliseconds;
+	}
+
+	U32 AssetLoader::GetPendingCount() const
+	{
+		return this->pending_;
+	}
+
+	U32 AssetLoader::GetWorkerCount() const
+	{
+		return U32(this->workers_.size());
+	}
+
+	void AssetLoader::Enqueue(RequestPtr request)
+	{
+		++this->pending_;
+
+		{
+			std::lock_guard<std::mutex> lock(this->queueMutex_);
+			this->queue_.push_back(std::move(request));
+		}
+		this->queueCondition_.notify_one();
+	}
+
+	void AssetLoader::WorkerMain()
+	{
+		Profiler::SetThreadName("Asset loader");
+		VESP_MEMORY_SCOPE(Assets);
+
+		for (;;)
+		{
+			RequestPtr request;
+			std::function<void ()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(this->queueMutex_);
+				this->queueCondition_.wait(lock, [&] { 
+					return this->quit_ || !this->queue_.empty() || !this->tasks_.empty(); 
+				});
+
+				if (this->quit_)
+					return;
+
+				// Tasks usually have a caller waiting on them
+				if (!this->tasks_.empty())
+				{
+					task = std::move(this->tasks_.front());
+					this->tasks_.pop_front();
+				}
+				else
+				{
+					request = std::move(this->queue_.front());
+					this->queue_.pop_front();
+				}
+			}
+
+			if (task)
+			{
+				task();
+				continue;
+			}
+
+			VESP_PROFILE_BLOCK("Load asset");
+
+			auto file = FileSystem::Get()->Open(request->path, FileSystem::Mode::ReadBinary);
+			if (file.Exists())
+			{
+				auto data = file.Read<U8>();
+				request->state = request->Decode(data) ? 
+					AssetState::Decoded : AssetState::Failed;
+			}
+			else
+			{
+				request->state = AssetState::Failed;
+			}
+
+			events::AssetDecoded decoded;
+			decoded.pathHash = util::MurmurHash(request->path);
+			decoded.succeeded = request->state == AssetState::Decoded;
+			EventManager::Get()->Post(decoded);
+
+			{
+				std::lock_guard<std::mutex> lock(this->completedMutex_);
+				this->completed_.push_back(std::move(request));
+			}
+			this->completedCondition_.notify_one();
+		}
+	}
+
+	bool AssetLoader::CompleteOne()
+	{
+		RequestPtr request;
+
+		{
+			std::lock_guard<std::mutex> lock(this->completedMutex_);
+			if (this->completed_.empty())
+				return false;
+
+			request = std::move(this->completed_.front());
+			this->completed_.pop_front();
+		}
+
+		--this->pending_;
+
+		if (request->state == AssetState::Failed)
+		{
+			LogError("Failed to load asset %.*s", 
+				request->path.size(), request->path.data());
+			request->Fail();
+			return true;
+		}
+
+		request->Complete();
+		request->state = AssetState::Ready;
+
+		return true;
+	}
+}
\ No newline at end of file
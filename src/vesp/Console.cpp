@@ -15,11 +15,11 @@ namespace vesp {
 	{
 		this->module_ = std::make_unique<script::Module>("console");
 
-		InputManager::Get()->Subscribe(
+		this->consoleSubscription_ = InputManager::Get()->Subscribe(
 			Action::Console, this, &Console::ConsolePress);
 
-		EventManager::Get()->Subscribe(
-			"Render.Gui", [&](const void*) { this->Draw(); return true; });
+		this->renderGuiSubscription_ = EventManager::Get()->Subscribe<events::RenderGui>(
+			[&](events::RenderGui const&) { this->Draw(); return true; });
 
 		this->AddCommand("console.history", [&] {
 			return sol::as_table(this->history_);
@@ -28,11 +28,17 @@ namespace vesp {
 
 	Console::~Console()
 	{
+		// Either may already be gone, depending on shutdown order
+		if (auto eventManager = EventManager::Get())
+			eventManager->Unsubscribe(this->renderGuiSubscription_);
+
+		if (auto inputManager = InputManager::Get())
+			inputManager->Unsubscribe(this->consoleSubscription_);
 	}
 
 	void Console::PostInitialisation()
 	{
-		EventManager::Get()->Fire("Console.ReadyForBinding");
+		EventManager::Get()->Fire(events::ConsoleReadyForBinding());
 	}
 
 	void Console::SetActive(bool active)
@@ -55,6 +61,7 @@ namespace vesp {
 
 	void Console::AddMessage(StringView text, graphics::Colour colour)
 	{
+		VESP_MEMORY_SCOPE(Console);
 		this->messages_.push_back({text.CopyToVector(), colour});
 
 		if (this->messages_.size() >= 1024)
@@ -130,6 +137,8 @@ namespace vesp {
 
 	void Console::Execute(StringView code)
 	{
+		VESP_MEMORY_SCOPE(Console);
+
 		// Present command in console
 		auto presentStr = Concat("> ", code);
 		this->AddMessage(presentStr, graphics::Colour::CornflowerBlue);
@@ -64,6 +64,45 @@ namespace vesp
 		fflush(this->file_);
 	}
 
+	FileSystem::MappedFile::MappedFile()
+	{
+	}
+
+	FileSystem::MappedFile::MappedFile(MappedFile&& rhs)
+	{
+		*this = std::move(rhs);
+	}
+
+	FileSystem::MappedFile::~MappedFile()
+	{
+		if (this->Exists())
+			FileSystem::Get()->Unmap(*this);
+	}
+
+	FileSystem::MappedFile& FileSystem::MappedFile::operator=(MappedFile&& rhs)
+	{
+		std::swap(this->file_, rhs.file_);
+		std::swap(this->mapping_, rhs.mapping_);
+		std::swap(this->data_, rhs.data_);
+		std::swap(this->size_, rhs.size_);
+		return *this;
+	}
+
+	ArrayView<U8> FileSystem::MappedFile::GetData()
+	{
+		return ArrayView<U8>(this->data_, this->size_);
+	}
+
+	size_t FileSystem::MappedFile::Size() const
+	{
+		return this->size_;
+	}
+
+	bool FileSystem::MappedFile::Exists() const
+	{
+		return this->data_ != nullptr;
+	}
+
 	FileSystem::File FileSystem::Open(StringView fileName, Mode::Enum mode)
 	{
 		char modeString[3] = { '\0' };
@@ -86,16 +125,101 @@ namespace vesp
 		return File(filePtr);
 	}
 
+	FileSystem::MappedFile FileSystem::Map(StringView fileName)
+	{
+		MappedFile mappedFile;
+
+		auto cString = ToCString(fileName);
+		auto wideString = util::MultiToWide(cString.get());
+
+		auto file = CreateFileW(wideString.data(), GENERIC_READ, FILE_SHARE_READ,
+			nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return mappedFile;
+
+		mappedFile.file_ = file;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			this->Unmap(mappedFile);
+			return mappedFile;
+		}
+
+		auto mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (!mapping)
+		{
+			this->Unmap(mappedFile);
+			return mappedFile;
+		}
+
+		mappedFile.mapping_ = mapping;
+		mappedFile.data_ = static_cast<U8*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+		mappedFile.size_ = static_cast<size_t>(size.QuadPart);
+
+		if (!mappedFile.data_)
+			this->Unmap(mappedFile);
+
+		return mappedFile;
+	}
+
 	void FileSystem::Close(FileSystem::File& file)
 	{
 		fclose(file.file_);
 		file.file_ = nullptr;
 	}
 
+	void FileSystem::Unmap(FileSystem::MappedFile& file)
+	{
+		if (file.data_)
+			UnmapViewOfFile(file.data_);
+
+		if (file.mapping_)
+			CloseHandle(file.mapping_);
+
+		if (file.file_)
+			CloseHandle(file.file_);
+
+		file.data_ = nullptr;
+		file.mapping_ = nullptr;
+		file.file_ = nullptr;
+		file.size_ = 0;
+	}
+
 	bool FileSystem::Exists(StringView fileName) const
 	{
 		auto cString = ToCString(fileName);
 		auto wideString = util::MultiToWide(cString.get());
 		return GetFileAttributesW(wideString.data()) != INVALID_FILE_ATTRIBUTES;
 	}
+
+	U64 FileSystem::GetModifiedTime(StringView fileName) const
+	{
+		auto cString = ToCString(fileName);
+		auto wideString = util::MultiToWide(cString.get());
+
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesExW(wideString.data(), GetFileExInfoStandard, &attributes))
+			return 0;
+
+		auto& time = attributes.ftLastWriteTime;
+		return (U64(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+	}
+
+	bool FileSystem::MakeDirectory(StringView path)
+	{
+		auto cString = ToCString(path);
+		auto wideString = util::MultiToWide(cString.get());
+		return CreateDirectoryW(wideString.data(), nullptr) || 
+			GetLastError() == ERROR_ALREADY_EXISTS;
+	}
+
+	bool FileSystem::Rename(StringView from, StringView to)
+	{
+		auto fromCString = ToCString(from);
+		auto toCString = ToCString(to);
+		auto fromWide = util::MultiToWide(fromCString.get());
+		auto toWide = util::MultiToWide(toCString.get());
+		return MoveFileExW(fromWide.data(), toWide.data(), MOVEFILE_REPLACE_EXISTING) != 0;
+	}
 }
@@ -0,0 +1,226 @@
+#include "vesp/FileWatcher.hpp"
+#include "vesp/FileSystem.hpp"
+#include "vesp/Profiler.hpp"
+#include "vesp/Log.hpp"
+
+#include "vesp/util/StringConversion.hpp"
+
+#include <Windows.h>
+
+namespace vesp
+{
+	FileWatcher::FileWatcher(StringView root)
+	{
+		this->root_ = root.CopyToVector();
+
+		if (!this->StartNotifications())
+		{
+			LogWarn("Change notifications unavailable for %.*s, polling instead",
+				this->root_.size(), this->root_.data());
+		}
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		this->StopNotifications();
+	}
+
+	void FileWatcher::Watch(StringView path, Callback callback)
+	{
+		auto& file = this->files_[this->GetKey(path)];
+		if (file.path.empty())
+		{
+			file.path = path.CopyToVector();
+			file.modifiedTime = FileSystem::Get()->GetModifiedTime(path);
+		}
+
+		file.callbacks.push_back(std::move(callback));
+	}
+
+	bool FileWatcher::IsWatched(StringView path) const
+	{
+		return this->files_.find(this->GetKey(path)) != this->files_.end();
+	}
+
+	void FileWatcher::Pulse()
+	{
+		VESP_PROFILE_FN();
+
+		if (this->directory_)
+			this->ReadNotifications();
+		else
+			this->PollModifiedTimes();
+
+		auto now = this->clock_.GetMilliseconds();
+		Vector<String> changed;
+
+		for (auto& filePair : this->files_)
+		{
+			auto& file = filePair.second;
+			if (file.changedAt < 0.0f || now - file.changedAt < DebounceMilliseconds)
+				continue;
+
+			file.changedAt = -1.0f;
+
+			// Notifications also arrive for writes that leave the file as it
+			// was, such as touching it from another program
+			auto modifiedTime = FileSystem::Get()->GetModifiedTime(file.path);
+			if (modifiedTime == file.modifiedTime)
+				continue;
+
+			file.modifiedTime = modifiedTime;
+			changed.push_back(filePair.first);
+		}
+
+		// Callbacks may watch further files, so they run outside the loop
+		for (auto& key : changed)
+		{
+			auto file = this->files_[key];
+
+			LogInfo("Detected change to %.*s", file.path.size(), file.path.data());
+			for (auto& callback : file.callbacks)
+				callback(file.path);
+		}
+	}
+
+	String FileWatcher::GetKey(StringView path) const
+	{
+		String normalised = path.CopyToVector();
+		for (auto& c : normalised)
+		{
+			if (c == '\\')
+				c = '/';
+			else if (c >= 'A' && c <= 'Z')
+				c = StringByte(c - 'A' + 'a');
+		}
+
+		return normalised;
+	}
+
+	void FileWatcher::MarkChanged(StringView path)
+	{
+		auto it = this->files_.find(this->GetKey(path));
+		if (it == this->files_.end())
+			return;
+
+		it->second.changedAt = this->clock_.GetMilliseconds();
+	}
+
+	void FileWatcher::MarkAllChanged()
+	{
+		auto now = this->clock_.GetMilliseconds();
+		for (auto& filePair : this->files_)
+			filePair.second.changedAt = now;
+	}
+
+	bool FileWatcher::StartNotifications()
+	{
+		auto cString = ToCString(this->root_);
+		auto wideString = util::MultiToWide(cString.get());
+
+		auto directory = CreateFileW(wideString.data(), FILE_LIST_DIRECTORY,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, 
+			OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if (directory == INVALID_HANDLE_VALUE)
+			return false;
+
+		this->directory_ = directory;
+		this->overlapped_.reset(new OVERLAPPED{});
+		this->buffer_.resize(16 * 1024);
+
+		if (!this->QueueNotifications())
+		{
+			this->StopNotifications();
+			return false;
+		}
+
+		return true;
+	}
+
+	void FileWatcher::StopNotifications()
+	{
+		if (!this->directory_)
+			return;
+
+		CancelIo(this->directory_);
+		CloseHandle(this->directory_);
+
+		this->directory_ = nullptr;
+		this->overlapped_.reset();
+		this->buffer_.clear();
+	}
+
+	bool FileWatcher::QueueNotifications()
+	{
+		return ReadDirectoryChangesW(this->directory_, 
+			this->buffer_.data(), DWORD(this->buffer_.size() * sizeof(U32)), TRUE,
+			FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+			nullptr, this->overlapped_.get(), nullptr) != 0;
+	}
+
+	void FileWatcher::ReadNotifications()
+	{
+		DWORD bytes = 0;
+		if (!GetOverlappedResult(this->directory_, this->overlapped_.get(), &bytes, FALSE))
+		{
+			if (GetLastError() == ERROR_IO_INCOMPLETE)
+				return;
+
+			LogWarn("Lost change notifications for %.*s, polling instead",
+				this->root_.size(), this->root_.data());
+			this->StopNotifications();
+			this->MarkAllChanged();
+			return;
+		}
+
+		// A zero-sized result means the buffer overflowed and the changes
+		// were dropped, so every file has to be treated as changed
+		if (bytes == 0)
+			this->MarkAllChanged();
+
+		auto data = reinterpret_cast<U8*>(this->buffer_.data());
+		for (DWORD offset = 0; bytes != 0;)
+		{
+			auto info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(data + offset);
+
+			WideString fileName(info->FileName, 
+				info->FileName + info->FileNameLength / sizeof(wchar_t));
+			fileName.push_back(L'\0');
+
+			auto path = this->root_;
+			path.push_back('/');
+			Concat(path, util::WideToMulti(fileName.data()));
+			this->MarkChanged(path);
+
+			if (info->NextEntryOffset == 0)
+				break;
+
+			offset += info->NextEntryOffset;
+		}
+
+		if (!this->QueueNotifications())
+		{
+			this->StopNotifications();
+			this->MarkAllChanged();
+		}
+	}
+
+	void FileWatcher::PollModifiedTimes()
+	{
+		auto now = this->clock_.GetMilliseconds();
+		if (now - this->lastPoll_ < PollMilliseconds)
+			return;
+
+		this->lastPoll_ = now;
+
+		for (auto& filePair : this->files_)
+		{
+			auto& file = filePair.second;
+			if (file.changedAt >= 0.0f)
+				continue;
+
+			if (FileSystem::Get()->GetModifiedTime(file.path) != file.modifiedTime)
+				file.changedAt = now;
+		}
+	}
+}
\ No newline at end of file
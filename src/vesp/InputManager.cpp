@@ -20,18 +20,23 @@ namespace vesp
 	{
 		this->state_.assign(0);
 
-		EventManager::Get()->Subscribe("Console.ReadyForBinding", [&](const void*)
+		this->bindConsoleSubscription_ = EventManager::Get()->Subscribe<events::ConsoleReadyForBinding>([&](events::ConsoleReadyForBinding const&)
 		{
 			this->BindConsole();
 			return true;
 		});
 
-		EventManager::Get()->Subscribe(
-			"Render.Gui", [&](const void*) { this->Draw(); return true; });
+		this->renderGuiSubscription_ = EventManager::Get()->Subscribe<events::RenderGui>(
+			[&](events::RenderGui const&) { this->Draw(); return true; });
 	}
 
 	InputManager::~InputManager()
 	{
+		if (auto eventManager = EventManager::Get())
+		{
+			eventManager->Unsubscribe(this->bindConsoleSubscription_);
+			eventManager->Unsubscribe(this->renderGuiSubscription_);
+		}
 	}
 
 	void InputManager::FeedEvent(MSG const* event)
@@ -118,11 +123,9 @@ namespace vesp
 
 		if (oldValue != newValue)
 		{
-			for (auto& v : this->callbacks_[static_cast<U32>(action)])
-			{
-				auto handler = v.handler;
-				(v.instance->*handler)(state);
-			}
+			this->callbacks_[static_cast<U32>(action)].Visit([&](InputHandler const& handler) {
+				handler(state);
+			});
 		}
 	}
 
@@ -222,9 +225,16 @@ namespace vesp
 		return this->guiLockCount_ > 0;
 	}
 
-	void InputManager::SubscribeInternal(Action action, InputHandler* instance, InputHandler::Function handler)
+	util::Subscription InputManager::Subscribe(Action action, InputHandler handler)
+	{
+		auto slot = static_cast<U32>(action);
+		return {slot, this->callbacks_[slot].Add(handler)};
+	}
+
+	void InputManager::Unsubscribe(util::Subscription subscription)
 	{
-		this->callbacks_[static_cast<U32>(action)].push_back({instance, handler});
+		VESP_ASSERT(subscription.slot < static_cast<U32>(Action::EndOfEnum));
+		this->callbacks_[subscription.slot].Remove(subscription.id);
 	}
 
 	void InputManager::Draw()
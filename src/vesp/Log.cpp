@@ -2,7 +2,9 @@
 #include "vesp/Util.hpp"
 
 #include "vesp/Console.hpp"
+#include "vesp/Profiler.hpp"
 
+#include <chrono>
 #include <cstdarg>
 #include <ctime>
 
@@ -12,52 +14,351 @@ namespace vesp
 	const char* LogTypeStrings[] = { VESP_LOG_TYPES };
 #undef LOG_TYPE
 
+	namespace
+	{
+		// How long the writer sleeps when nothing asks it to wake
+		const U32 WriterIntervalMs = 10;
+
+		RawStringPtr BinaryLogPath = "log.bin";
+	}
+
 	Logger::Logger(RawStringPtr path) :
-		logFile_(FileSystem::Get()->Open(path, FileSystem::Mode::Append))
+		logFile_(FileSystem::Get()->Open(path, FileSystem::Mode::Append)),
+		records_(RecordCount),
+		writePos_(0),
+		binaryMode_(false)
 	{
+		static_assert((RecordCount & (RecordCount - 1)) == 0, "RecordCount must be a power of two");
+
+		for (U32 i = 0; i < RecordCount; ++i)
+			this->records_[i].sequence.store(i, std::memory_order_relaxed);
+
+		this->writer_ = std::thread([this] { this->WriterMain(); });
 	}
 
 	Logger::~Logger()
 	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex_);
+			this->quit_ = true;
+		}
+		this->wakeCondition_.notify_one();
+		this->writer_.join();
+
 		FileSystem::Get()->Close(this->logFile_);
 	}
 
 	void Logger::WriteLog(LogType type, RawStringPtr fmt, ...)
 	{
-		static StringByte tempBuffer[4096];
-		static StringByte finalBuffer[4500];
-		static StringByte timeBuffer[32];
-
-		time_t rawTime;
-		tm timeInfo;
+		auto pos = this->Claim();
+		auto& record = this->records_[pos & (RecordCount - 1)];
 
-		time(&rawTime);
-		localtime_s(&timeInfo, &rawTime);
+		record.time = GetTime();
+		record.type = type;
+		record.format = nullptr;
 
 		va_list args;
 		va_start(args, fmt);
+		vsnprintf_s(record.text, _TRUNCATE, fmt, args);
+		va_end(args);
+
+		this->Publish(pos, type);
+	}
+
+	void Logger::Flush()
+	{
+		auto target = this->writePos_.load();
+
+		// The writer can assert too; it has nothing to wait for
+		if (std::this_thread::get_id() == this->writer_.get_id())
+			return;
+
+		this->Wake(true);
+
+		std::unique_lock<std::mutex> lock(this->mutex_);
+		this->writtenCondition_.wait(lock, [&] {
+			return this->writtenPos_ >= target;
+		});
+	}
+
+	void Logger::Pulse()
+	{
+		VESP_PROFILE_FN();
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex_);
+			this->consoleMessages_.swap(this->pendingMessages_);
+		}
+
+		// Lines logged before the console existed are shown once it does
+		auto console = Console::Get();
+		if (!console)
+			return;
+
+		for (auto& message : this->consoleMessages_)
+		{
+			auto col = graphics::Colour::White;
+
+			if (message.type == LogType::Warn)
+				col = graphics::Colour::Orange;
+			else if (message.type == LogType::Error)
+				col = graphics::Colour::OrangeRed;
+			else if (message.type == LogType::Fatal)
+				col = graphics::Colour::Red;
+
+			console->AddMessage(message.text, col);
+		}
+
+		this->consoleMessages_.clear();
+	}
+
+	Vector<String> Logger::GetRecentLines() const
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		return Vector<String>(this->recentLines_.begin(), this->recentLines_.end());
+	}
+
+	void Logger::SetBinaryMode(bool enabled)
+	{
+		this->binaryMode_ = enabled;
+		this->Wake(true);
+	}
+
+	void Logger::BindConsole()
+	{
+		Console::Get()->AddCommand("log.binary", [&](bool enabled) {
+			this->SetBinaryMode(enabled);
+		});
+
+		Console::Get()->AddCommand("log.decode", [&](std::string path) {
+			// Lines still on their way to the file are left out otherwise
+			if (path == BinaryLogPath)
+				this->Flush();
+
+			auto outputPath = path + ".txt";
+			if (BinaryLog::Decode(path, outputPath))
+				LogInfo("Decoded %s to %s", path.c_str(), outputPath.c_str());
+			else
+				LogError("Failed to decode binary log %s", path.c_str());
+		});
+	}
+
+	RawStringPtr Logger::GetTypeName(LogType type)
+	{
+		auto index = static_cast<U8>(type);
+		return index < util::SizeOfArray(LogTypeStrings) ? LogTypeStrings[index] : "Unknown";
+	}
 
-		std::strftime(timeBuffer, util::SizeOfArray(timeBuffer), 
-			"%H:%M:%S", &timeInfo);
+	U64 Logger::GetTime()
+	{
+		using namespace std::chrono;
+		return U64(duration_cast<microseconds>(system_clock::now().time_since_epoch()).count());
+	}
 
-		vsnprintf_s(tempBuffer, _TRUNCATE, fmt, args);
+	U64 Logger::Claim()
+	{
+		auto pos = this->writePos_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			auto& record = this->records_[pos & (RecordCount - 1)];
+			auto sequence = record.sequence.load(std::memory_order_acquire);
+			auto difference = S64(sequence - pos);
 
-		sprintf_s(finalBuffer, "%s | %s | %s\n", 
-			timeBuffer, LogTypeStrings[static_cast<U8>(type)], tempBuffer);
+			if (difference == 0)
+			{
+				if (this->writePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					return pos;
+			}
+			else if (difference < 0)
+			{
+				// The ring is full; wait for the writer to catch up
+				this->Wake(false);
+				std::this_thread::yield();
+				pos = this->writePos_.load(std::memory_order_relaxed);
+			}
+			else
+			{
+				pos = this->writePos_.load(std::memory_order_relaxed);
+			}
+		}
+	}
 
-		auto len = strlen(finalBuffer);
-		auto col = graphics::Colour::White;
+	void Logger::Publish(U64 pos, LogType type)
+	{
+		this->records_[pos & (RecordCount - 1)].sequence.store(pos + 1, std::memory_order_release);
 
-		if (type == LogType::Warn)
-			col = graphics::Colour::Orange;
+		if (type == LogType::Fatal)
+			this->Flush();
 		else if (type == LogType::Error)
-			col = graphics::Colour::OrangeRed;
-		else if (type == LogType::Fatal)
-			col = graphics::Colour::Red;
+			this->Wake(true);
+	}
+
+	void Logger::Wake(bool flush)
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex_);
+			this->wakeRequested_ = true;
+			this->flushRequested_ |= flush;
+		}
+		this->wakeCondition_.notify_one();
+	}
+
+	void Logger::WriterMain()
+	{
+		Profiler::SetThreadName("Logger");
+		VESP_MEMORY_SCOPE(Console);
+
+		String batch;
+		util::Timer sinceFlush;
+		bool unflushed = false;
+
+		for (;;)
+		{
+			bool quit, flush;
+			{
+				std::unique_lock<std::mutex> lock(this->mutex_);
+				this->wakeCondition_.wait_for(lock, std::chrono::milliseconds(WriterIntervalMs), [&] {
+					return this->quit_ || this->wakeRequested_;
+				});
+
+				quit = this->quit_;
+				flush = this->flushRequested_;
+				this->wakeRequested_ = false;
+				this->flushRequested_ = false;
+			}
+
+			// A mode change applies to the lines drained after it is seen
+			auto binaryMode = this->binaryMode_.load() && !quit;
+			StringByte error[128] = {};
+			if (binaryMode && !this->binaryLog_)
+			{
+				this->binaryLog_ = std::make_unique<BinaryLog>(BinaryLogPath, GetTime());
+				if (!this->binaryLog_->Exists())
+				{
+					this->binaryLog_.reset();
+					this->binaryMode_ = false;
+					binaryMode = false;
+
+					// LogError would wait on this thread for a free record
+					sprintf_s(error, "Failed to open binary log %s", BinaryLogPath);
+				}
+			}
+
+			batch.clear();
+			flush |= this->Drain(batch, error[0] ? error : nullptr);
+
+			if (!batch.empty())
+			{
+				this->logFile_.Write(ArrayView<U8>(reinterpret_cast<U8*>(batch.data()), batch.size()));
+				unflushed = true;
+			}
+
+			auto flushNow = flush || quit || sinceFlush.GetMilliseconds() >= FlushIntervalMs;
+			if (this->binaryLog_)
+				this->binaryLog_->Write(flushNow);
+
+			if (!binaryMode)
+				this->binaryLog_.reset();
+
+			if (unflushed && flushNow)
+			{
+				this->logFile_.Flush();
+				sinceFlush.Restart();
+				unflushed = false;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(this->mutex_);
+				this->writtenPos_ = this->readPos_;
+			}
+			this->writtenCondition_.notify_all();
+
+			if (quit)
+				return;
+		}
+	}
+
+	bool Logger::Drain(String& batch, RawStringPtr writerError)
+	{
+		StringByte line[MaxMessageLength + 64];
+		StringByte message[MaxMessageLength];
+		StringByte timeBuffer[32];
+		time_t lastTime = 0;
+		bool flush = false;
+
+		Vector<Message> messages;
+
+		auto addLine = [&](U64 time, LogType type, RawStringPtr text)
+		{
+			auto seconds = time_t(time / 1000000);
+			if (seconds != lastTime || !lastTime)
+			{
+				tm timeInfo;
+				localtime_s(&timeInfo, &seconds);
+				std::strftime(timeBuffer, util::SizeOfArray(timeBuffer), "%H:%M:%S", &timeInfo);
+				lastTime = seconds;
+			}
+
+			auto length = sprintf_s(line, "%s | %s | %s\n",
+				timeBuffer, GetTypeName(type), text);
+			auto view = StringView(line, length > 0 ? length : 0);
+
+			batch.insert(batch.end(), view.begin(), view.end());
+			messages.push_back({view.CopyToVector(), type});
+		};
+
+		if (writerError)
+		{
+			addLine(GetTime(), LogType::Error, writerError);
+			flush = true;
+		}
+
+		for (;;)
+		{
+			auto& record = this->records_[this->readPos_ & (RecordCount - 1)];
+			if (record.sequence.load(std::memory_order_acquire) != this->readPos_ + 1)
+				break;
+
+			auto releaseRecord = [&] {
+				// Hand the record back to the producers
+				record.sequence.store(this->readPos_ + RecordCount, std::memory_order_release);
+				++this->readPos_;
+			};
+
+			flush |= record.type >= LogType::Error;
+
+			RawStringPtr text = record.text;
+			if (record.format)
+			{
+				auto arguments = ArrayView<U8>(reinterpret_cast<U8*>(record.text), record.length);
+				if (this->binaryLog_)
+				{
+					this->binaryLog_->Add(record.time, U8(record.type), record.format, arguments);
+					releaseRecord();
+					continue;
+				}
+
+				LogArguments::Format(message, util::SizeOfArray(message), record.format, arguments);
+				text = message;
+			}
+
+			addLine(record.time, record.type, text);
+			releaseRecord();
+		}
+
+		if (messages.empty())
+			return flush;
+
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		for (auto& message : messages)
+		{
+			this->recentLines_.push_back(message.text);
+			if (this->recentLines_.size() > MaxRecentLines)
+				this->recentLines_.pop_front();
 
-		Console::Get()->AddMessage(StringView(finalBuffer, len), col);
+			this->pendingMessages_.push_back(std::move(message));
+		}
 
-		this->logFile_.Write(ArrayView<U8>(reinterpret_cast<U8*>(finalBuffer), len));
-		this->logFile_.Flush();
+		return flush;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,388 @@
+#include "vesp/LogBinary.hpp"
+#include "vesp/Log.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+namespace vesp
+{
+	namespace
+	{
+		bool ReadVarint(ArrayView<U8> data, size_t& offset, U64& value)
+		{
+			value = 0;
+			for (U32 shift = 0; offset < data.size() && shift < 64; shift += 7)
+			{
+				auto byte = data[offset++];
+				value |= U64(byte & 0x7F) << shift;
+				if (!(byte & 0x80))
+					return true;
+			}
+
+			return false;
+		}
+
+		// Formats one conversion into the end of `out`, advancing `length`
+		template <typename T>
+		void FormatValue(StringByte* out, size_t capacity, size_t& length,
+			StringByte const* spec, T value)
+		{
+			auto written = snprintf(out + length, capacity - length, spec, value);
+			if (written > 0)
+				length = std::min(length + size_t(written), capacity - 1);
+		}
+	}
+
+	void LogArguments::Add(RawStringPtr value)
+	{
+		if (!value)
+			value = "(null)";
+
+		this->AddString(value, strlen(value));
+	}
+
+	void LogArguments::Add(StringByte* value)
+	{
+		this->Add(RawStringPtr(value));
+	}
+
+	void LogArguments::Add(StringView value)
+	{
+		this->AddString(value.data(), value.size());
+	}
+
+	size_t LogArguments::GetSize() const
+	{
+		return this->size_;
+	}
+
+	void LogArguments::AddString(StringByte const* data, size_t length)
+	{
+		if (this->size_ + 2 > this->capacity_)
+			return;
+
+		// Long strings are cut short rather than dropped
+		length = std::min(length, this->capacity_ - this->size_ - 2);
+
+		this->data_[this->size_++] = Text;
+		std::memcpy(this->data_ + this->size_, data, length);
+		this->size_ += length;
+		this->data_[this->size_++] = 0;
+	}
+
+	size_t LogArguments::Format(StringByte* out, size_t capacity, RawStringPtr fmt, ArrayView<U8> arguments)
+	{
+		size_t length = 0;
+		size_t offset = 0;
+
+		while (*fmt && length + 1 < capacity)
+		{
+			if (*fmt != '%')
+			{
+				out[length++] = *fmt++;
+				continue;
+			}
+
+			if (fmt[1] == '%')
+			{
+				out[length++] = '%';
+				fmt += 2;
+				continue;
+			}
+
+			// Keep the flags, width and precision; the length modifier and
+			// conversion are chosen from the packed type
+			auto start = fmt;
+			StringByte spec[32];
+			size_t specLength = 0;
+
+			spec[specLength++] = *fmt++;
+			while (*fmt && strchr("-+ #0123456789.", *fmt) && specLength < 24)
+				spec[specLength++] = *fmt++;
+
+			while (*fmt && strchr("hljztLqI", *fmt))
+			{
+				// MSVC's I32 and I64
+				if (*fmt == 'I')
+				{
+					while (*++fmt && *fmt >= '0' && *fmt <= '9')
+						;
+				}
+				else
+				{
+					++fmt;
+				}
+			}
+
+			if (!*fmt)
+				break;
+
+			auto conversion = *fmt++;
+			if (offset >= arguments.size())
+			{
+				auto skipped = std::min(size_t(fmt - start), capacity - 1 - length);
+				std::memcpy(out + length, start, skipped);
+				length += skipped;
+				continue;
+			}
+
+			auto type = arguments[offset++];
+			auto value = arguments.data() + offset;
+			auto remaining = arguments.size() - offset;
+
+			// Arguments are only ever cut short by a damaged file
+			auto valueSize = type == Text ? strnlen(reinterpret_cast<RawStringPtr>(value), remaining) + 1 : sizeof(U64);
+			if (valueSize > remaining)
+				break;
+
+			auto isInteger = strchr("diouxXc", conversion) != nullptr;
+			auto isFloat = strchr("eEfFgGaA", conversion) != nullptr;
+
+			switch (type)
+			{
+			case Signed:
+			case Unsigned:
+			{
+				U64 bits;
+				std::memcpy(&bits, value, sizeof(bits));
+				offset += sizeof(bits);
+
+				if (conversion == 'c')
+				{
+					spec[specLength++] = 'c';
+					spec[specLength] = 0;
+					FormatValue(out, capacity, length, spec, int(bits));
+					break;
+				}
+
+				if (!isInteger)
+					conversion = type == Signed ? 'd' : 'u';
+
+				spec[specLength++] = 'l';
+				spec[specLength++] = 'l';
+				spec[specLength++] = conversion;
+				spec[specLength] = 0;
+
+				if (type == Signed)
+					FormatValue(out, capacity, length, spec, (long long)(S64(bits)));
+				else
+					FormatValue(out, capacity, length, spec, (unsigned long long)(bits));
+				break;
+			}
+
+			case Float:
+			{
+				F64 number;
+				std::memcpy(&number, value, sizeof(number));
+				offset += sizeof(number);
+
+				spec[specLength++] = isFloat ? conversion : 'f';
+				spec[specLength] = 0;
+				FormatValue(out, capacity, length, spec, number);
+				break;
+			}
+
+			case Pointer:
+			{
+				U64 bits;
+				std::memcpy(&bits, value, sizeof(bits));
+				offset += sizeof(bits);
+
+				spec[specLength++] = 'p';
+				spec[specLength] = 0;
+				FormatValue(out, capacity, length, spec, reinterpret_cast<void*>(uintptr_t(bits)));
+				break;
+			}
+
+			case Text:
+			{
+				auto string = reinterpret_cast<RawStringPtr>(value);
+				offset += strlen(string) + 1;
+
+				spec[specLength++] = 's';
+				spec[specLength] = 0;
+				FormatValue(out, capacity, length, spec, string);
+				break;
+			}
+
+			default:
+				// Unknown type; nothing after it can be trusted
+				offset = arguments.size();
+				break;
+			}
+		}
+
+		out[length] = 0;
+		return length;
+	}
+
+	BinaryLog::BinaryLog(StringView path, U64 startTime) :
+		file_(FileSystem::Get()->Open(path, FileSystem::Mode::Enum(FileSystem::Mode::Write | FileSystem::Mode::Binary))),
+		lastTime_(startTime)
+	{
+		LogFileHeader header;
+		header.magic = LogFileHeader::Magic;
+		header.version = LogFileHeader::CurrentVersion;
+		header.startTime = startTime;
+
+		auto bytes = reinterpret_cast<U8 const*>(&header);
+		this->buffer_.insert(this->buffer_.end(), bytes, bytes + sizeof(header));
+	}
+
+	BinaryLog::~BinaryLog()
+	{
+		// The writer drops a log that failed to open
+		if (!this->Exists())
+			return;
+
+		this->Write(true);
+		FileSystem::Get()->Close(this->file_);
+	}
+
+	bool BinaryLog::Exists() const
+	{
+		return this->file_.Exists();
+	}
+
+	void BinaryLog::Add(U64 time, U8 type, RawStringPtr format, ArrayView<U8> arguments)
+	{
+		auto formatId = this->GetFormatId(format);
+
+		// Lines from different threads can arrive slightly out of order
+		time = std::max(time, this->lastTime_);
+
+		this->buffer_.push_back(1);
+		this->WriteVarint(time - this->lastTime_);
+		this->WriteVarint(type);
+		this->WriteVarint(formatId);
+		this->WriteVarint(arguments.size());
+		this->buffer_.insert(this->buffer_.end(), arguments.begin(), arguments.end());
+
+		this->lastTime_ = time;
+	}
+
+	void BinaryLog::Write(bool flush)
+	{
+		if (!this->buffer_.empty())
+		{
+			this->file_.Write(this->buffer_);
+			this->buffer_.clear();
+		}
+
+		if (flush)
+			this->file_.Flush();
+	}
+
+	bool BinaryLog::Decode(StringView path, StringView outputPath)
+	{
+		auto file = FileSystem::Get()->Open(path, FileSystem::Mode::ReadBinary);
+		if (!file.Exists() || file.Size() < sizeof(LogFileHeader))
+			return false;
+
+		auto data = file.Read<U8>();
+
+		LogFileHeader header;
+		std::memcpy(&header, data.data(), sizeof(header));
+		if (header.magic != LogFileHeader::Magic || header.version != LogFileHeader::CurrentVersion)
+			return false;
+
+		auto output = FileSystem::Get()->Open(outputPath,
+			FileSystem::Mode::Enum(FileSystem::Mode::Write | FileSystem::Mode::Binary));
+		if (!output.Exists())
+			return false;
+
+		UnorderedMap<U64, String> formats;
+		String text;
+		StringByte message[Logger::MaxMessageLength + 64];
+		StringByte line[Logger::MaxMessageLength + 128];
+
+		auto view = ArrayView<U8>(data);
+		size_t offset = sizeof(header);
+		U64 time = header.startTime;
+
+		while (offset < view.size())
+		{
+			auto tag = view[offset++];
+			U64 id, length;
+
+			if (tag == 0)
+			{
+				if (!ReadVarint(view, offset, id) || !ReadVarint(view, offset, length) ||
+					length > view.size() - offset)
+					break;
+
+				auto& format = formats[id];
+				format.assign(view.data() + offset, view.data() + offset + length);
+				format.push_back(0);
+				offset += length;
+			}
+			else if (tag == 1)
+			{
+				U64 delta, type;
+				if (!ReadVarint(view, offset, delta) || !ReadVarint(view, offset, type) ||
+					!ReadVarint(view, offset, id) || !ReadVarint(view, offset, length) ||
+					length > view.size() - offset)
+					break;
+
+				time += delta;
+				auto arguments = ArrayView<U8>(view.data() + offset, length);
+				offset += length;
+
+				auto format = formats.find(id);
+				if (format == formats.end())
+					continue;
+
+				LogArguments::Format(message, sizeof(message), format->second.data(), arguments);
+
+				auto seconds = time_t(time / 1000000);
+				tm timeInfo;
+				localtime_s(&timeInfo, &seconds);
+
+				StringByte timeBuffer[32];
+				std::strftime(timeBuffer, sizeof(timeBuffer), "%H:%M:%S", &timeInfo);
+
+				auto lineLength = sprintf_s(line, "%s.%06u | %s | %s\n", timeBuffer, U32(time % 1000000),
+					Logger::GetTypeName(LogType(type)), message);
+				if (lineLength > 0)
+					text.insert(text.end(), line, line + lineLength);
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		output.Write(ArrayView<U8>(reinterpret_cast<U8*>(text.data()), text.size()));
+		FileSystem::Get()->Close(output);
+		return true;
+	}
+
+	void BinaryLog::WriteVarint(U64 value)
+	{
+		while (value >= 0x80)
+		{
+			this->buffer_.push_back(U8(value | 0x80));
+			value >>= 7;
+		}
+		this->buffer_.push_back(U8(value));
+	}
+
+	U32 BinaryLog::GetFormatId(RawStringPtr format)
+	{
+		auto it = this->formatIds_.find(format);
+		if (it != this->formatIds_.end())
+			return it->second;
+
+		auto id = U32(this->formatIds_.size()) + 1;
+		this->formatIds_[format] = id;
+
+		auto length = strlen(format);
+		this->buffer_.push_back(0);
+		this->WriteVarint(id);
+		this->WriteVarint(length);
+		this->buffer_.insert(this->buffer_.end(), format, format + length);
+
+		return id;
+	}
+}
\ No newline at end of file
@@ -1,9 +1,13 @@
 #include "vesp/Main.hpp"
+#include "vesp/AssetLoader.hpp"
+#include "vesp/ResourceCache.hpp"
 #include "vesp/Log.hpp"
 #include "vesp/Console.hpp"
 #include "vesp/EventManager.hpp"
 #include "vesp/FileSystem.hpp"
+#include "vesp/FileWatcher.hpp"
 #include "vesp/InputManager.hpp"
+#include "vesp/Metrics.hpp"
 #include "vesp/Profiler.hpp"
 
 #include "vesp/graphics/Engine.hpp"
@@ -18,6 +22,8 @@ namespace vesp
 {
 	util::Timer GlobalTimer;
 
+	Counter FrameCount("frames", "Frames run");
+
 	bool Initialize(RawStringPtr name)
 	{
 		GlobalTimer.Restart();
@@ -25,11 +31,24 @@ namespace vesp
 		FileSystem::Create();
 		Logger::Create("log.txt");
 
+		util::CycleClock::Calibrate();
+		if (util::CycleClock::UsesCounter())
+			LogInfo("Timestamps: invariant TSC at %.3f GHz", 1e-9 / util::CycleClock::GetSecondsPerTick());
+		else
+			LogInfo("Timestamps: steady clock (no invariant TSC)");
+
 		EventManager::Create();
 		InputManager::Create();
+		AssetLoader::Create();
 
 		Console::Create();
 		Console::Get()->PostInitialisation();
+		Logger::Get()->BindConsole();
+
+		Metrics::Create();
+
+		ResourceCache::Create();
+		FileWatcher::Create("data");
 
 		LogInfo("Vespertine (%s %s)", __DATE__, __TIME__);
 		
@@ -39,6 +58,11 @@ namespace vesp
 		world::HeightMapTerrain::Create();
 		world::Script::Create();
 
+		// Everything above only queued its file reads and decoding; wait for
+		// the workers so the first frame has all of its assets
+		AssetLoader::Get()->Flush();
+		LogInfo("Initialised in %.2f ms", GlobalTimer.GetMilliseconds());
+
 		Profiler::Create();
 
 		Console::Get()->AddCommand("quit", &vesp::Quit);
@@ -48,15 +72,22 @@ namespace vesp
 
 	void Shutdown()
 	{
+		// Stop the workers first; pending callbacks refer to the systems below
+		AssetLoader::Destroy();
 		Profiler::Destroy();
 
 		world::Script::Destroy();
 		world::HeightMapTerrain::Destroy();
 
+		FileWatcher::Destroy();
+		ResourceCache::Destroy();
+
 		graphics::Engine::Destroy();
 
 		EventManager::Destroy();
 
+		Metrics::Destroy();
+
 		LogInfo("Vespertine shutting down");
 		Logger::Destroy();
 		Console::Destroy();
@@ -99,23 +130,33 @@ namespace vesp
 
 			HandleWindowsMessages();
 
+			FileWatcher::Get()->Pulse();
+			AssetLoader::Get()->Pulse();
+			EventManager::Get()->DispatchQueued();
+			Logger::Get()->Pulse();
 			world::Script::Get()->Pulse();
 			graphics::Engine::Get()->Pulse();
 
+			Profiler::Get()->EndFrame();
+
+			FrameCount.Add();
+			MemoryTracker::EndFrame();
+			Metrics::Get()->Pulse();
+
+			// Throttling is idle time, not frame work, so it stays out of the
+			// profile and never reads as a hitch
 			if (!graphics::Engine::Get()->GetWindow()->HasFocus())
 			{
 				S32 sleepMs = std::max(0, 100*1000 - frameTimer.GetMicroseconds<S32>())/1000;
 				Sleep(sleepMs);
 			}
-
-			Profiler::Get()->EndFrame();
 		}
 	}
 
 	void Quit()
 	{
 		Running = false;
-		EventManager::Get()->Fire("Engine.Quit");
+		EventManager::Get()->Fire(events::EngineQuit());
 	}
 
 	util::Timer const& GetGlobalTimer()
@@ -0,0 +1,162 @@
+#include "vesp/Memory.hpp"
+#include "vesp/Metrics.hpp"
+
+#include "vesp/graphics/imgui.h"
+
+#include <algorithm>
+#include <malloc.h>
+
+namespace vesp
+{
+	namespace
+	{
+		// Precedes every allocation so that it can be freed from its tag
+		struct AllocationHeader
+		{
+			U64 size;
+			U32 offset;
+			U32 tag;
+		};
+
+		static_assert(sizeof(AllocationHeader) == 16, "Header must keep 16 byte alignment");
+
+		RawStringPtr TagNames[MemoryTag::Count] = {
+			"General", "Graphics", "Terrain", "Scalar field", "Script",
+			"Lua", "Console", "Assets", "Profiler"
+		};
+
+		// Counters and gauges are registered during static initialisation,
+		// so allocations before then are only fed to them at frame ends
+		Counter Allocations("allocations", "Tracked memory allocations");
+
+		Gauge TagGauges[MemoryTag::Count] = {
+			{"memory_general_bytes", "Live bytes not attributed to a subsystem"},
+			{"memory_graphics_bytes", "Live bytes of the renderer"},
+			{"memory_terrain_bytes", "Live bytes of the height map terrain"},
+			{"memory_scalar_field_bytes", "Live bytes of scalar fields"},
+			{"memory_script_bytes", "Live bytes of the world script bindings"},
+			{"memory_lua_bytes", "Live bytes of the Lua heap"},
+			{"memory_console_bytes", "Live bytes of the console and log"},
+			{"memory_assets_bytes", "Live bytes of asset loading and caching"},
+			{"memory_profiler_bytes", "Live bytes of the profiler"}
+		};
+	}
+
+	thread_local MemoryTag::Enum MemoryTracker::currentTag_ = MemoryTag::General;
+	MemoryTracker::Tag MemoryTracker::tags_[MemoryTag::Count];
+
+	void* MemoryTracker::Allocate(size_t size, size_t alignment)
+	{
+		alignment = std::max(alignment, sizeof(AllocationHeader));
+
+		auto base = static_cast<U8*>(_aligned_malloc(size + alignment, alignment));
+		if (!base)
+			return nullptr;
+
+		auto ptr = base + alignment;
+		auto header = reinterpret_cast<AllocationHeader*>(ptr) - 1;
+		header->size = size;
+		header->offset = U32(alignment);
+		header->tag = currentTag_;
+
+		auto& tag = tags_[currentTag_];
+		tag.allocations.fetch_add(1, std::memory_order_relaxed);
+		AddLiveBytes(tag, size);
+
+		return ptr;
+	}
+
+	void MemoryTracker::Free(void* ptr)
+	{
+		if (!ptr)
+			return;
+
+		auto header = static_cast<AllocationHeader*>(ptr) - 1;
+		tags_[header->tag].liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+
+		_aligned_free(static_cast<U8*>(ptr) - header->offset);
+	}
+
+	void MemoryTracker::SetLiveBytes(MemoryTag::Enum tag, U64 bytes)
+	{
+		auto& stats = tags_[tag];
+		stats.liveBytes = bytes;
+
+		auto peak = stats.peakBytes.load(std::memory_order_relaxed);
+		while (bytes > peak && !stats.peakBytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	MemoryTag::Enum MemoryTracker::GetCurrentTag()
+	{
+		return currentTag_;
+	}
+
+	RawStringPtr MemoryTracker::GetTagName(MemoryTag::Enum tag)
+	{
+		return tag < MemoryTag::Count ? TagNames[tag] : "Unknown";
+	}
+
+	MemoryTracker::TagStats MemoryTracker::GetStats(MemoryTag::Enum tag)
+	{
+		auto& stats = tags_[tag];
+		return {stats.liveBytes.load(), stats.peakBytes.load(), stats.allocations.load(), stats.frameAllocations};
+	}
+
+	void MemoryTracker::EndFrame()
+	{
+		U64 frameAllocations = 0;
+		for (U32 i = 0; i < MemoryTag::Count; ++i)
+		{
+			auto& tag = tags_[i];
+			auto allocations = tag.allocations.load(std::memory_order_relaxed);
+			tag.frameAllocations = allocations - tag.frameStart;
+			tag.frameStart = allocations;
+
+			frameAllocations += tag.frameAllocations;
+			TagGauges[i].Set(F64(tag.liveBytes.load(std::memory_order_relaxed)));
+		}
+
+		Allocations.Add(frameAllocations);
+	}
+
+	void MemoryTracker::DrawTable()
+	{
+		ImGui::Columns(5, "Memory");
+		for (auto heading : {"Tag", "Live (KB)", "Peak (KB)", "Allocs/frame", "Allocs"})
+		{
+			ImGui::Text("%s", heading);
+			ImGui::NextColumn();
+		}
+		ImGui::Separator();
+
+		for (U32 i = 0; i < MemoryTag::Count; ++i)
+		{
+			auto stats = GetStats(MemoryTag::Enum(i));
+
+			ImGui::Text("%s", TagNames[i]);
+			ImGui::NextColumn();
+			ImGui::Text("%.1f", F64(stats.liveBytes) / 1024.0);
+			ImGui::NextColumn();
+			ImGui::Text("%.1f", F64(stats.peakBytes) / 1024.0);
+			ImGui::NextColumn();
+			ImGui::Text("%llu", stats.frameAllocations);
+			ImGui::NextColumn();
+			ImGui::Text("%llu", stats.allocations);
+			ImGui::NextColumn();
+		}
+
+		ImGui::Columns(1);
+	}
+
+	void MemoryTracker::AddLiveBytes(Tag& tag, U64 bytes)
+	{
+		auto live = tag.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+		auto peak = tag.peakBytes.load(std::memory_order_relaxed);
+		while (live > peak && !tag.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+		{
+		}
+	}
+}
\ No newline at end of file
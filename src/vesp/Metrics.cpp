@@ -0,0 +1,265 @@
+#include "vesp/Metrics.hpp"
+#include "vesp/Console.hpp"
+#include "vesp/FileSystem.hpp"
+#include "vesp/Log.hpp"
+#include "vesp/Assert.hpp"
+
+#include "vesp/graphics/imgui.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+
+namespace vesp
+{
+	namespace
+	{
+		struct MetricInfo
+		{
+			RawStringPtr name;
+			RawStringPtr description;
+		};
+
+		// Counters and gauges are usually defined at namespace scope, so
+		// they register before main and before any Metrics exists
+		struct Registry
+		{
+			std::mutex mutex;
+			Array<MetricInfo, Metrics::MaxCounters> counters;
+			std::atomic<U32> counterCount{0};
+			Vector<std::pair<MetricInfo, Gauge const*>> gauges;
+		};
+
+		Registry& GetRegistry()
+		{
+			static Registry registry;
+			return registry;
+		}
+
+		// Returns the thread's block when the thread exits
+		struct ThreadCountersOwner
+		{
+			std::atomic<bool>* owned = nullptr;
+
+			~ThreadCountersOwner()
+			{
+				if (this->owned)
+					this->owned->store(false, std::memory_order_release);
+			}
+		};
+
+		thread_local ThreadCountersOwner ThreadOwner;
+
+		void AppendFormat(String& string, RawStringPtr format, ...)
+		{
+			char text[512];
+
+			va_list args;
+			va_start(args, format);
+			auto length = vsnprintf(text, sizeof(text), format, args);
+			va_end(args);
+
+			if (length > 0)
+				string.insert(string.end(), text, text + std::min(size_t(length), sizeof(text) - 1));
+		}
+	}
+
+	thread_local Metrics::ThreadCounters* Metrics::threadCounters_ = nullptr;
+	std::atomic<Metrics::ThreadCounters*> Metrics::threads_{nullptr};
+
+	Counter::Counter(RawStringPtr name, RawStringPtr description)
+		: index_(Metrics::RegisterCounter(name, description))
+	{
+	}
+
+	Gauge::Gauge(RawStringPtr name, RawStringPtr description)
+		: value_(0.0)
+	{
+		Metrics::RegisterGauge(this, name, description);
+	}
+
+	Metrics::Metrics()
+	{
+		this->totals_.fill(0);
+		this->frameValues_.fill(0);
+
+		// metrics.dump("metrics.prom")
+		Console::Get()->AddCommand("metrics.dump", [&](std::string path) {
+			if (this->Dump(path))
+				LogInfo("Wrote metrics to %s", path.c_str());
+		});
+
+		// Rewrites the file every interval, e.g. for a node_exporter textfile
+		// collector; an interval of 0 stops exporting
+		Console::Get()->AddCommand("metrics.export", [&](std::string path, F32 seconds) {
+			this->exportPath_ = StringView(path).CopyToVector();
+			this->exportInterval_ = seconds;
+			this->exportTimer_.Restart();
+		});
+	}
+
+	void Metrics::Pulse()
+	{
+		auto count = GetRegistry().counterCount.load();
+		auto head = threads_.load(std::memory_order_acquire);
+
+		for (U32 i = 0; i < count; ++i)
+		{
+			U64 total = 0;
+			for (auto counters = head; counters; counters = counters->next)
+				total += counters->values[i].load(std::memory_order_relaxed);
+
+			this->frameValues_[i] = total - this->totals_[i];
+			this->totals_[i] = total;
+		}
+
+		if (this->exportInterval_ > 0.0f && this->exportTimer_.GetSeconds() >= this->exportInterval_)
+		{
+			this->Dump(this->exportPath_);
+			this->exportTimer_.Restart();
+		}
+	}
+
+	void Metrics::DrawTable()
+	{
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		ImGui::Columns(3, "Metrics");
+		for (auto heading : {"Metric", "Frame", "Total"})
+		{
+			ImGui::Text("%s", heading);
+			ImGui::NextColumn();
+		}
+		ImGui::Separator();
+
+		auto count = registry.counterCount.load();
+		for (U32 i = 0; i < count; ++i)
+		{
+			ImGui::Text("%s", registry.counters[i].name);
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("%s", registry.counters[i].description);
+			ImGui::NextColumn();
+			ImGui::Text("%llu", this->frameValues_[i]);
+			ImGui::NextColumn();
+			ImGui::Text("%llu", this->totals_[i]);
+			ImGui::NextColumn();
+		}
+
+		for (auto& gauge : registry.gauges)
+		{
+			ImGui::Text("%s", gauge.first.name);
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("%s", gauge.first.description);
+			ImGui::NextColumn();
+			ImGui::Text("%g", gauge.second->Get());
+			ImGui::NextColumn();
+			ImGui::NextColumn();
+		}
+
+		ImGui::Columns(1);
+	}
+
+	String Metrics::Export()
+	{
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		String text;
+		auto count = registry.counterCount.load();
+		for (U32 i = 0; i < count; ++i)
+		{
+			auto& info = registry.counters[i];
+			AppendFormat(text, "# HELP vesp_%s_total %s\n", info.name, info.description);
+			AppendFormat(text, "# TYPE vesp_%s_total counter\n", info.name);
+			AppendFormat(text, "vesp_%s_total %llu\n", info.name, this->totals_[i]);
+		}
+
+		for (auto& gauge : registry.gauges)
+		{
+			auto& info = gauge.first;
+			AppendFormat(text, "# HELP vesp_%s %s\n", info.name, info.description);
+			AppendFormat(text, "# TYPE vesp_%s gauge\n", info.name);
+			AppendFormat(text, "vesp_%s %.17g\n", info.name, gauge.second->Get());
+		}
+
+		return text;
+	}
+
+	bool Metrics::Dump(StringView path)
+	{
+		auto text = this->Export();
+
+		auto tempPath = Concat(path, ".tmp");
+		{
+			auto file = FileSystem::Get()->Open(tempPath, 
+				FileSystem::Mode::Enum(FileSystem::Mode::Write | FileSystem::Mode::Binary));
+			if (!file.Exists())
+			{
+				tempPath.push_back('\0');
+				LogError("Failed to open %s for metrics", tempPath.data());
+				return false;
+			}
+
+			file.Write(ArrayView<U8>(reinterpret_cast<U8*>(text.data()), text.size()));
+		}
+
+		return FileSystem::Get()->Rename(tempPath, path);
+	}
+
+	U32 Metrics::RegisterCounter(RawStringPtr name, RawStringPtr description)
+	{
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		auto index = registry.counterCount.load();
+		VESP_ENFORCE(index < MaxCounters);
+
+		registry.counters[index] = {name, description};
+		registry.counterCount = index + 1;
+
+		return index;
+	}
+
+	void Metrics::RegisterGauge(Gauge const* gauge, RawStringPtr name, RawStringPtr description)
+	{
+		auto& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+
+		registry.gauges.push_back({{name, description}, gauge});
+	}
+
+	Metrics::ThreadCounters* Metrics::RegisterThread()
+	{
+		// Carry on from the counts of a thread that has exited
+		ThreadCounters* counters = nullptr;
+		for (auto it = threads_.load(std::memory_order_acquire); it; it = it->next)
+		{
+			auto owned = false;
+			if (it->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+			{
+				counters = it;
+				break;
+			}
+		}
+
+		if (!counters)
+		{
+			counters = new ThreadCounters();
+			for (auto& value : counters->values)
+				value.store(0, std::memory_order_relaxed);
+			counters->owned = true;
+
+			counters->next = threads_.load(std::memory_order_relaxed);
+			while (!threads_.compare_exchange_weak(counters->next, counters, 
+				std::memory_order_release, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		threadCounters_ = counters;
+		ThreadOwner.owned = &counters->owned;
+		return counters;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,514 @@
+#include "vesp/ProfileCapture.hpp"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace vesp
+{
+	namespace
+	{
+		// Writes are batched so the file sees few, large writes
+		const size_t FlushSize = 256 * 1024;
+
+		void AppendJsonString(Vector<U8>& buffer, RawStringPtr string)
+		{
+			buffer.push_back('"');
+			for (auto c = string; *c; ++c)
+			{
+				if (*c == '"' || *c == '\\')
+				{
+					buffer.push_back('\\');
+					buffer.push_back(*c);
+				}
+				else if (U8(*c) >= 0x20)
+				{
+					buffer.push_back(*c);
+				}
+			}
+			buffer.push_back('"');
+		}
+
+		void AppendFormat(Vector<U8>& buffer, RawStringPtr format, ...)
+		{
+			char text[256];
+
+			va_list args;
+			va_start(args, format);
+			auto length = vsnprintf(text, sizeof(text), format, args);
+			va_end(args);
+
+			if (length > 0)
+				buffer.insert(buffer.end(), text, text + std::min(size_t(length), sizeof(text) - 1));
+		}
+
+		void AppendJsonCounters(Vector<U8>& buffer, ProfileSectionCounters const& counters, F64 time)
+		{
+			// Counts and rates differ by orders of magnitude, so each gets its
+			// own counter track
+			AppendFormat(buffer, "{\"name\":");
+			AppendJsonString(buffer, counters.title);
+			AppendFormat(buffer, ",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"calls\":%u", time, counters.calls);
+			for (U32 event = 0; event < ProfileCounters::EventCount; ++event)
+			{
+				if (counters.counters.Has(event))
+					AppendFormat(buffer, ",\"%s\":%llu", ProfileCounters::GetEventName(event), counters.counters.values[event]);
+			}
+			AppendFormat(buffer, "}},\n");
+
+			auto ipc = counters.counters.GetInstructionsPerCycle();
+			if (ipc < 0.0f)
+				return;
+
+			String name = StringView(counters.title).CopyToVector();
+			Concat(name, " rates");
+			name.push_back('\0');
+
+			AppendFormat(buffer, "{\"name\":");
+			AppendJsonString(buffer, name.data());
+			AppendFormat(buffer, ",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"ipc\":%.3f", time, ipc);
+			for (U32 event = ProfileCounters::L1Misses; event < ProfileCounters::EventCount; ++event)
+			{
+				auto rate = counters.counters.GetPerThousandInstructions(event);
+				if (rate >= 0.0f)
+					AppendFormat(buffer, ",\"%s_pki\":%.3f", ProfileCounters::GetEventName(event), rate);
+			}
+			AppendFormat(buffer, "}},\n");
+		}
+
+		bool ReadVarint(ArrayView<U8> data, size_t& offset, U64& value)
+		{
+			value = 0;
+			for (U32 shift = 0; offset < data.size() && shift < 64; shift += 7)
+			{
+				auto byte = data[offset++];
+				value |= U64(byte & 0x7F) << shift;
+				if (!(byte & 0x80))
+					return true;
+			}
+
+			return false;
+		}
+
+		void AppendJsonHeader(Vector<U8>& buffer)
+		{
+			AppendFormat(buffer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		}
+
+		void AppendJsonFooter(Vector<U8>& buffer)
+		{
+			// Metadata closes the array so that events never need a trailing comma
+			AppendFormat(buffer, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Vespertine\"}}\n]}\n");
+		}
+	}
+
+	ProfileCapture::ProfileCapture(StringView path, Format format, U32 frameCount, F64 secondsPerTick)
+		: path_(path.begin(), path.end()), format_(format), remaining_(frameCount), 
+		secondsPerTick_(secondsPerTick),
+		file_(FileSystem::Get()->Open(path, FileSystem::Mode::Enum(FileSystem::Mode::Write | FileSystem::Mode::Binary))),
+		done_(false)
+	{
+		this->path_.push_back('\0');
+
+		if (!this->file_.Exists())
+		{
+			this->remaining_ = 0;
+			this->done_ = true;
+			return;
+		}
+
+		this->buffer_.reserve(FlushSize * 2);
+		if (format == Format::Json)
+		{
+			AppendJsonHeader(this->buffer_);
+		}
+		else
+		{
+			ProfileCaptureHeader header;
+			header.magic = ProfileCaptureHeader::Magic;
+			header.version = ProfileCaptureHeader::CurrentVersion;
+			header.secondsPerTick = secondsPerTick;
+
+			auto bytes = reinterpret_cast<U8*>(&header);
+			this->buffer_.insert(this->buffer_.end(), bytes, bytes + sizeof(header));
+		}
+
+		this->writer_ = std::thread([this] { this->WriterMain(); });
+	}
+
+	ProfileCapture::~ProfileCapture()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->queueMutex_);
+			this->finished_ = true;
+		}
+		this->queueCondition_.notify_one();
+
+		if (this->writer_.joinable())
+			this->writer_.join();
+	}
+
+	bool ProfileCapture::IsOpen() const
+	{
+		return this->file_.Exists();
+	}
+
+	RawStringPtr ProfileCapture::GetPath() const
+	{
+		return this->path_.data();
+	}
+
+	U32 ProfileCapture::GetRemaining() const
+	{
+		return this->remaining_;
+	}
+
+	bool ProfileCapture::IsDone() const
+	{
+		return this->done_;
+	}
+
+	void ProfileCapture::Push(Frame&& frame)
+	{
+		VESP_ASSERT(this->remaining_ > 0);
+
+		{
+			std::lock_guard<std::mutex> lock(this->queueMutex_);
+			this->queue_.push_back(std::move(frame));
+			if (--this->remaining_ == 0)
+				this->finished_ = true;
+		}
+		this->queueCondition_.notify_one();
+	}
+
+	void ProfileCapture::WriterMain()
+	{
+		for (;;)
+		{
+			Frame frame;
+			{
+				std::unique_lock<std::mutex> lock(this->queueMutex_);
+				this->queueCondition_.wait(lock, [&] {
+					return this->finished_ || !this->queue_.empty();
+				});
+
+				if (this->queue_.empty())
+					break;
+
+				frame = std::move(this->queue_.front());
+				this->queue_.pop_front();
+			}
+
+			if (this->writtenFrames_ == 0)
+				this->base_ = frame.start;
+
+			if (this->format_ == Format::Json)
+				this->WriteJson(frame);
+			else
+				this->WriteBinary(frame);
+			++this->writtenFrames_;
+
+			this->Flush(false);
+		}
+
+		if (this->format_ == Format::Json)
+			AppendJsonFooter(this->buffer_);
+
+		this->Flush(true);
+		this->file_.Flush();
+		this->done_ = true;
+	}
+
+	void ProfileCapture::WriteJson(Frame const& frame)
+	{
+		auto& buffer = this->buffer_;
+		auto toMicroseconds = [&](U64 time) {
+			// Sections begun before the capture are clamped to its start
+			return time > this->base_ ? F64(time - this->base_) * this->secondsPerTick_ * 1e6 : 0.0;
+		};
+
+		AppendFormat(buffer, "{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+			frame.mainLane, toMicroseconds(frame.start), F64(frame.end - frame.start) * this->secondsPerTick_ * 1e6);
+
+		for (auto& lane : frame.lanes)
+		{
+			auto& name = this->laneNames_[lane.id];
+			if (lane.name && lane.name != name)
+			{
+				name = lane.name;
+				AppendFormat(buffer, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", lane.id);
+				AppendJsonString(buffer, name);
+				AppendFormat(buffer, "}},\n");
+			}
+
+			for (auto record = lane.records.begin() + this->GetFirstRecord(lane); record != lane.records.end(); ++record)
+			{
+				if (record->title)
+				{
+					AppendFormat(buffer, "{\"name\":");
+					AppendJsonString(buffer, record->title);
+					AppendFormat(buffer, ",\"ph\":\"B\",\"pid\":1,\"tid\":%u,\"ts\":%.3f},\n", 
+						lane.id, toMicroseconds(record->time));
+				}
+				else
+				{
+					AppendFormat(buffer, "{\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%.3f},\n", 
+						lane.id, toMicroseconds(record->time));
+				}
+			}
+		}
+
+		for (auto& counters : frame.counters)
+			AppendJsonCounters(buffer, counters, toMicroseconds(frame.end));
+	}
+
+	void ProfileCapture::WriteBinary(Frame const& frame)
+	{
+		auto toTicks = [&](U64 time) {
+			return time > this->base_ ? time - this->base_ : 0;
+		};
+
+		this->buffer_.push_back(2);
+		this->WriteVarint(toTicks(frame.start));
+		this->WriteVarint(frame.end - frame.start);
+		this->WriteVarint(frame.mainLane);
+
+		for (auto& lane : frame.lanes)
+		{
+			auto& name = this->laneNames_[lane.id];
+			if (lane.name && lane.name != name)
+			{
+				name = lane.name;
+				auto nameId = this->GetStringId(name);
+				this->buffer_.push_back(1);
+				this->WriteVarint(lane.id);
+				this->WriteVarint(nameId);
+			}
+
+			auto first = lane.records.begin() + this->GetFirstRecord(lane);
+			if (first == lane.records.end())
+				continue;
+
+			// Strings are defined before the block that uses them
+			for (auto record = first; record != lane.records.end(); ++record)
+			{
+				if (record->title)
+					this->GetStringId(record->title);
+			}
+
+			this->buffer_.push_back(3);
+			this->WriteVarint(lane.id);
+			this->WriteVarint(U64(lane.records.end() - first));
+
+			auto& lastTime = this->laneTimes_[lane.id];
+			for (auto record = first; record != lane.records.end(); ++record)
+			{
+				auto time = std::max(toTicks(record->time), lastTime);
+				this->WriteVarint(record->title ? this->stringIds_[record->title] : 0);
+				this->WriteVarint(time - lastTime);
+				lastTime = time;
+			}
+		}
+
+		for (auto& counters : frame.counters)
+		{
+			auto titleId = this->GetStringId(counters.title);
+			this->buffer_.push_back(4);
+			this->WriteVarint(titleId);
+			this->WriteVarint(counters.calls);
+			this->WriteVarint(counters.counters.available);
+
+			for (U32 event = 0; event < ProfileCounters::EventCount; ++event)
+			{
+				if (counters.counters.Has(event))
+					this->WriteVarint(counters.counters.values[event]);
+			}
+		}
+	}
+
+	U32 ProfileCapture::GetFirstRecord(Lane const& lane) const
+	{
+		// Later frames repeat the open sections the previous frame wrote
+		return this->writtenFrames_ == 0 ? 0 : lane.carried;
+	}
+
+	void ProfileCapture::WriteVarint(U64 value)
+	{
+		while (value >= 0x80)
+		{
+			this->buffer_.push_back(U8(value | 0x80));
+			value >>= 7;
+		}
+		this->buffer_.push_back(U8(value));
+	}
+
+	U32 ProfileCapture::GetStringId(RawStringPtr string)
+	{
+		auto it = this->stringIds_.find(string);
+		if (it != this->stringIds_.end())
+			return it->second;
+
+		auto id = U32(this->stringIds_.size()) + 1;
+		this->stringIds_[string] = id;
+
+		auto length = strlen(string);
+		this->buffer_.push_back(0);
+		this->WriteVarint(id);
+		this->WriteVarint(length);
+		this->buffer_.insert(this->buffer_.end(), string, string + length);
+
+		return id;
+	}
+
+	void ProfileCapture::Flush(bool force)
+	{
+		if (this->buffer_.empty() || (!force && this->buffer_.size() < FlushSize))
+			return;
+
+		this->file_.Write(this->buffer_);
+		this->buffer_.clear();
+	}
+
+	bool ProfileCapture::Decode(StringView path, StringView outputPath)
+	{
+		auto file = FileSystem::Get()->Open(path, FileSystem::Mode::ReadBinary);
+		if (!file.Exists() || file.Size() < sizeof(ProfileCaptureHeader))
+			return false;
+
+		auto data = file.Read<U8>();
+
+		ProfileCaptureHeader header;
+		std::memcpy(&header, data.data(), sizeof(header));
+		if (header.magic != ProfileCaptureHeader::Magic || header.version != ProfileCaptureHeader::CurrentVersion)
+			return false;
+
+		auto output = FileSystem::Get()->Open(outputPath,
+			FileSystem::Mode::Enum(FileSystem::Mode::Write | FileSystem::Mode::Binary));
+		if (!output.Exists())
+			return false;
+
+		auto toMicroseconds = [&](U64 ticks) {
+			return F64(ticks) * header.secondsPerTick * 1e6;
+		};
+
+		UnorderedMap<U64, String> strings;
+		auto getString = [&](U64 id) -> RawStringPtr {
+			auto it = strings.find(id);
+			return it != strings.end() ? it->second.data() : "Unknown";
+		};
+
+		Vector<U8> buffer;
+		AppendJsonHeader(buffer);
+
+		UnorderedMap<U64, U64> laneTimes;
+		U64 frameEnd = 0;
+
+		// A capture cut short still decodes up to its last whole block
+		auto view = ArrayView<U8>(data);
+		size_t offset = sizeof(header);
+		while (offset < view.size())
+		{
+			auto tag = view[offset++];
+			if (tag == 0)
+			{
+				U64 id, length;
+				if (!ReadVarint(view, offset, id) || !ReadVarint(view, offset, length) ||
+					length > view.size() - offset)
+					break;
+
+				auto& string = strings[id];
+				string.assign(view.data() + offset, view.data() + offset + length);
+				string.push_back(0);
+				offset += length;
+			}
+			else if (tag == 1)
+			{
+				U64 lane, nameId;
+				if (!ReadVarint(view, offset, lane) || !ReadVarint(view, offset, nameId))
+					break;
+
+				AppendFormat(buffer, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", U32(lane));
+				AppendJsonString(buffer, getString(nameId));
+				AppendFormat(buffer, "}},\n");
+			}
+			else if (tag == 2)
+			{
+				U64 start, duration, mainLane;
+				if (!ReadVarint(view, offset, start) || !ReadVarint(view, offset, duration) ||
+					!ReadVarint(view, offset, mainLane))
+					break;
+
+				frameEnd = start + duration;
+				AppendFormat(buffer, "{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+					U32(mainLane), toMicroseconds(start), toMicroseconds(duration));
+			}
+			else if (tag == 3)
+			{
+				U64 lane, count;
+				if (!ReadVarint(view, offset, lane) || !ReadVarint(view, offset, count))
+					break;
+
+				auto& time = laneTimes[lane];
+				U64 i = 0;
+				for (; i < count; ++i)
+				{
+					U64 titleId, delta;
+					if (!ReadVarint(view, offset, titleId) || !ReadVarint(view, offset, delta))
+						break;
+
+					time += delta;
+					if (titleId)
+					{
+						AppendFormat(buffer, "{\"name\":");
+						AppendJsonString(buffer, getString(titleId));
+						AppendFormat(buffer, ",\"ph\":\"B\",\"pid\":1,\"tid\":%u,\"ts\":%.3f},\n", 
+							U32(lane), toMicroseconds(time));
+					}
+					else
+					{
+						AppendFormat(buffer, "{\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%.3f},\n", 
+							U32(lane), toMicroseconds(time));
+					}
+				}
+
+				if (i != count)
+					break;
+			}
+			else if (tag == 4)
+			{
+				U64 titleId, calls, available;
+				if (!ReadVarint(view, offset, titleId) || !ReadVarint(view, offset, calls) ||
+					!ReadVarint(view, offset, available))
+					break;
+
+				ProfileSectionCounters counters = {};
+				counters.title = getString(titleId);
+				counters.calls = U32(calls);
+				counters.counters.available = U32(available);
+
+				auto complete = true;
+				for (U32 event = 0; event < ProfileCounters::EventCount && complete; ++event)
+				{
+					if (counters.counters.Has(event))
+						complete = ReadVarint(view, offset, counters.counters.values[event]);
+				}
+
+				if (!complete)
+					break;
+
+				AppendJsonCounters(buffer, counters, toMicroseconds(frameEnd));
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		AppendJsonFooter(buffer);
+
+		output.Write(buffer);
+		FileSystem::Get()->Close(output);
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "vesp/ProfileCounters.hpp"
+
+#include <Windows.h>
+
+#include <atomic>
+
+namespace vesp
+{
+	namespace
+	{
+		RawStringPtr EventNames[ProfileCounters::EventCount] = {
+			"cycles", "instructions", "l1_misses", "llc_misses", "branch_misses"
+		};
+
+		// Slot + 1 per event, so that zero-initialisation means unassigned
+		std::atomic<U32> Slots[ProfileCounters::EventCount];
+		std::atomic<U32> SlotGeneration(0);
+
+		// Per thread profiling state, released when the thread exits
+		struct ThreadProfiling
+		{
+			HANDLE handle = nullptr;
+			U32 generation = U32(-1);
+			// Position of each event in the counter data
+			Array<U32, ProfileCounters::EventCount> indices;
+
+			~ThreadProfiling()
+			{
+				if (this->handle)
+					DisableThreadProfiling(this->handle);
+			}
+		};
+
+		thread_local ThreadProfiling Profiling;
+
+		void EnableProfiling(ThreadProfiling& profiling)
+		{
+			if (profiling.handle)
+			{
+				DisableThreadProfiling(profiling.handle);
+				profiling.handle = nullptr;
+			}
+
+			profiling.generation = SlotGeneration.load();
+			profiling.indices.fill(U32(ProfileCounters::NoSlot));
+
+			DWORD64 mask = 0;
+			for (U32 event = ProfileCounters::Instructions; event < ProfileCounters::EventCount; ++event)
+			{
+				if (auto slot = Slots[event].load())
+					mask |= DWORD64(1) << (slot - 1);
+			}
+
+			if (!mask)
+				return;
+
+			// Counter data lists the requested slots in ascending order
+			for (U32 event = ProfileCounters::Instructions; event < ProfileCounters::EventCount; ++event)
+			{
+				auto slot = Slots[event].load();
+				if (!slot)
+					continue;
+
+				U32 index = 0;
+				for (U32 lower = 0; lower < slot - 1; ++lower)
+					index += (mask >> lower) & 1;
+				profiling.indices[event] = index;
+			}
+
+			if (EnableThreadProfiling(GetCurrentThread(), 0, mask, &profiling.handle) != ERROR_SUCCESS)
+				profiling.handle = nullptr;
+		}
+	}
+
+	ProfileCounters ProfileCounters::Read()
+	{
+		ProfileCounters counters;
+		counters.values.fill(0);
+		counters.available = 0;
+
+		// Counted in reference cycles on current processors, so IPC is
+		// relative to the nominal clock rather than the boosted one
+		ULONG64 cycles;
+		if (QueryThreadCycleTime(GetCurrentThread(), &cycles))
+		{
+			counters.values[Cycles] = cycles;
+			counters.available |= 1 << Cycles;
+		}
+
+		auto& profiling = Profiling;
+		if (profiling.generation != SlotGeneration.load(std::memory_order_relaxed))
+			EnableProfiling(profiling);
+
+		if (!profiling.handle)
+			return counters;
+
+		PERFORMANCE_DATA data = {};
+		data.Size = sizeof(data);
+		data.Version = PERFORMANCE_DATA_VERSION;
+		if (ReadThreadProfilingData(profiling.handle, READ_THREAD_PROFILING_FLAG_HARDWARE_COUNTERS, &data) != ERROR_SUCCESS)
+			return counters;
+
+		for (U32 event = Instructions; event < EventCount; ++event)
+		{
+			auto index = profiling.indices[event];
+			if (index >= data.HwCountersCount)
+				continue;
+
+			counters.values[event] = data.HwCounters[index].Value;
+			counters.available |= 1 << event;
+		}
+
+		return counters;
+	}
+
+	RawStringPtr ProfileCounters::GetEventName(U32 event)
+	{
+		return event < EventCount ? EventNames[event] : "unknown";
+	}
+
+	U32 ProfileCounters::FindEvent(StringView name)
+	{
+		for (U32 event = 0; event < EventCount; ++event)
+		{
+			if (name == EventNames[event])
+				return event;
+		}
+
+		return EventCount;
+	}
+
+	void ProfileCounters::SetSlot(U32 event, U32 slot)
+	{
+		// Cycles never come from a slot
+		if (event == Cycles || event >= EventCount || (slot != NoSlot && slot >= 64))
+			return;
+
+		Slots[event] = slot == NoSlot ? 0 : slot + 1;
+		++SlotGeneration;
+	}
+
+	bool ProfileCounters::Has(U32 event) const
+	{
+		return (this->available & (1 << event)) != 0;
+	}
+
+	F32 ProfileCounters::GetPerThousandInstructions(U32 event) const
+	{
+		if (!this->Has(event) || !this->Has(Instructions) || !this->values[Instructions])
+			return -1.0f;
+
+		return F32(F64(this->values[event]) * 1000.0 / F64(this->values[Instructions]));
+	}
+
+	F32 ProfileCounters::GetInstructionsPerCycle() const
+	{
+		if (!this->Has(Instructions) || !this->Has(Cycles) || !this->values[Cycles])
+			return -1.0f;
+
+		return F32(F64(this->values[Instructions]) / F64(this->values[Cycles]));
+	}
+
+	ProfileCounters& ProfileCounters::operator+=(ProfileCounters const& rhs)
+	{
+		for (U32 event = 0; event < EventCount; ++event)
+			this->values[event] += rhs.values[event];
+		this->available &= rhs.available;
+
+		return *this;
+	}
+
+	ProfileCounters ProfileCounters::operator-(ProfileCounters const& rhs) const
+	{
+		ProfileCounters result;
+		for (U32 event = 0; event < EventCount; ++event)
+			result.values[event] = this->values[event] - rhs.values[event];
+		result.available = this->available & rhs.available;
+
+		return result;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,427 @@
+#include "vesp/ProfileSampler.hpp"
+#include "vesp/FileSystem.hpp"
+#include "vesp/Log.hpp"
+
+#include "vesp/graphics/imgui.h"
+
+#include <Windows.h>
+#include <mmsystem.h>
+#include <DbgHelp.h>
+
+#include <algorithm>
+#include <chrono>
+
+#pragma comment(lib, "dbghelp")
+#pragma comment(lib, "winmm")
+
+namespace vesp
+{
+	namespace
+	{
+		const U32 NoNode = U32(-1);
+		const U32 NoFunction = U32(-1);
+	}
+
+	ProfileSampler::ProfileSampler(U32 frequency, SectionStack sections)
+		: frequency_(std::min(std::max(frequency, 1u), 1000u)), sections_(sections),
+		running_(false), quit_(false)
+	{
+		auto process = GetCurrentProcess();
+		HANDLE thread = nullptr;
+		if (!DuplicateHandle(process, GetCurrentThread(), process, &thread,
+			THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, 0))
+		{
+			LogError("Failed to open thread for sampling (error %u)", U32(GetLastError()));
+			return;
+		}
+
+		this->thread_ = thread;
+		this->stackBase_ = U64(reinterpret_cast<NT_TIB*>(NtCurrentTeb())->StackBase);
+		// Unwinding a truncated copy can read a little past its end
+		this->stackCopy_.resize(StackCopySize + 4096);
+
+		SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS);
+		if (!SymInitialize(process, nullptr, TRUE))
+			LogWarn("Failed to load symbols for sampling; functions will show as modules");
+
+		// The default scheduler tick would cap the rate at 64 samples a second
+		timeBeginPeriod(1);
+
+		this->running_ = true;
+		this->sampler_ = std::thread([this] { this->SamplerMain(); });
+	}
+
+	ProfileSampler::~ProfileSampler()
+	{
+		this->quit_ = true;
+		if (this->sampler_.joinable())
+		{
+			this->sampler_.join();
+			timeEndPeriod(1);
+			SymCleanup(GetCurrentProcess());
+		}
+
+		if (this->thread_)
+			CloseHandle(this->thread_);
+	}
+
+	bool ProfileSampler::IsRunning() const
+	{
+		return this->running_;
+	}
+
+	U32 ProfileSampler::GetSampleCount() const
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		return this->sampleCount_;
+	}
+
+	bool ProfileSampler::Save(StringView path)
+	{
+		String output;
+		{
+			std::lock_guard<std::mutex> lock(this->mutex_);
+
+			String prefix;
+			for (auto& tree : this->trees_)
+			{
+				prefix = StringView(tree.section ? tree.section : "(no section)").CopyToVector();
+				this->SaveNode(tree, 0, prefix, output);
+			}
+		}
+
+		auto file = FileSystem::Get()->Open(path,
+			FileSystem::Mode::Enum(FileSystem::Mode::Write | FileSystem::Mode::Binary));
+		if (!file.Exists())
+			return false;
+
+		file.Write(ArrayView<U8>(reinterpret_cast<U8*>(output.data()), output.size()));
+		return true;
+	}
+
+	void ProfileSampler::Draw()
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+
+		ImGui::Text("%u samples at %u Hz", this->sampleCount_, this->frequency_);
+		if (!this->running_)
+		{
+			ImGui::SameLine();
+			ImGui::TextDisabled("(stopped)");
+		}
+
+		if (this->trees_.empty())
+			return;
+
+		auto getTitle = [](void* data, int index, char const** text) {
+			auto& trees = *static_cast<Vector<Tree>*>(data);
+			*text = trees[index].section ? trees[index].section : "(no section)";
+			return true;
+		};
+
+		auto selected = int(std::min(this->selectedTree_, U32(this->trees_.size() - 1)));
+		ImGui::Combo("Section", &selected, getTitle, &this->trees_, int(this->trees_.size()));
+		this->selectedTree_ = U32(selected);
+
+		auto& tree = this->trees_[this->selectedTree_];
+		auto width = ImGui::GetContentRegionAvailWidth();
+		auto rowHeight = ImGui::GetTextLineHeight() + 2.0f;
+
+		auto origin = ImGui::GetCursorScreenPos();
+		ImGui::Dummy(ImVec2(width, tree.depth * rowHeight));
+		this->DrawNode(tree, 0, origin.x, origin.y, width);
+	}
+
+	void ProfileSampler::SamplerMain()
+	{
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+
+		typedef std::chrono::steady_clock Clock;
+		auto interval = std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<F64>(1.0 / this->frequency_));
+
+		Array<U64, MaxFrames> frames;
+		Array<U32, MaxFrames> functions;
+		auto next = Clock::now();
+		while (!this->quit_)
+		{
+			// Skip samples that were missed rather than bursting to catch up
+			next = std::max(next + interval, Clock::now());
+			std::this_thread::sleep_until(next);
+
+			RawStringPtr section = nullptr;
+			auto count = this->CaptureStack(frames.data(), section);
+			if (!count)
+			{
+				this->running_ = false;
+				break;
+			}
+
+			// Symbols load on first use, which can take a while; that happens
+			// outside the lock so that drawing never waits on it
+			for (U32 i = 0; i < count; ++i)
+				functions[i] = this->GetFunction(frames[i]);
+
+			std::lock_guard<std::mutex> lock(this->mutex_);
+			this->AddSample(section, functions.data(), count);
+			++this->sampleCount_;
+		}
+	}
+
+	U32 ProfileSampler::CaptureStack(U64* frames, RawStringPtr& section)
+	{
+		auto thread = static_cast<HANDLE>(this->thread_);
+
+		// While the thread is suspended it may hold any lock, including the
+		// heap's, so only its registers and stack are copied out here
+		if (SuspendThread(thread) == DWORD(-1))
+			return 0;
+
+		CONTEXT context = {};
+		context.ContextFlags = CONTEXT_FULL;
+		auto captured = GetThreadContext(thread, &context) != FALSE;
+
+		U64 stackTop = 0;
+		U64 stackSize = 0;
+		if (captured)
+		{
+			auto depth = *this->sections_.depth;
+			section = depth ? this->sections_.titles[std::min(depth, this->sections_.capacity) - 1] : nullptr;
+
+#if defined(_M_X64)
+			stackTop = context.Rsp;
+			if (stackTop < this->stackBase_)
+			{
+				stackSize = std::min<U64>(this->stackBase_ - stackTop, StackCopySize);
+				memcpy(this->stackCopy_.data(), reinterpret_cast<void const*>(stackTop), size_t(stackSize));
+			}
+#endif
+		}
+
+		ResumeThread(thread);
+
+		if (!captured)
+			return 0;
+
+#if defined(_M_X64)
+		// Point everything that referred to the stack at the copy, so that
+		// saved frame pointers still lead somewhere valid
+		auto copyStart = U64(this->stackCopy_.data());
+		auto copyEnd = copyStart + stackSize;
+		auto relocate = [&](DWORD64& value) {
+			if (value >= stackTop && value < stackTop + stackSize)
+				value = value - stackTop + copyStart;
+		};
+
+		auto words = reinterpret_cast<DWORD64*>(this->stackCopy_.data());
+		for (U64 i = 0; i < stackSize / sizeof(DWORD64); ++i)
+			relocate(words[i]);
+
+		for (auto reg : {&context.Rax, &context.Rcx, &context.Rdx, &context.Rbx,
+			&context.Rsp, &context.Rbp, &context.Rsi, &context.Rdi,
+			&context.R8, &context.R9, &context.R10, &context.R11,
+			&context.R12, &context.R13, &context.R14, &context.R15})
+		{
+			relocate(*reg);
+		}
+
+		U32 count = 0;
+		while (count < MaxFrames)
+		{
+			// Return addresses point past the call, which may be the first
+			// instruction of the next function
+			frames[count] = count ? context.Rip - 1 : context.Rip;
+			++count;
+
+			DWORD64 imageBase;
+			auto function = RtlLookupFunctionEntry(context.Rip, &imageBase, nullptr);
+			if (function)
+			{
+				void* handlerData;
+				DWORD64 establisherFrame;
+				RtlVirtualUnwind(UNW_FLAG_NHANDLER, imageBase, context.Rip, function,
+					&context, &handlerData, &establisherFrame, nullptr);
+			}
+			else
+			{
+				// Leaf functions have no unwind data and leave the stack
+				// pointer at the return address
+				if (context.Rsp < copyStart || context.Rsp + sizeof(DWORD64) > copyEnd)
+					break;
+
+				context.Rip = *reinterpret_cast<DWORD64*>(context.Rsp);
+				context.Rsp += sizeof(DWORD64);
+			}
+
+			if (!context.Rip || context.Rsp < copyStart || context.Rsp >= copyEnd)
+				break;
+		}
+
+		return count;
+#else
+		// Only x64 unwind data is walked; elsewhere samples are flat
+		frames[0] = context.Eip;
+		return 1;
+#endif
+	}
+
+	void ProfileSampler::AddSample(RawStringPtr section, U32 const* functions, U32 count)
+	{
+		auto it = this->treeIndices_.find(section);
+		if (it == this->treeIndices_.end())
+		{
+			it = this->treeIndices_.emplace(section, U32(this->trees_.size())).first;
+			this->trees_.push_back({section, {{NoFunction, NoNode, NoNode, 0}}, 1});
+		}
+
+		auto& tree = this->trees_[it->second];
+		auto& nodes = tree.nodes;
+		++nodes[0].count;
+		tree.depth = std::max(tree.depth, count + 1);
+
+		// Frames arrive innermost first; the tree is built from the outside in
+		U32 node = 0;
+		for (auto i = count; i-- > 0;)
+		{
+			auto function = functions[i];
+
+			auto child = nodes[node].firstChild;
+			while (child != NoNode && nodes[child].function != function)
+				child = nodes[child].nextSibling;
+
+			if (child == NoNode)
+			{
+				child = U32(nodes.size());
+				nodes.push_back({function, NoNode, nodes[node].firstChild, 0});
+				nodes[node].firstChild = child;
+			}
+
+			++nodes[child].count;
+			node = child;
+		}
+	}
+
+	U32 ProfileSampler::GetFunction(U64 address)
+	{
+		auto it = this->addressFunctions_.find(address);
+		if (it != this->addressFunctions_.end())
+			return it->second;
+
+		StringByte name[256];
+		U64 start = address;
+
+		U8 symbolStorage[sizeof(SYMBOL_INFO) + sizeof(name)] = {};
+		auto symbol = reinterpret_cast<SYMBOL_INFO*>(symbolStorage);
+		symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+		symbol->MaxNameLen = sizeof(name) - 1;
+
+		DWORD64 displacement;
+		HMODULE module = nullptr;
+		if (SymFromAddr(GetCurrentProcess(), address, &displacement, symbol))
+		{
+			start = symbol->Address;
+			snprintf(name, sizeof(name), "%s", symbol->Name);
+		}
+		else if (GetModuleHandleExA(
+			GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+			reinterpret_cast<LPCSTR>(address), &module))
+		{
+			// Without symbols, a module is the finest grouping that does not
+			// give every address its own entry
+			StringByte path[MAX_PATH];
+			auto length = GetModuleFileNameA(module, path, MAX_PATH);
+			auto fileName = path + length;
+			while (fileName != path && fileName[-1] != '\\' && fileName[-1] != '/')
+				--fileName;
+
+			start = U64(module);
+			snprintf(name, sizeof(name), "[%s]", fileName);
+		}
+		else
+		{
+			// Code outside any module is most likely LuaJIT traces
+			start = 0;
+			snprintf(name, sizeof(name), "[jit]");
+		}
+
+		auto functionIt = this->functionIndices_.find(start);
+		if (functionIt == this->functionIndices_.end())
+		{
+			std::lock_guard<std::mutex> lock(this->mutex_);
+			functionIt = this->functionIndices_.emplace(start, U32(this->functions_.size())).first;
+			this->functions_.push_back(StringView(name, strlen(name)).CopyToVector());
+		}
+
+		this->addressFunctions_[address] = functionIt->second;
+		return functionIt->second;
+	}
+
+	void ProfileSampler::SaveNode(Tree const& tree, U32 index, String& prefix, String& output) const
+	{
+		auto& node = tree.nodes[index];
+
+		auto self = node.count;
+		for (auto child = node.firstChild; child != NoNode; child = tree.nodes[child].nextSibling)
+			self -= tree.nodes[child].count;
+
+		if (self)
+		{
+			StringByte count[16];
+			auto length = snprintf(count, sizeof(count), " %u\n", self);
+			Concat(output, prefix);
+			Concat(output, StringView(count, length));
+		}
+
+		for (auto child = node.firstChild; child != NoNode; child = tree.nodes[child].nextSibling)
+		{
+			auto length = prefix.size();
+			prefix.push_back(';');
+			Concat(prefix, this->functions_[tree.nodes[child].function]);
+
+			this->SaveNode(tree, child, prefix, output);
+			prefix.resize(length);
+		}
+	}
+
+	void ProfileSampler::DrawNode(Tree const& tree, U32 index, F32 x, F32 y, F32 width) const
+	{
+		auto& node = tree.nodes[index];
+		auto rowHeight = ImGui::GetTextLineHeight() + 2.0f;
+
+		StringByte title[256];
+		if (node.function == NoFunction)
+			snprintf(title, sizeof(title), "%s", tree.section ? tree.section : "(no section)");
+		else
+			snprintf(title, sizeof(title), "%.*s",
+				S32(this->functions_[node.function].size()), this->functions_[node.function].data());
+
+		ImVec2 min(x, y);
+		ImVec2 max(x + width - 1.0f, y + rowHeight - 1.0f);
+
+		// Colour by function so that it is easy to spot across the graph
+		auto hue = F32(((node.function + 1) * 2654435761u) >> 24) / 255.0f;
+		float r, g, b;
+		ImGui::ColorConvertHSVtoRGB(hue, 0.5f, 0.75f, r, g, b);
+
+		auto drawList = ImGui::GetWindowDrawList();
+		drawList->AddRectFilled(min, max, ImGui::ColorConvertFloat4ToU32(ImVec4(r, g, b, 1.0f)));
+
+		if (ImGui::CalcTextSize(title).x + 4.0f < max.x - min.x)
+			drawList->AddText(ImVec2(min.x + 2.0f, min.y + 1.0f), 0xFFFFFFFF, title);
+
+		if (ImGui::IsMouseHoveringRect(min, max))
+		{
+			ImGui::SetTooltip("%s\n%u samples (%.1f%%)", title, node.count,
+				node.count * 100.0f / tree.nodes[0].count);
+		}
+
+		for (auto child = node.firstChild; child != NoNode; child = tree.nodes[child].nextSibling)
+		{
+			auto childWidth = width * tree.nodes[child].count / node.count;
+			if (childWidth >= 2.0f)
+				this->DrawNode(tree, child, x, y + rowHeight, childWidth);
+
+			x += childWidth;
+		}
+	}
+}
\ No newline at end of file
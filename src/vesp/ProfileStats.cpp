@@ -0,0 +1,195 @@
+#include "vesp/ProfileStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vesp
+{
+	ProfileStats::ProfileStats()
+	{
+		this->scratch_.reserve(WindowSize);
+	}
+
+	void ProfileStats::BeginFrame(U32 mainLane, F32 frameSeconds)
+	{
+		this->mainLane_ = mainLane;
+		this->framePath_ = GetChildPath(GetRootPath(mainLane), "Frame");
+
+		++this->frameIndex_;
+
+		auto& frame = this->GetPath(this->framePath_, "Frame", mainLane, 0);
+		this->AddTime(frame, frameSeconds);
+	}
+
+	void ProfileStats::AddLane(U32 lane, ProfileRecord const* records, U32 count, F64 secondsPerTick)
+	{
+		static const U32 MaxDepth = 64;
+
+		struct OpenSection
+		{
+			U64 path;
+			U64 start;
+		};
+
+		OpenSection stack[MaxDepth];
+		U32 depth = 0;
+
+		auto isMain = lane == this->mainLane_;
+		auto root = isMain ? this->framePath_ : GetRootPath(lane);
+		auto baseDepth = isMain ? 1u : 0u;
+
+		for (U32 i = 0; i < count; ++i)
+		{
+			auto& record = records[i];
+			if (record.title)
+			{
+				if (depth < MaxDepth)
+				{
+					auto parent = depth ? stack[depth - 1].path : root;
+					stack[depth] = {GetChildPath(parent, record.title), record.time};
+					this->GetPath(stack[depth].path, record.title, lane, baseDepth + depth);
+				}
+				++depth;
+			}
+			else if (depth)
+			{
+				--depth;
+				if (depth < MaxDepth)
+				{
+					auto& path = this->paths_[stack[depth].path];
+					this->AddTime(path, F32(F64(record.time - stack[depth].start) * secondsPerTick));
+				}
+			}
+		}
+	}
+
+	void ProfileStats::EndFrame()
+	{
+		for (auto path : this->touched_)
+		{
+			this->AddSample(*path, path->frameTotal);
+			path->lastCalls = path->frameCalls;
+			path->frameTotal = 0.0f;
+			path->frameCalls = 0;
+		}
+
+		this->touched_.clear();
+	}
+
+	ProfileStats::Summary ProfileStats::Summarise(Path const& path)
+	{
+		Summary summary = {};
+		summary.count = path.sampleCount;
+		if (!path.sampleCount)
+			return summary;
+
+		auto& scratch = this->scratch_;
+		scratch.assign(path.samples.begin(), path.samples.begin() + path.sampleCount);
+
+		auto minMax = std::minmax_element(scratch.begin(), scratch.end());
+		summary.min = *minMax.first;
+		summary.max = *minMax.second;
+		summary.mean = F32(path.sum / path.sampleCount);
+
+		auto percentile = [&](F32 fraction) {
+			auto index = std::min(U32(fraction * path.sampleCount), path.sampleCount - 1);
+			std::nth_element(scratch.begin(), scratch.begin() + index, scratch.end());
+			return scratch[index];
+		};
+
+		summary.p50 = percentile(0.50f);
+		summary.p95 = percentile(0.95f);
+		summary.p99 = percentile(0.99f);
+
+		return summary;
+	}
+
+	Vector<ProfileStats::Path const*> const& ProfileStats::GetPaths() const
+	{
+		return this->order_;
+	}
+
+	void ProfileStats::Reset()
+	{
+		this->paths_.clear();
+		this->order_.clear();
+		this->touched_.clear();
+	}
+
+	U64 ProfileStats::GetRootPath(U32 lane)
+	{
+		return (U64(lane) + 1) * 0x9E3779B97F4A7C15ull;
+	}
+
+	U64 ProfileStats::GetChildPath(U64 parent, RawStringPtr title)
+	{
+		// Titles are literals, so their addresses identify them
+		auto key = (parent ^ U64(size_t(title))) * 0x100000001B3ull;
+		return key ^ (key >> 29);
+	}
+
+	ProfileStats::Path& ProfileStats::GetPath(U64 key, RawStringPtr title, U32 lane, U32 depth)
+	{
+		auto it = this->paths_.find(key);
+		if (it == this->paths_.end())
+		{
+			auto& path = this->paths_[key];
+			path.title = title;
+			path.lane = lane;
+			path.depth = depth;
+			path.sampleCount = 0;
+			path.nextSample = 0;
+			path.histogram.fill(0);
+			path.sum = 0.0;
+			path.frameTotal = 0.0f;
+			path.frameCalls = 0;
+			path.lastCalls = 0;
+			path.touchedFrame = 0;
+
+			this->order_.push_back(&path);
+			it = this->paths_.find(key);
+		}
+
+		return it->second;
+	}
+
+	void ProfileStats::AddTime(Path& path, F32 seconds)
+	{
+		if (path.touchedFrame != this->frameIndex_)
+		{
+			path.touchedFrame = this->frameIndex_;
+			this->touched_.push_back(&path);
+		}
+
+		path.frameTotal += seconds;
+		++path.frameCalls;
+	}
+
+	void ProfileStats::AddSample(Path& path, F32 seconds)
+	{
+		auto getBucket = [](F32 seconds) {
+			auto microseconds = seconds * 1e6f;
+			if (microseconds < 1.0f)
+				return 0u;
+
+			return std::min(U32(std::ilogb(microseconds)) + 1, BucketCount - 1);
+		};
+
+		// Drop the oldest sample once the window is full
+		if (path.sampleCount == WindowSize)
+		{
+			auto old = path.samples[path.nextSample];
+			path.sum -= old;
+			--path.histogram[getBucket(old)];
+		}
+		else
+		{
+			++path.sampleCount;
+		}
+
+		path.samples[path.nextSample] = seconds;
+		path.nextSample = (path.nextSample + 1) % WindowSize;
+		path.sum += seconds;
+		++path.histogram[getBucket(seconds)];
+	}
+}
\ No newline at end of file
@@ -2,53 +2,501 @@
 #include "vesp/Console.hpp"
 #include "vesp/Log.hpp"
 #include "vesp/EventManager.hpp"
+#include "vesp/FileSystem.hpp"
+#include "vesp/Metrics.hpp"
 
 #include "vesp/graphics/imgui.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <ctime>
+
 namespace vesp
 {
+	namespace
+	{
+		thread_local RawStringPtr ThreadName = nullptr;
+
+		// Returns the thread's buffer to the profiler when the thread exits
+		struct ThreadBufferOwner
+		{
+			std::atomic<bool>* owned = nullptr;
+
+			~ThreadBufferOwner()
+			{
+				if (this->owned && Profiler::Get())
+					this->owned->store(false, std::memory_order_release);
+			}
+		};
+
+		thread_local ThreadBufferOwner ThreadOwner;
+
+		void AddSectionCounters(Vector<ProfileSectionCounters>& totals, 
+			RawStringPtr title, U32 calls, ProfileCounters const& counters)
+		{
+			auto it = std::find_if(totals.begin(), totals.end(), 
+				[&](ProfileSectionCounters const& section) { return section.title == title; });
+
+			if (it == totals.end())
+			{
+				totals.push_back({title, calls, counters});
+				return;
+			}
+
+			it->calls += calls;
+			it->counters += counters;
+		}
+
+		// Names a new file in data/captures after the current time; files
+		// made within the same second get a suffix
+		void GetCapturePath(RawStringPtr extension, StringByte (&path)[64])
+		{
+			FileSystem::Get()->MakeDirectory("data/captures");
+
+			time_t rawTime;
+			tm timeInfo;
+			time(&rawTime);
+			localtime_s(&timeInfo, &rawTime);
+
+			StringByte name[32];
+			std::strftime(name, sizeof(name), "%Y%m%d-%H%M%S", &timeInfo);
+
+			snprintf(path, sizeof(path), "data/captures/%s.%s", name, extension);
+			for (U32 i = 2; FileSystem::Get()->Exists(path); ++i)
+				snprintf(path, sizeof(path), "data/captures/%s-%u.%s", name, i, extension);
+		}
+	}
+
+	thread_local Profiler::ThreadBuffer* Profiler::threadBuffer_ = nullptr;
+
 	Profiler::Profiler()
+		: threads_(nullptr), threadCount_(0)
 	{
+		this->secondsPerTick_ = util::CycleClock::GetSecondsPerTick();
+
+		this->frames_[0].start = this->frames_[0].end = GetTime();
+		this->frames_[1] = this->frames_[0];
+
+		this->sections_.reserve(ThreadCapacity / 2 + 1);
+		this->sectionStack_.reserve(64);
+
+		SetThreadName("Main");
+
 		Console::Get()->AddCommand("profiler.window", [&] {
 			this->drawGui_ = true;
 		});
 
-		EventManager::Get()->Subscribe("Render.Gui", [&] (void const*) {
+		Console::Get()->AddCommand("profiler.capture", [&](U32 frameCount) {
+			this->StartCapture(ProfileCapture::Format::Json, frameCount);
+		});
+
+		Console::Get()->AddCommand("profiler.captureBinary", [&](U32 frameCount) {
+			this->StartCapture(ProfileCapture::Format::Binary, frameCount);
+		});
+
+		// Writes the JSON form of a binary capture next to it
+		Console::Get()->AddCommand("profiler.decode", [&](std::string path) {
+			auto outputPath = path + ".json";
+			if (ProfileCapture::Decode(path, outputPath))
+				LogInfo("Decoded %s to %s", path.c_str(), outputPath.c_str());
+			else
+				LogError("Failed to decode profile capture %s", path.c_str());
+		});
+
+		// Samples the main thread; a frequency of 0 stops sampling
+		Console::Get()->AddCommand("profiler.sample", [&](U32 frequency) {
+			this->StartSampling(frequency);
+		});
+
+		Console::Get()->AddCommand("profiler.saveSamples", [&] {
+			this->SaveSamples();
+		});
+
+		Console::Get()->AddCommand("profiler.hitchThreshold", [&](F32 milliseconds) {
+			this->hitchThreshold_ = milliseconds;
+		});
+
+		Console::Get()->AddCommand("profiler.resetStats", [&] {
+			this->stats_.Reset();
+			this->hitches_.clear();
+			this->counterTotals_.clear();
+		});
+
+		// Reads an event, e.g. "instructions", from a hardware counter slot
+		// configured for the system
+		Console::Get()->AddCommand("profiler.counterSlot", [&](std::string event, U32 slot) {
+			auto index = ProfileCounters::FindEvent(event);
+			if (index == ProfileCounters::EventCount || index == ProfileCounters::Cycles)
+			{
+				LogError("No hardware event named %s", event.c_str());
+				return;
+			}
+
+			ProfileCounters::SetSlot(index, slot);
+			this->counterTotals_.clear();
+		});
+
+		Console::Get()->AddCommand("profiler.clearCounterSlot", [&](std::string event) {
+			ProfileCounters::SetSlot(ProfileCounters::FindEvent(event), ProfileCounters::NoSlot);
+			this->counterTotals_.clear();
+		});
+
+		this->renderGuiSubscription_ = EventManager::Get()->Subscribe<events::RenderGui>([&] (events::RenderGui const&) {
 			this->Draw();
 			return true;
 		});
 	}
 
-	void Profiler::BeginSection(RawStringPtr title)
+	Profiler::~Profiler()
 	{
-		auto section = std::make_unique<Section>();
-		auto sectionPtr = section.get();
-		section->title = title;
-		section->parent = this->currentSection_;
-		section->parent->children.push_back(std::move(section));
-		this->currentSection_ = sectionPtr;
+		if (auto eventManager = EventManager::Get())
+			eventManager->Unsubscribe(this->renderGuiSubscription_);
+
+		// The sampler reads the main thread's buffer
+		this->sampler_.reset();
+
+		auto buffer = this->threads_.load();
+		while (buffer)
+		{
+			auto next = buffer->next;
+			delete buffer;
+			buffer = next;
+		}
+
+		threadBuffer_ = nullptr;
+		ThreadOwner.owned = nullptr;
 	}
 
-	void Profiler::EndSection()
+	void Profiler::SetThreadName(RawStringPtr name)
 	{
-		this->currentSection_->duration = this->currentSection_->timer.GetSeconds();
-		this->currentSection_ = this->currentSection_->parent;
+		ThreadName = name;
+		if (threadBuffer_)
+			threadBuffer_->name.store(name);
+	}
+
+	Profiler::ThreadBuffer* Profiler::RegisterThread()
+	{
+		VESP_MEMORY_SCOPE(Profiler);
+
+		// Take over the buffer of a thread that has exited
+		ThreadBuffer* buffer = nullptr;
+		for (auto it = this->threads_.load(std::memory_order_acquire); it; it = it->next)
+		{
+			auto owned = false;
+			if (it->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+			{
+				buffer = it;
+				break;
+			}
+		}
+
+		if (!buffer)
+		{
+			buffer = new ThreadBuffer();
+			buffer->records.resize(ThreadCapacity);
+			buffer->write = 0;
+			buffer->read = 0;
+			buffer->dropped = 0;
+			buffer->owned = true;
+			buffer->id = this->threadCount_++;
+			buffer->open.reserve(64);
+			for (U32 i = 0; i < 2; ++i)
+			{
+				buffer->frames[i].resize(ThreadCapacity + 64);
+				buffer->counts[i] = 0;
+				buffer->carried[i] = 0;
+				buffer->droppedCounts[i] = 0;
+			}
+
+			buffer->next = this->threads_.load(std::memory_order_relaxed);
+			while (!this->threads_.compare_exchange_weak(buffer->next, buffer, 
+				std::memory_order_release, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		buffer->openSections = 0;
+		buffer->droppedDepth = 0;
+		buffer->name.store(ThreadName);
+
+		threadBuffer_ = buffer;
+		ThreadOwner.owned = &buffer->owned;
+		return buffer;
+	}
+
+	void Profiler::AddCounters(RawStringPtr title, ProfileCounters const& counters)
+	{
+		VESP_MEMORY_SCOPE(Profiler);
+		std::lock_guard<std::mutex> lock(this->countersMutex_);
+		AddSectionCounters(this->pendingCounters_, title, 1, counters);
+	}
+
+	void Profiler::Drain(ThreadBuffer& buffer, U32 frame)
+	{
+		auto read = buffer.read.load(std::memory_order_relaxed);
+		auto write = buffer.write.load(std::memory_order_acquire);
+
+		// Sections still open from earlier frames lead, so every frame
+		// can be read on its own
+		auto& records = buffer.frames[frame];
+		auto needed = buffer.open.size() + (write - read);
+		if (records.size() < needed)
+			records.resize(needed);
+
+		U32 count = 0;
+		for (auto& record : buffer.open)
+			records[count++] = record;
+		buffer.carried[frame] = count;
+
+		for (; read != write; ++read)
+		{
+			auto& record = buffer.records[read & (ThreadCapacity - 1)];
+			records[count++] = record;
+
+			if (record.title)
+				buffer.open.push_back(record);
+			else if (!buffer.open.empty())
+				buffer.open.pop_back();
+		}
+
+		buffer.read.store(write, std::memory_order_release);
+		buffer.counts[frame] = count;
+		buffer.droppedCounts[frame] = buffer.dropped.exchange(0, std::memory_order_relaxed);
 	}
 
 	void Profiler::BeginFrame()
 	{
 		if (!this->frozen_)
-			this->root_.swap(this->savedRoot_);
+		{
+			this->currentFrame_ ^= 1;
+			this->sectionsValid_ = false;
+		}
 
-		this->root_.reset(new Section());
-		this->root_->title = "Frame";
-		this->root_->parent = nullptr;
-		this->currentSection_ = this->root_.get();
+		this->mainThread_ = threadBuffer_ ? threadBuffer_ : this->RegisterThread();
+		this->frames_[this->currentFrame_].start = GetTime();
 	}
 
 	void Profiler::EndFrame()
 	{
-		this->EndSection();
+		VESP_MEMORY_SCOPE(Profiler);
+		this->frames_[this->currentFrame_].end = GetTime();
+
+		if (this->lanes_.size() != this->threadCount_.load())
+		{
+			this->lanes_.clear();
+			for (auto it = this->threads_.load(std::memory_order_acquire); it; it = it->next)
+				this->lanes_.push_back(it);
+
+			std::sort(this->lanes_.begin(), this->lanes_.end(), 
+				[](ThreadBuffer* a, ThreadBuffer* b) { return a->id < b->id; });
+		}
+
+		for (auto lane : this->lanes_)
+			this->Drain(*lane, this->currentFrame_);
+
+		auto& range = this->frames_[this->currentFrame_];
+		auto frameSeconds = F32(F64(range.end - range.start) * this->secondsPerTick_);
+		++this->frameIndex_;
+
+		this->UpdateStats(frameSeconds);
+		this->UpdateCounters();
+		if (this->hitchThreshold_ > 0.0f && frameSeconds * 1000.0f > this->hitchThreshold_)
+			this->RecordHitch(frameSeconds);
+
+		if (!this->captures_.empty())
+			this->UpdateCaptures();
+	}
+
+	void Profiler::UpdateStats(F32 frameSeconds)
+	{
+		this->stats_.BeginFrame(this->mainThread_->id, frameSeconds);
+		for (auto lane : this->lanes_)
+		{
+			this->stats_.AddLane(lane->id, lane->frames[this->currentFrame_].data(), 
+				lane->counts[this->currentFrame_], this->secondsPerTick_);
+		}
+		this->stats_.EndFrame();
+	}
+
+	void Profiler::UpdateCounters()
+	{
+		this->frameCounters_.clear();
+		{
+			std::lock_guard<std::mutex> lock(this->countersMutex_);
+			this->frameCounters_.swap(this->pendingCounters_);
+		}
+
+		for (auto& section : this->frameCounters_)
+			AddSectionCounters(this->counterTotals_, section.title, section.calls, section.counters);
+	}
+
+	void Profiler::RecordHitch(F32 frameSeconds)
+	{
+		Hitch hitch;
+		hitch.frame = this->frameIndex_;
+		hitch.duration = frameSeconds;
+		this->BuildSections(*this->mainThread_, this->currentFrame_, hitch.sections);
+
+		hitch.log = Logger::Get()->GetRecentLines();
+
+		this->hitches_.push_back(std::move(hitch));
+		if (this->hitches_.size() > MaxHitches)
+			this->hitches_.pop_front();
+
+		LogWarn("Hitch: frame %llu took %.2f ms", this->frameIndex_, frameSeconds * 1000.0f);
+	}
+
+	void Profiler::StartCapture(ProfileCapture::Format format, U32 frameCount)
+	{
+		VESP_MEMORY_SCOPE(Profiler);
+
+		if (frameCount == 0)
+			return;
+
+		StringByte path[64];
+		GetCapturePath(format == ProfileCapture::Format::Json ? "json" : "vspc", path);
+
+		auto capture = std::make_unique<ProfileCapture>(path, format, frameCount, this->secondsPerTick_);
+		if (!capture->IsOpen())
+		{
+			LogError("Failed to open profile capture %s", path);
+			return;
+		}
+
+		LogInfo("Capturing %u frames to %s", frameCount, path);
+		this->captures_.push_back(std::move(capture));
+	}
+
+	void Profiler::StartSampling(U32 frequency)
+	{
+		VESP_MEMORY_SCOPE(Profiler);
+
+		this->sampler_.reset();
+		if (frequency == 0)
+			return;
+
+		// Console commands run on the main thread, which is the one sampled
+		auto buffer = threadBuffer_ ? threadBuffer_ : this->RegisterThread();
+		ProfileSampler::SectionStack sections = {buffer->openTitles.data(), &buffer->openSections, SampledDepth};
+
+		auto sampler = std::make_unique<ProfileSampler>(frequency, sections);
+		if (!sampler->IsRunning())
+		{
+			LogError("Failed to start sampling");
+			return;
+		}
+
+		LogInfo("Sampling the main thread at %u Hz", frequency);
+		this->sampler_ = std::move(sampler);
+	}
+
+	void Profiler::SaveSamples()
+	{
+		if (!this->sampler_)
+		{
+			LogError("No samples to save; start sampling with profiler.sample");
+			return;
+		}
+
+		StringByte path[64];
+		GetCapturePath("folded", path);
+
+		if (!this->sampler_->Save(path))
+		{
+			LogError("Failed to save samples to %s", path);
+			return;
+		}
+
+		LogInfo("Wrote %u samples to %s", this->sampler_->GetSampleCount(), path);
+	}
+
+	void Profiler::UpdateCaptures()
+	{
+		auto& range = this->frames_[this->currentFrame_];
+		for (auto& capture : this->captures_)
+		{
+			if (!capture->GetRemaining())
+				continue;
+
+			ProfileCapture::Frame frame;
+			frame.start = range.start;
+			frame.end = range.end;
+			frame.mainLane = this->mainThread_->id;
+			frame.lanes.resize(this->lanes_.size());
+			frame.counters = this->frameCounters_;
+
+			for (size_t i = 0; i < this->lanes_.size(); ++i)
+			{
+				auto lane = this->lanes_[i];
+				auto& records = lane->frames[this->currentFrame_];
+
+				auto& captureLane = frame.lanes[i];
+				captureLane.id = lane->id;
+				captureLane.name = lane->name.load();
+				captureLane.carried = lane->carried[this->currentFrame_];
+				captureLane.records.assign(records.begin(), records.begin() + lane->counts[this->currentFrame_]);
+			}
+
+			capture->Push(std::move(frame));
+		}
+
+		// Writers finish on their own; only finished captures are released,
+		// so the frame never waits on the disk
+		for (size_t i = 0; i < this->captures_.size();)
+		{
+			auto& capture = this->captures_[i];
+			if (capture->IsDone())
+			{
+				LogInfo("Wrote profile capture %s", capture->GetPath());
+				this->captures_.erase(this->captures_.begin() + i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+	void Profiler::BuildSections(ThreadBuffer const& buffer, U32 frame, Vector<Section>& sections)
+	{
+		sections.clear();
+		this->sectionStack_.clear();
+
+		auto& range = this->frames_[frame];
+		auto& records = buffer.frames[frame];
+		auto secondsPerTick = this->secondsPerTick_;
+		auto close = [&](U64 time) {
+			auto index = this->sectionStack_.back();
+			this->sectionStack_.pop_back();
+
+			auto& section = sections[index];
+			section.duration = F32(F64(time - records[section.size].time) * secondsPerTick);
+			section.size = U32(sections.size()) - index;
+		};
+
+		sections.push_back({"Frame", F32(F64(range.end - range.start) * secondsPerTick), 0, 0});
+		this->sectionStack_.push_back(0);
+
+		for (U32 i = 0; i < buffer.counts[frame]; ++i)
+		{
+			auto& record = records[i];
+			if (record.title)
+			{
+				// Until the section is closed, size holds its begin record
+				this->sectionStack_.push_back(U32(sections.size()));
+				sections.push_back({record.title, 0.0f, this->sectionStack_[this->sectionStack_.size() - 2], i});
+			}
+			else if (this->sectionStack_.size() > 1)
+			{
+				close(record.time);
+			}
+		}
+
+		// Only reachable when sections outlive the frame
+		while (this->sectionStack_.size() > 1)
+			close(range.end);
+
+		sections[0].size = U32(sections.size());
 	}
 
 	void Profiler::Draw()
@@ -57,6 +505,14 @@ namespace vesp
 			return;
 
 		VESP_PROFILE_FN();
+		VESP_MEMORY_SCOPE(Profiler);
+
+		auto savedFrame = this->currentFrame_ ^ 1;
+		if (!this->sectionsValid_ && this->mainThread_)
+		{
+			this->BuildSections(*this->mainThread_, savedFrame, this->sections_);
+			this->sectionsValid_ = true;
+		}
 
 		ImGui::Begin("Profiler", &this->drawGui_, ImGuiWindowFlags_MenuBar);
 		{
@@ -65,21 +521,270 @@ namespace vesp
 				ImGui::MenuItem(this->frozen_ ? "Unfreeze" : "Freeze", nullptr, &this->frozen_);
 				ImGui::EndMenuBar();
 			}
-			this->DrawSection(this->savedRoot_.get());
+
+			if (ImGui::CollapsingHeader("Timeline", ImGuiTreeNodeFlags_DefaultOpen))
+				this->DrawTimeline(savedFrame);
+
+			if (this->sectionsValid_ && ImGui::CollapsingHeader("Main thread", ImGuiTreeNodeFlags_DefaultOpen))
+				this->DrawSection(this->sections_, 0);
+
+			if (ImGui::CollapsingHeader("Statistics"))
+				this->DrawStats();
+
+			if (ImGui::CollapsingHeader("Hardware counters"))
+				this->DrawCounters();
+
+			StringByte hitchesLabel[64];
+			snprintf(hitchesLabel, sizeof(hitchesLabel), "Hitches (%u)###Hitches", U32(this->hitches_.size()));
+			if (ImGui::CollapsingHeader(hitchesLabel))
+				this->DrawHitches();
+
+			if (this->sampler_ && ImGui::CollapsingHeader("Samples"))
+				this->sampler_->Draw();
+
+			if (ImGui::CollapsingHeader("Memory"))
+				MemoryTracker::DrawTable();
+
+			if (Metrics::Get() && ImGui::CollapsingHeader("Metrics"))
+				Metrics::Get()->DrawTable();
 		}
 		ImGui::End();
 	}
+
+	void Profiler::DrawTimeline(U32 frame)
+	{
+		static const U32 MaxDepth = 32;
+
+		auto& range = this->frames_[frame];
+		if (range.end <= range.start)
+			return;
+
+		auto duration = F64(range.end - range.start);
+		auto width = ImGui::GetContentRegionAvailWidth();
+		auto rowHeight = ImGui::GetTextLineHeight() + 2.0f;
+		auto drawList = ImGui::GetWindowDrawList();
+
+		for (auto lane : this->lanes_)
+		{
+			auto name = lane->name.load();
+			if (name)
+				ImGui::Text("%s", name);
+			else
+				ImGui::Text("Thread %u", lane->id);
+
+			if (lane->droppedCounts[frame])
+			{
+				ImGui::SameLine();
+				ImGui::TextDisabled("(%u sections dropped)", lane->droppedCounts[frame]);
+			}
+
+			auto& records = lane->frames[frame];
+			auto count = lane->counts[frame];
+
+			U32 depth = 0;
+			U32 maxDepth = 1;
+			for (U32 i = 0; i < count; ++i)
+			{
+				if (records[i].title)
+					maxDepth = std::max(maxDepth, ++depth);
+				else if (depth)
+					--depth;
+			}
+
+			auto origin = ImGui::GetCursorScreenPos();
+			ImGui::Dummy(ImVec2(width, std::min(maxDepth, MaxDepth) * rowHeight));
+
+			auto drawBar = [&](Record const& begin, U64 end, U32 row) {
+				auto start = std::max(begin.time, range.start);
+				end = std::min(end, range.end);
+				if (end < start)
+					return;
+
+				ImVec2 min(origin.x + F32(F64(start - range.start) / duration) * width, origin.y + row * rowHeight);
+				ImVec2 max(origin.x + F32(F64(end - range.start) / duration) * width, min.y + rowHeight - 1.0f);
+				max.x = std::max(max.x, min.x + 1.0f);
+
+				// Colour by title so a section keeps its colour across frames
+				auto hue = F32((U32(size_t(begin.title) >> 3) * 2654435761u) >> 24) / 255.0f;
+				float r, g, b;
+				ImGui::ColorConvertHSVtoRGB(hue, 0.6f, 0.7f, r, g, b);
+				drawList->AddRectFilled(min, max, ImGui::ColorConvertFloat4ToU32(ImVec4(r, g, b, 1.0f)));
+
+				if (ImGui::CalcTextSize(begin.title).x + 4.0f < max.x - min.x)
+					drawList->AddText(ImVec2(min.x + 2.0f, min.y + 1.0f), 0xFFFFFFFF, begin.title);
+
+				if (ImGui::IsMouseHoveringRect(min, max))
+					ImGui::SetTooltip("%s (%f ms)", begin.title, F64(end - begin.time) * this->secondsPerTick_ * 1000.0);
+			};
+
+			Record stack[MaxDepth];
+			depth = 0;
+			for (U32 i = 0; i < count; ++i)
+			{
+				auto& record = records[i];
+				if (record.title)
+				{
+					if (depth < MaxDepth)
+						stack[depth] = record;
+					++depth;
+				}
+				else if (depth)
+				{
+					--depth;
+					if (depth < MaxDepth)
+						drawBar(stack[depth], record.time, depth);
+				}
+			}
+
+			// Sections still running when the frame ended
+			while (depth)
+			{
+				--depth;
+				if (depth < MaxDepth)
+					drawBar(stack[depth], range.end, depth);
+			}
+		}
+	}
+	
+	void Profiler::DrawStats()
+	{
+		ImGui::Columns(7, "Statistics");
+		for (auto heading : {"Section", "Calls", "Mean", "p50", "p95", "p99", "Max"})
+		{
+			ImGui::Text("%s", heading);
+			ImGui::NextColumn();
+		}
+		ImGui::Separator();
+
+		for (auto lane : this->lanes_)
+		{
+			for (auto path : this->stats_.GetPaths())
+			{
+				if (path->lane != lane->id)
+					continue;
+
+				auto summary = this->stats_.Summarise(*path);
+				auto name = lane->name.load();
+
+				// Top level sections of other threads are labelled with the thread
+				if (path->depth == 0 && lane != this->mainThread_)
+					ImGui::Text("%s: %s", name ? name : "Thread", path->title);
+				else
+					ImGui::Text("%*s%s", path->depth * 2, "", path->title);
+
+				if (ImGui::IsItemHovered())
+				{
+					Array<F32, ProfileStats::BucketCount> histogram;
+					for (U32 i = 0; i < histogram.size(); ++i)
+						histogram[i] = F32(path->histogram[i]);
+
+					ImGui::BeginTooltip();
+					ImGui::Text("%u frames, min %.3f ms. Buckets double from 1 us:", summary.count, summary.min * 1000.0f);
+					ImGui::PlotHistogram("", histogram.data(), S32(histogram.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(320, 80));
+					ImGui::EndTooltip();
+				}
+				ImGui::NextColumn();
+
+				ImGui::Text("%u", path->lastCalls);
+				ImGui::NextColumn();
+
+				for (auto value : {summary.mean, summary.p50, summary.p95, summary.p99, summary.max})
+				{
+					ImGui::Text("%.3f", value * 1000.0f);
+					ImGui::NextColumn();
+				}
+			}
+		}
+
+		ImGui::Columns(1);
+	}
+
+	void Profiler::DrawCounters()
+	{
+		if (this->counterTotals_.empty())
+		{
+			ImGui::TextDisabled("No counted sections have run; mark them with VESP_PROFILE_COUNTERS");
+			return;
+		}
+
+		// Events are per call; misses are per thousand instructions
+		ImGui::Columns(8, "Counters");
+		for (auto heading : {"Section", "Calls", "Cycles", "Instructions", "IPC", "L1 MPKI", "LLC MPKI", "Branch MPKI"})
+		{
+			ImGui::Text("%s", heading);
+			ImGui::NextColumn();
+		}
+		ImGui::Separator();
+
+		auto showValue = [](F32 value, RawStringPtr format) {
+			if (value >= 0.0f)
+				ImGui::Text(format, value);
+			else
+				ImGui::TextDisabled("-");
+			ImGui::NextColumn();
+		};
+
+		auto onlyCycles = true;
+		for (auto& section : this->counterTotals_)
+		{
+			auto& counters = section.counters;
+			onlyCycles &= !counters.Has(ProfileCounters::Instructions);
+
+			ImGui::Text("%s", section.title);
+			ImGui::NextColumn();
+			ImGui::Text("%u", section.calls);
+			ImGui::NextColumn();
+
+			for (auto event : {ProfileCounters::Cycles, ProfileCounters::Instructions})
+			{
+				auto perCall = F32(F64(counters.values[event]) / section.calls);
+				showValue(counters.Has(event) ? perCall : -1.0f, "%.0f");
+			}
+
+			showValue(counters.GetInstructionsPerCycle(), "%.2f");
+			for (auto event : {ProfileCounters::L1Misses, ProfileCounters::LLCMisses, ProfileCounters::BranchMisses})
+				showValue(counters.GetPerThousandInstructions(event), "%.2f");
+		}
+
+		ImGui::Columns(1);
+
+		if (onlyCycles)
+			ImGui::TextDisabled("Only cycles are available; assign counter slots with profiler.counterSlot");
+	}
+
+	void Profiler::DrawHitches()
+	{
+		ImGui::Text("Threshold: %.2f ms", this->hitchThreshold_);
+
+		for (auto it = this->hitches_.rbegin(); it != this->hitches_.rend(); ++it)
+		{
+			auto& hitch = *it;
+			if (ImGui::TreeNode(&hitch, "Frame %llu: %.2f ms", hitch.frame, hitch.duration * 1000.0f))
+			{
+				this->DrawSection(hitch.sections, 0);
+
+				if (ImGui::TreeNode("Log"))
+				{
+					for (auto& line : hitch.log)
+						ImGui::TextUnformatted(line.data(), line.data() + line.size());
+					ImGui::TreePop();
+				}
+
+				ImGui::TreePop();
+			}
+		}
+	}
 	
-	void Profiler::DrawSection(Section* section)
+	void Profiler::DrawSection(Vector<Section> const& sections, U32 index)
 	{
-		auto makeTreeNode = [](Section* section, float duration, RawStringPtr title = nullptr, RawStringPtr id = nullptr) {
-			auto parentDuration = section->parent ? section->parent->duration : section->duration;
+		auto makeTreeNode = [&](Section const& section, float duration, RawStringPtr title = nullptr, RawStringPtr id = nullptr) {
+			auto parentDuration = sections[section.parent].duration;
 			auto fraction = duration / parentDuration;  
 			auto percentage = fraction * 100.0f;
-			auto isLeafNode = section->children.size() == 0 || id != nullptr;
+			auto isLeafNode = section.size == 1 || id != nullptr;
 
 			if (!title)
-				title = section->title;
+				title = section.title;
 
 			if (!id)
 				id = title;
@@ -96,19 +801,20 @@ namespace vesp
 			return ret;
 		};
 
-		if (makeTreeNode(section, section->duration))
+		auto& section = sections[index];
+		if (makeTreeNode(section, section.duration))
 		{
-			auto unaccountedFor = section->duration;
-			for (auto& child : section->children)
+			auto unaccountedFor = section.duration;
+			for (auto child = index + 1; child < index + section.size; child += sections[child].size)
 			{
-				this->DrawSection(child.get());
-				unaccountedFor -= child->duration;
+				this->DrawSection(sections, child);
+				unaccountedFor -= sections[child].duration;
 			}
 
-			auto treeId = Concat(section->title, " unaccounted");
+			auto treeId = Concat(section.title, " unaccounted");
 			treeId.push_back('\0');
 			
-			if (unaccountedFor > 0.0f && section->children.size())
+			if (unaccountedFor > 0.0f && section.size > 1)
 				if (makeTreeNode(section, unaccountedFor, "Unaccounted", treeId.data()))
 					ImGui::TreePop();
 
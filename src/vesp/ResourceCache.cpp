@@ -0,0 +1,282 @@
+#include "vesp/ResourceCache.hpp"
+#include "vesp/Console.hpp"
+#include "vesp/Log.hpp"
+
+#include <algorithm>
+
+namespace vesp
+{
+	// ResourceHandle
+	ResourceHandle::ResourceHandle()
+	{
+	}
+
+	ResourceHandle::ResourceHandle(ResourceEntry* entry)
+	{
+		this->entry_ = entry;
+		ResourceCache::Get()->AddReference(this->entry_);
+	}
+
+	ResourceHandle::ResourceHandle(ResourceHandle const& rhs)
+	{
+		this->entry_ = rhs.entry_;
+		if (this->entry_)
+			ResourceCache::Get()->AddReference(this->entry_);
+	}
+
+	ResourceHandle::ResourceHandle(ResourceHandle&& rhs)
+	{
+		std::swap(this->entry_, rhs.entry_);
+	}
+
+	ResourceHandle::~ResourceHandle()
+	{
+		if (this->entry_)
+			ResourceCache::Get()->RemoveReference(this->entry_);
+	}
+
+	ResourceHandle& ResourceHandle::operator=(ResourceHandle rhs)
+	{
+		std::swap(this->entry_, rhs.entry_);
+		return *this;
+	}
+
+	bool ResourceHandle::IsValid() const
+	{
+		return this->entry_ != nullptr;
+	}
+
+	bool ResourceHandle::IsReady() const
+	{
+		return this->IsValid() && this->entry_->state == ResourceState::Ready;
+	}
+
+	bool ResourceHandle::HasFailed() const
+	{
+		return this->IsValid() && this->entry_->state == ResourceState::Failed;
+	}
+
+	StringView ResourceHandle::GetPath() const
+	{
+		VESP_ASSERT(this->IsValid());
+		return StringView(this->entry_->path);
+	}
+
+	// ResourceCache
+	ResourceCache::ResourceCache(size_t budget)
+	{
+		this->budget_ = budget;
+
+		Console::Get()->AddCommand("resource.stats", [&]() {
+			this->LogStats();
+		});
+
+		Console::Get()->AddCommand("resource.budget", [&](F32 megabytes) {
+			this->SetBudget(size_t(megabytes * 1024 * 1024));
+			this->LogStats();
+		});
+	}
+
+	ResourceCache::~ResourceCache()
+	{
+		for (auto& bucket : this->entries_)
+		{
+			for (auto& entry : bucket.second)
+			{
+				if (entry->refCount > 0)
+				{
+					LogWarn("Resource %.*s still has %u references at shutdown",
+						entry->path.size(), entry->path.data(), entry->refCount);
+				}
+			}
+		}
+	}
+
+	void ResourceCache::SetBudget(size_t budget)
+	{
+		this->budget_ = budget;
+		this->Trim();
+	}
+
+	size_t ResourceCache::GetBudget() const
+	{
+		return this->budget_;
+	}
+
+	size_t ResourceCache::GetUsage() const
+	{
+		return this->usage_;
+	}
+
+	void ResourceCache::Trim()
+	{
+		while (this->usage_ > this->budget_ && this->lruHead_)
+		{
+			auto entry = this->lruHead_;
+			this->UnlinkLru(entry);
+			this->Erase(entry);
+			++this->evictions_;
+		}
+	}
+
+	ResourceEntry* ResourceCache::Find(U32 key, StringView path, void const* type)
+	{
+		auto it = this->entries_.find(key);
+		if (it == this->entries_.end())
+			return nullptr;
+
+		// A path loaded as another type is a separate resource
+		for (auto& entry : it->second)
+		{
+			if (entry->type == type && StringView(entry->path) == path)
+				return entry.get();
+		}
+
+		return nullptr;
+	}
+
+	ResourceEntry* ResourceCache::Insert(U32 key, StringView path, void const* type)
+	{
+		auto entry = std::make_unique<ResourceEntry>();
+		entry->key = key;
+		entry->path = path.CopyToVector();
+		entry->type = type;
+
+		auto entryPtr = entry.get();
+		this->entries_[key].push_back(std::move(entry));
+
+		return entryPtr;
+	}
+
+	UniquePtr<ResourceEntry> ResourceCache::Detach(ResourceEntry* entry)
+	{
+		auto it = this->entries_.find(entry->key);
+		VESP_ASSERT(it != this->entries_.end());
+
+		auto& bucket = it->second;
+		auto position = std::find_if(bucket.begin(), bucket.end(),
+			[entry](UniquePtr<ResourceEntry> const& e) { return e.get() == entry; });
+		VESP_ASSERT(position != bucket.end());
+
+		auto owned = std::move(*position);
+		bucket.erase(position);
+		if (bucket.empty())
+			this->entries_.erase(it);
+
+		return owned;
+	}
+
+	void ResourceCache::Erase(ResourceEntry* entry)
+	{
+		VESP_ASSERT(entry->refCount == 0);
+
+		this->usage_ -= entry->size;
+		this->Detach(entry);
+	}
+
+	void ResourceCache::Complete(ResourceEntry* entry, std::shared_ptr<void> resource, std::function<size_t ()> measure)
+	{
+		entry->resource = std::move(resource);
+		entry->state = ResourceState::Ready;
+
+		// Hold a reference while the callbacks run, as they may release the
+		// last handle to this entry
+		++entry->refCount;
+
+		auto callbacks = std::move(entry->callbacks);
+		for (auto& callback : callbacks)
+			callback(entry->resource.get());
+
+		entry->size = measure();
+		this->usage_ += entry->size;
+
+		this->RemoveReference(entry);
+		this->Trim();
+	}
+
+	void ResourceCache::Fail(ResourceEntry* entry)
+	{
+		entry->state = ResourceState::Failed;
+		entry->callbacks.clear();
+
+		// Failures are not cached, so a later load will try again. Handles
+		// to this attempt keep it alive until they are released.
+		auto owned = this->Detach(entry);
+		if (entry->refCount > 0)
+			this->failed_.push_back(std::move(owned));
+	}
+
+	void ResourceCache::AddReference(ResourceEntry* entry)
+	{
+		if (entry->refCount == 0 && entry->state == ResourceState::Ready)
+			this->UnlinkLru(entry);
+
+		++entry->refCount;
+	}
+
+	void ResourceCache::RemoveReference(ResourceEntry* entry)
+	{
+		VESP_ASSERT(entry->refCount > 0);
+		if (--entry->refCount > 0)
+			return;
+
+		switch (entry->state)
+		{
+		case ResourceState::Ready:
+			this->LinkLru(entry);
+			this->Trim();
+			break;
+		case ResourceState::Failed:
+		{
+			auto position = std::find_if(this->failed_.begin(), this->failed_.end(),
+				[entry](UniquePtr<ResourceEntry> const& e) { return e.get() == entry; });
+			VESP_ASSERT(position != this->failed_.end());
+			this->failed_.erase(position);
+			break;
+		}
+		case ResourceState::Loading:
+			break;
+		}
+	}
+
+	void ResourceCache::LinkLru(ResourceEntry* entry)
+	{
+		entry->lruPrev = this->lruTail_;
+		entry->lruNext = nullptr;
+
+		if (this->lruTail_)
+			this->lruTail_->lruNext = entry;
+		else
+			this->lruHead_ = entry;
+
+		this->lruTail_ = entry;
+	}
+
+	void ResourceCache::UnlinkLru(ResourceEntry* entry)
+	{
+		if (entry->lruPrev)
+			entry->lruPrev->lruNext = entry->lruNext;
+		else
+			this->lruHead_ = entry->lruNext;
+
+		if (entry->lruNext)
+			entry->lruNext->lruPrev = entry->lruPrev;
+		else
+			this->lruTail_ = entry->lruPrev;
+
+		entry->lruPrev = nullptr;
+		entry->lruNext = nullptr;
+	}
+
+	void ResourceCache::LogStats()
+	{
+		size_t entryCount = 0;
+		for (auto& bucket : this->entries_)
+			entryCount += bucket.second.size();
+
+		LogInfo("Resources: %u entries, %.2f / %.2f MB, %u hits, %u misses, %u evictions",
+			U32(entryCount), 
+			this->usage_ / (1024.0f * 1024.0f), this->budget_ / (1024.0f * 1024.0f),
+			this->hits_, this->misses_, this->evictions_);
+	}
+}
\ No newline at end of file
@@ -137,7 +137,8 @@ namespace vesp
 
 	bool operator==(StringView const lhs, StringView const rhs)
 	{
-		return memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+		return lhs.size() == rhs.size() && 
+			memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
 	}
 
 	bool operator!=(StringView const lhs, StringView const rhs)
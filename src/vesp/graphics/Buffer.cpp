@@ -3,6 +3,8 @@
 
 namespace vesp { namespace graphics {
 
+	Counter UploadedBufferBytes("buffer_bytes_uploaded", "Bytes copied into GPU buffers");
+
 	bool VertexBuffer::Create(ArrayView<Vertex> const array, D3D11_USAGE usage)
 	{
 		return Buffer<Vertex>::Create(array, D3D11_BIND_VERTEX_BUFFER, usage);
@@ -18,15 +20,20 @@ namespace vesp { namespace graphics {
 
 	bool IndexBuffer::Create(ArrayView<U32> const array, D3D11_USAGE usage)
 	{
+		this->format_ = DXGI_FORMAT_R32_UINT;
 		return Buffer<U32>::Create(array, D3D11_BIND_INDEX_BUFFER, usage);
 	}
 
+	bool IndexBuffer::Create(ArrayView<U16> const array, D3D11_USAGE usage)
+	{
+		this->format_ = DXGI_FORMAT_R16_UINT;
+		return this->CreateFrom(array, D3D11_BIND_INDEX_BUFFER, usage);
+	}
+
 	void IndexBuffer::Use()
 	{
-		U32 stride = sizeof(U32);
-		U32 offset = 0;
 		Engine::ImmediateContext->IASetIndexBuffer(
-			this->buffer_, DXGI_FORMAT_R32_UINT, 0);
+			this->buffer_, this->format_, 0);
 	}
 
 } }
\ No newline at end of file
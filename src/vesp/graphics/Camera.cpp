@@ -2,6 +2,10 @@
 #include "vesp/graphics/Camera.hpp"
 #include "vesp/graphics/Window.hpp"
 
+#include "vesp/Assert.hpp"
+
+#include <cmath>
+
 namespace vesp { namespace graphics {
 
 	Camera::Camera()
@@ -35,12 +39,64 @@ namespace vesp { namespace graphics {
 			this->nearPlane_, 
 			this->farPlane_);
 		this->viewProjection_ = this->projection_ * this->view_;
+
+		this->CalculateEyes();
+	}
+
+	void Camera::CalculateEyes()
+	{
+		if (!this->stereo_)
+		{
+			for (auto& eye : this->eyes_)
+			{
+				eye.view = this->view_;
+				eye.projection = this->projection_;
+				eye.viewProjection = this->viewProjection_;
+				eye.offset = 0.0f;
+			}
+
+			this->cullingViewProjection_ = this->viewProjection_;
+			return;
+		}
+
+		auto fovY = glm::radians(this->fov_);
+		auto eyeAspectRatio = this->aspectRatio_ / 2.0f;
+		auto projection = math::DXPerspective(
+			fovY, eyeAspectRatio, this->nearPlane_, this->farPlane_);
+
+		auto halfSeparation = this->eyeSeparation_ / 2.0f;
+		for (U32 i = 0; i < 2; ++i)
+		{
+			// The left eye sits at -x, so the scene shifts towards +x for it
+			auto offset = i == 0 ? halfSeparation : -halfSeparation;
+
+			auto& eye = this->eyes_[i];
+			eye.view = glm::translate(Mat4(), Vec3(offset, 0.0f, 0.0f)) * this->view_;
+			eye.projection = projection;
+			eye.viewProjection = projection * eye.view;
+			eye.offset = offset;
+		}
+
+		// Pull a camera with the same field of view back along its axis until
+		// its side planes meet the outer planes of the eyes. The near and far
+		// planes move back with it so they stay where the eyes' are.
+		auto tanHalfFovX = std::tan(fovY / 2.0f) * eyeAspectRatio;
+		auto pullBack = halfSeparation / tanHalfFovX;
+
+		auto cullingView = glm::translate(Mat4(), Vec3(0.0f, 0.0f, pullBack)) * this->view_;
+		auto cullingProjection = math::DXPerspective(
+			fovY, eyeAspectRatio, this->nearPlane_ + pullBack, this->farPlane_ + pullBack);
+
+		this->cullingViewProjection_ = cullingProjection * cullingView;
 	}
 
 	Camera::PerFrameConstants Camera::MakeConstants()
 	{
-		PerFrameConstants constants;
+		PerFrameConstants constants = {};
 		constants.viewProjection = this->viewProjection_;
+		constants.eyeViewProjection[0] = this->eyes_[0].viewProjection;
+		constants.eyeViewProjection[1] = this->eyes_[1].viewProjection;
+		constants.eyeCount = this->GetEyeCount();
 
 		return constants;
 	}
@@ -55,6 +111,64 @@ namespace vesp { namespace graphics {
 		return this->projection_;
 	}
 
+	F32 Camera::GetFieldOfView() const
+	{
+		return this->fov_;
+	}
+
+	F32 Camera::GetAspectRatio() const
+	{
+		return this->aspectRatio_;
+	}
+
+	F32 Camera::GetNearPlane() const
+	{
+		return this->nearPlane_;
+	}
+
+	F32 Camera::GetFarPlane() const
+	{
+		return this->farPlane_;
+	}
+
+	void Camera::SetStereo(bool enabled)
+	{
+		this->stereo_ = enabled;
+		this->CalculateMatrices();
+	}
+
+	bool Camera::IsStereo() const
+	{
+		return this->stereo_;
+	}
+
+	void Camera::SetEyeSeparation(F32 separation)
+	{
+		this->eyeSeparation_ = separation;
+		this->CalculateMatrices();
+	}
+
+	U32 Camera::GetEyeCount() const
+	{
+		return this->stereo_ ? 2 : 1;
+	}
+
+	StereoEye const& Camera::GetEye(U32 eye)
+	{
+		VESP_ASSERT(eye < this->eyes_.size());
+		return this->eyes_[eye];
+	}
+
+	Mat4 const& Camera::GetCullingViewProjection()
+	{
+		return this->cullingViewProjection_;
+	}
+
+	Mat4 const& Camera::GetViewProjection()
+	{
+		return this->viewProjection_;
+	}
+
     void* Camera::operator new(size_t i)
     {
         return _mm_malloc(i,16);
@@ -0,0 +1,128 @@
+#include "vesp/graphics/ClusteredLighting.hpp"
+#include "vesp/graphics/Camera.hpp"
+
+#include "vesp/util/Timer.hpp"
+
+#include "vesp/Console.hpp"
+#include "vesp/Log.hpp"
+#include "vesp/Metrics.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace vesp { namespace graphics {
+
+	namespace
+	{
+		Gauge VisibleLights("lights_visible", "Lights intersecting the view frustum");
+	}
+
+	ClusteredLighting::ClusteredLighting()
+	{
+		LightingConstants constants = {};
+		this->constantBuffer_.Create(constants);
+
+		Console::Get()->AddCommand("lights.stats", [&]() {
+			this->LogStats();
+		});
+
+		Console::Get()->AddCommand("lights.benchmark", [&](U32 lightCount) {
+			this->Benchmark(lightCount);
+		});
+	}
+
+	Vector<PointLight>& ClusteredLighting::GetLights()
+	{
+		return this->lights_;
+	}
+
+	void ClusteredLighting::Update(Camera& camera)
+	{
+		auto farPlane = std::min(camera.GetFarPlane(), F32(MaxLightDistance));
+		Vec4 projectionParameters(camera.GetFieldOfView(), camera.GetAspectRatio(), 
+			camera.GetNearPlane(), farPlane);
+
+		if (projectionParameters != this->projectionParameters_)
+		{
+			this->culler_.SetProjection(glm::radians(projectionParameters.x), 
+				projectionParameters.y, projectionParameters.z, projectionParameters.w);
+			this->projectionParameters_ = projectionParameters;
+		}
+
+		util::CycleTimer timer;
+		this->culler_.Assign(this->lights_, camera.GetView());
+		this->assignTime_ = timer.GetMilliseconds();
+
+		auto viewLights = this->culler_.GetViewLights();
+		VisibleLights.Set(F64(viewLights.size()));
+		this->lightBuffer_.Load(viewLights);
+		this->clusterBuffer_.Load(this->culler_.GetClusters());
+		this->lightIndexBuffer_.Load(this->culler_.GetLightIndices());
+
+		LightingConstants constants = {};
+		constants.projection = camera.GetProjection();
+		constants.eyeCount = camera.GetEyeCount();
+		for (U32 i = 0; i < 2; ++i)
+		{
+			auto& eye = camera.GetEye(i);
+			constants.inverseEyeProjection[i] = glm::inverse(eye.projection);
+			constants.eyeOffset[i] = eye.offset;
+		}
+
+		constants.sliceScale = this->culler_.GetSliceScale();
+		constants.sliceBias = this->culler_.GetSliceBias();
+		constants.lightCount = U32(viewLights.size());
+		constants.clusterCounts[0] = LightCuller::TilesX;
+		constants.clusterCounts[1] = LightCuller::TilesY;
+		constants.clusterCounts[2] = LightCuller::Slices;
+
+		this->constantBuffer_.Load(constants);
+	}
+
+	void ClusteredLighting::Use()
+	{
+		this->lightBuffer_.UsePS(3);
+		this->clusterBuffer_.UsePS(4);
+		this->lightIndexBuffer_.UsePS(5);
+		this->constantBuffer_.UsePS(2);
+	}
+
+	void ClusteredLighting::LogStats()
+	{
+		LogInfo("Lights: %u total, %u in view, %u cluster entries, assigned in %.3f ms",
+			U32(this->lights_.size()), U32(this->culler_.GetViewLights().size()),
+			U32(this->culler_.GetLightIndices().size()), this->assignTime_);
+	}
+
+	void ClusteredLighting::Benchmark(U32 lightCount)
+	{
+		// Random lights in front of a fixed camera, so runs are comparable
+		lightCount = std::min(lightCount, 0xFFFFu);
+		std::mt19937 generator(lightCount);
+		std::uniform_real_distribution<F32> position(-200.0f, 200.0f);
+		std::uniform_real_distribution<F32> radius(2.0f, 20.0f);
+
+		Vector<PointLight> lights(lightCount);
+		for (auto& light : lights)
+		{
+			light.position = Vec3(position(generator), position(generator) / 10.0f, 
+				position(generator) + 200.0f);
+			light.radius = radius(generator);
+			light.colour = Vec3(1.0f);
+			light.intensity = 1.0f;
+		}
+
+		LightCuller culler;
+		culler.SetProjection(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, F32(MaxLightDistance));
+
+		const U32 Iterations = 100;
+		util::Timer timer;
+		for (U32 i = 0; i < Iterations; ++i)
+			culler.Assign(lights, Mat4());
+
+		LogInfo("Assigned %u lights (%u in view, %u cluster entries) in %.3f ms on average",
+			lightCount, U32(culler.GetViewLights().size()), 
+			U32(culler.GetLightIndices().size()), timer.GetMilliseconds() / Iterations);
+	}
+
+} }
\ No newline at end of file
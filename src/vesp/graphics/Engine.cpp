@@ -5,13 +5,19 @@
 #include "vesp/graphics/Buffer.hpp"
 #include "vesp/graphics/FreeCamera.hpp"
 #include "vesp/graphics/Mesh.hpp"
+#include "vesp/graphics/MeshOptimiser.hpp"
+#include "vesp/graphics/MeshFile.hpp"
+#include "vesp/graphics/OcclusionCuller.hpp"
+#include "vesp/graphics/ClusteredLighting.hpp"
 #include "vesp/graphics/imgui.h"
 #include "vesp/graphics/imgui_impl_dx11.h"
 #include "vesp/graphics/ShaderManager.hpp"
+#include "vesp/graphics/TextureBuilder.hpp"
 
 #include "vesp/math/Vector.hpp"
 #include "vesp/math/Matrix.hpp"
 #include "vesp/math/Util.hpp"
+#include "vesp/math/Frustum.hpp"
 
 #include "vesp/world/HeightMapTerrain.hpp"
 #include "vesp/world/ScalarField.hpp"
@@ -20,12 +26,14 @@
 #include "vesp/Log.hpp"
 #include "vesp/Assert.hpp"
 #include "vesp/Console.hpp"
+#include "vesp/FileSystem.hpp"
 #include "vesp/EventManager.hpp"
 #include "vesp/Profiler.hpp"
 
 #include <glm/gtc/noise.hpp>
 
 #include <deque>
+#include <random>
 #include <d3d11.h>
 
 namespace vesp { namespace graphics {
@@ -153,8 +161,13 @@ namespace vesp { namespace graphics {
 		this->CreateRenderTargets(size);
 		this->CreateBlendState();
 		this->CreateSamplerState();
+
+		this->lighting_ = std::make_unique<ClusteredLighting>();
 		this->CreateTestData();
 
+		this->occlusionCuller_ = std::make_unique<OcclusionCuller>();
+		this->AddCommands();
+
 		ImGui_ImplDX11_Init(
 			this->window_->GetSystemRepresentation(), Device, ImmediateContext);
 		SetupImGuiStyle(true, 0.9f);
@@ -194,6 +207,7 @@ namespace vesp { namespace graphics {
 	void Engine::Pulse()
 	{
 		VESP_PROFILE_FN();
+		VESP_MEMORY_SCOPE(Graphics);
 		
 		{
 			VESP_PROFILE_BLOCK("Initial State Update"); 
@@ -238,17 +252,42 @@ namespace vesp { namespace graphics {
 			auto freeCamera = static_cast<FreeCamera*>(this->camera_.get());
 			freeCamera->Update();
 
+			{
+				VESP_PROFILE_BLOCK("Light assignment");
+				this->lighting_->Update(*freeCamera);
+			}
+
+			// The culling frustum covers both eyes in stereo, but occlusion
+			// from a single viewpoint is not conservative for either eye
+			this->cullingViewProjection_ = freeCamera->GetCullingViewProjection();
+			this->occlusionActive_ = this->occlusionEnabled_ && !freeCamera->IsStereo();
+
+			if (this->occlusionActive_)
+			{
+				// The software rasteriser and the mesh loop are the CPU-bound
+				// parts of the frame, so they also read the hardware counters
+				VESP_PROFILE_COUNTERS("Occlusion");
+				auto culler = this->occlusionCuller_.get();
+				culler->Begin(freeCamera->GetViewProjection());
+				world::HeightMapTerrain::Get()->AddOccluders(*culler);
+				world::Script::Get()->AddOccluders(*culler);
+				culler->Finish();
+			}
+
 			this->SetDepthEnabled(false);
 			skyMesh.Draw();
 			this->SetDepthEnabled(true);
 
-			world::HeightMapTerrain::Get()->Draw();
-			world::Script::Get()->Draw();
-
 			{
-				VESP_PROFILE_BLOCK("Mesh drawing");
+				VESP_PROFILE_COUNTERS("Mesh drawing");
+				world::HeightMapTerrain::Get()->Draw();
+				world::Script::Get()->Draw();
+
 				for (auto& mesh : this->meshes_)
-					mesh.Draw();
+				{
+					if (this->IsVisible(mesh))
+						mesh.Draw();
+				}
 			}
 		}
 		
@@ -260,6 +299,7 @@ namespace vesp { namespace graphics {
 			
 			ImmediateContext->PSSetShaderResources(0, this->renderTargetResourceViews_.size(), 
 				reinterpret_cast<ID3D11ShaderResourceView**>(this->renderTargetResourceViews_.data()));
+			this->lighting_->Use();
 
 			// Draw composite view to backbuffer
 			this->SetDepthEnabled(false);
@@ -290,7 +330,7 @@ namespace vesp { namespace graphics {
 			ImGui::PlotLines("FPS",
 				[](void* data, int index)
 				{
-					return (*reinterpret_cast<std::deque<float>*>(data))[index];
+					return (*reinterpret_cast<Deque<F32>*>(data))[index];
 				},
 				(void*)&this->fpsRecord_, this->fpsRecord_.size());
 			ImGui::PopItemWidth();
@@ -324,7 +364,7 @@ namespace vesp { namespace graphics {
 
 		{ 
 			VESP_PROFILE_BLOCK("GUI render event");
-			EventManager::Get()->Fire("Render.Gui");
+			EventManager::Get()->Fire(events::RenderGui());
 		}
 
 		{
@@ -349,6 +389,18 @@ namespace vesp { namespace graphics {
 		return this->camera_.get();
 	}
 
+	bool Engine::IsVisible(Mesh& mesh)
+	{
+		auto world = mesh.GetWorld();
+
+		auto frustum = math::Frustum::FromMatrix(this->cullingViewProjection_ * world);
+		if (!frustum.Intersects(mesh.GetBoundsMin(), mesh.GetBoundsMax()))
+			return false;
+
+		return !this->occlusionActive_ || 
+			this->occlusionCuller_->IsVisible(mesh.GetBoundsMin(), mesh.GetBoundsMax(), world);
+	}
+
 	void Engine::SetBlendingEnabled(bool state)
 	{
 		ImmediateContext->OMSetBlendState(
@@ -610,10 +662,12 @@ namespace vesp { namespace graphics {
 		screenMesh.Create(screenVertices);
 		screenMesh.SetVertexShader("identity");
 		screenMesh.SetPixelShader("composite");
+		screenMesh.SetStereoInstancing(false);
 
 		skyMesh.Create(screenVertices);
 		skyMesh.SetVertexShader("identity");
 		skyMesh.SetPixelShader("sky");
+		skyMesh.SetStereoInstancing(false);
 
 		auto scalarField = MakeAlignedUnique<world::ScalarField>();
 		scalarField->LoadFromFunction(32, 32, 32, [](Vec3 const& p) {
@@ -622,11 +676,112 @@ namespace vesp { namespace graphics {
 		auto scalarFieldVerts = scalarField->Polygonise(0.0f);
 
 		graphics::Mesh scalarFieldMesh;
-		scalarFieldMesh.Create(scalarFieldVerts);
+		MeshOptimiserStats scalarFieldStats;
+		scalarFieldMesh.CreateOptimised(scalarFieldVerts, &scalarFieldStats);
+		scalarFieldStats.LogSummary("Scalar field");
 		scalarFieldMesh.SetVertexShader("default");
 		scalarFieldMesh.SetPixelShader("default");
 
 		this->meshes_.push_back(scalarFieldMesh);
+
+		MeshFile floorFile;
+		if (floorFile.Load("data/FloorMesh.vspm"))
+		{
+			graphics::Mesh floorMesh;
+			floorFile.CreateMesh(floorMesh);
+			floorMesh.SetVertexShader("default");
+			floorMesh.SetPixelShader("default");
+
+			this->meshes_.push_back(floorMesh);
+		}
+
+		// Scatter lights over the terrain
+		std::mt19937 random(1337);
+		std::uniform_real_distribution<F32> unit(0.0f, 1.0f);
+		auto& lights = this->lighting_->GetLights();
+		for (U32 i = 0; i < 256; ++i)
+		{
+			PointLight light;
+			light.position = Vec3(unit(random) * 1361.0f, 20.0f + unit(random) * 120.0f, unit(random) * 733.0f);
+			light.radius = 30.0f + unit(random) * 50.0f;
+			light.colour = Vec3(unit(random), unit(random), unit(random));
+			light.intensity = 1.5f;
+			lights.push_back(light);
+		}
+	}
+
+	void Engine::AddCommands()
+	{
+		this->textureBuilder_ = std::make_unique<TextureBuilder>("data/texturecache");
+
+		Console::Get()->AddCommand("occlusion.enabled", [&](bool enabled) {
+			this->occlusionEnabled_ = enabled;
+		});
+
+		Console::Get()->AddCommand("stereo.enabled", [&](bool enabled) {
+			this->camera_->SetStereo(enabled);
+		});
+
+		Console::Get()->AddCommand("stereo.separation", [&](F32 separation) {
+			this->camera_->SetEyeSeparation(separation);
+		});
+
+		Console::Get()->AddCommand("occlusion.stats", [&]() {
+			auto& stats = this->occlusionCuller_->GetStats();
+			LogInfo("Occlusion: %u/%u occluder triangles rasterised, %u/%u meshes occluded",
+				stats.rasterisedTriangles, stats.occluderTriangles, stats.occluded, stats.tested);
+		});
+
+		// texture.build("data/image.png", "bc1")
+		Console::Get()->AddCommand("texture.build", [&](std::string path, std::string formatName)
+		{
+			static const std::pair<RawStringPtr, TextureFormat> Formats[] = {
+				{ "r8", TextureFormat::R8 }, { "rg8", TextureFormat::RG8 },
+				{ "rgba8", TextureFormat::RGBA8 }, { "bc1", TextureFormat::BC1 },
+				{ "bc3", TextureFormat::BC3 }, { "bc4", TextureFormat::BC4 },
+				{ "bc5", TextureFormat::BC5 }
+			};
+
+			TextureBuildOptions options;
+			auto found = false;
+			for (auto& format : Formats)
+			{
+				if (formatName == format.first)
+				{
+					options.format = format.second;
+					found = true;
+				}
+			}
+
+			if (!found)
+			{
+				LogError("Unknown texture format %s; expected r8, rg8, rgba8, bc1, bc3, bc4 or bc5", 
+					formatName.c_str());
+				return;
+			}
+
+			auto file = FileSystem::Get()->Open(path, FileSystem::Mode::ReadBinary);
+			if (!file.Exists())
+			{
+				LogError("Failed to open texture %s", path.c_str());
+				return;
+			}
+
+			auto encoded = file.Read<U8>();
+
+			util::Timer timer;
+			TextureData texture;
+			if (!this->textureBuilder_->Build(encoded, options, texture))
+			{
+				LogError("Failed to decode texture %s", path.c_str());
+				return;
+			}
+
+			LogInfo("Built %s: %ux%u, %u levels, %u bytes (%.2f bits per texel) in %.2f ms", 
+				path.c_str(), texture.width, texture.height, U32(texture.levels.size()), 
+				U32(texture.data.size()), F32(texture.data.size() * 8) / F32(texture.width * texture.height), 
+				timer.GetMilliseconds());
+		});
 	}
 
 	void Engine::DestroyDepthStencil()
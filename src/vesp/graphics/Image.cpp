@@ -10,15 +10,21 @@ namespace vesp { namespace graphics {
 		auto file = FileSystem::Get()->Open(path, FileSystem::Mode::ReadBinary);
 		auto imageData = file.Read<U8>();
 
+		auto image = FromMemory(imageData);
+		VESP_ASSERT(image.data);
+
+		return image;
+	}
+
+	Image Image::FromMemory(ArrayView<U8> encoded)
+	{
 		S32 sizeX = 0, sizeY = 0, comp = 0;
 
 		Image image;
-		image.data.reset(stbi_load_from_memory(imageData.data(), imageData.size(), &sizeX, &sizeY, &comp, 1));
+		image.data.reset(stbi_load_from_memory(encoded.data(), encoded.size(), &sizeX, &sizeY, &comp, 1));
 		image.sizeX = sizeX;
 		image.sizeY = sizeY;
 		image.components = comp;
-		
-		VESP_ASSERT(image.data);
 
 		return image;
 	}
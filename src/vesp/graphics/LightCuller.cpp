@@ -0,0 +1,231 @@
+#include "vesp/graphics/LightCuller.hpp"
+
+#include "vesp/math/Util.hpp"
+
+#include "vesp/Assert.hpp"
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace vesp { namespace graphics {
+
+	static_assert(LightCuller::TilesX % 4 == 0, "Rows are tested four clusters at a time");
+
+	LightCuller::LightCuller()
+	{
+		for (auto bounds : { &this->boundsMinX_, &this->boundsMinY_, &this->boundsMinZ_,
+			&this->boundsMaxX_, &this->boundsMaxY_, &this->boundsMaxZ_ })
+		{
+			bounds->resize(ClusterCount);
+		}
+
+		this->clusters_.resize(ClusterCount);
+	}
+
+	void LightCuller::SetProjection(F32 fovY, F32 aspectRatio, F32 nearPlane, F32 farPlane)
+	{
+		VESP_ASSERT(farPlane > nearPlane && nearPlane > 0.0f);
+
+		this->tanHalfFovY_ = std::tan(fovY / 2.0f);
+		this->tanHalfFovX_ = this->tanHalfFovY_ * aspectRatio;
+		this->nearPlane_ = nearPlane;
+		this->farPlane_ = farPlane;
+
+		auto logRange = std::log(farPlane / nearPlane);
+		this->sliceScale_ = Slices / logRange;
+		this->sliceBias_ = -(Slices * std::log(nearPlane)) / logRange;
+
+		for (U32 slice = 0; slice < Slices; ++slice)
+		{
+			auto z0 = this->GetSliceDepth(slice);
+			auto z1 = this->GetSliceDepth(slice + 1);
+
+			for (U32 y = 0; y < TilesY; ++y)
+			{
+				auto top = 1.0f - 2.0f * y / TilesY;
+				auto bottom = 1.0f - 2.0f * (y + 1) / TilesY;
+
+				for (U32 x = 0; x < TilesX; ++x)
+				{
+					auto left = -1.0f + 2.0f * x / TilesX;
+					auto right = -1.0f + 2.0f * (x + 1) / TilesX;
+
+					// The froxel widens with depth, so its box spans the near
+					// face on one side and the far face on the other
+					auto index = (slice * TilesY + y) * TilesX + x;
+					this->boundsMinX_[index] = std::min(left * z0, left * z1) * this->tanHalfFovX_;
+					this->boundsMaxX_[index] = std::max(right * z0, right * z1) * this->tanHalfFovX_;
+					this->boundsMinY_[index] = std::min(bottom * z0, bottom * z1) * this->tanHalfFovY_;
+					this->boundsMaxY_[index] = std::max(top * z0, top * z1) * this->tanHalfFovY_;
+					this->boundsMinZ_[index] = z0;
+					this->boundsMaxZ_[index] = z1;
+				}
+			}
+		}
+	}
+
+	void LightCuller::Assign(ArrayView<PointLight> lights, Mat4 const& view)
+	{
+		VESP_ASSERT(lights.size() <= 0xFFFF);
+		VESP_ASSERT(this->farPlane_ > 0.0f);
+
+		this->viewLights_.clear();
+		this->hits_.clear();
+		for (auto& cluster : this->clusters_)
+			cluster.count = 0;
+
+		for (auto& light : lights)
+		{
+			auto position = Vec3(view * Vec4(light.position, 1.0f));
+			auto radius = light.radius;
+
+			auto z0 = std::max(position.z - radius, this->nearPlane_);
+			auto z1 = std::min(position.z + radius, this->farPlane_);
+			if (z0 > z1)
+				continue;
+
+			// The sphere's view space box is conservative; its corners bound
+			// the range of tiles it can project to
+			F32 minX = FLT_MAX, maxX = -FLT_MAX;
+			F32 minY = FLT_MAX, maxY = -FLT_MAX;
+			for (auto z : { z0, z1 })
+			{
+				for (auto sign : { -1.0f, 1.0f })
+				{
+					auto x = (position.x + sign * radius) / (z * this->tanHalfFovX_);
+					auto y = (position.y + sign * radius) / (z * this->tanHalfFovY_);
+
+					minX = std::min(minX, x);
+					maxX = std::max(maxX, x);
+					minY = std::min(minY, y);
+					maxY = std::max(maxY, y);
+				}
+			}
+
+			if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+				continue;
+
+			auto toTile = [](F32 value, U32 count)
+			{
+				return math::Clamp(S32(std::floor(value * count)), 0, S32(count - 1));
+			};
+
+			auto tileX0 = toTile((minX + 1.0f) * 0.5f, TilesX);
+			auto tileX1 = toTile((maxX + 1.0f) * 0.5f, TilesX);
+			auto tileY0 = toTile((1.0f - maxY) * 0.5f, TilesY);
+			auto tileY1 = toTile((1.0f - minY) * 0.5f, TilesY);
+
+			auto toSlice = [&](F32 z)
+			{
+				return math::Clamp(S32(std::floor(std::log(z) * this->sliceScale_ + this->sliceBias_)), 
+					0, S32(Slices - 1));
+			};
+
+			auto slice0 = toSlice(z0);
+			auto slice1 = toSlice(z1);
+
+			auto lightIndex = U32(this->viewLights_.size());
+			auto viewLight = light;
+			viewLight.position = position;
+			this->viewLights_.push_back(viewLight);
+
+			Vec4 sphere(position, radius * radius);
+			for (auto slice = slice0; slice <= slice1; ++slice)
+			{
+				for (auto y = tileY0; y <= tileY1; ++y)
+					this->TestRow(U32(slice) * TilesY + y, U32(tileX0), U32(tileX1), sphere, lightIndex);
+			}
+		}
+
+		// Turn the counts into offsets, then scatter the hits. Hits are in
+		// light order, so each cluster's run is too.
+		U32 offset = 0;
+		for (auto& cluster : this->clusters_)
+		{
+			cluster.offset = offset;
+			offset += cluster.count;
+			cluster.count = 0;
+		}
+
+		this->lightIndices_.resize(offset);
+		for (auto hit : this->hits_)
+		{
+			auto& cluster = this->clusters_[hit >> 16];
+			this->lightIndices_[cluster.offset + cluster.count++] = hit & 0xFFFF;
+		}
+	}
+
+	ArrayView<PointLight> LightCuller::GetViewLights()
+	{
+		return this->viewLights_;
+	}
+
+	ArrayView<LightCuller::Cluster> LightCuller::GetClusters()
+	{
+		return this->clusters_;
+	}
+
+	ArrayView<U32> LightCuller::GetLightIndices()
+	{
+		return this->lightIndices_;
+	}
+
+	F32 LightCuller::GetSliceScale() const
+	{
+		return this->sliceScale_;
+	}
+
+	F32 LightCuller::GetSliceBias() const
+	{
+		return this->sliceBias_;
+	}
+
+	F32 LightCuller::GetSliceDepth(U32 slice) const
+	{
+		return this->nearPlane_ * 
+			std::pow(this->farPlane_ / this->nearPlane_, F32(slice) / Slices);
+	}
+
+	void LightCuller::TestRow(U32 row, U32 firstTile, U32 lastTile, Vec4 const& sphere, U32 lightIndex)
+	{
+		auto const centreX = _mm_set1_ps(sphere.x);
+		auto const centreY = _mm_set1_ps(sphere.y);
+		auto const centreZ = _mm_set1_ps(sphere.z);
+		auto const radiusSquared = _mm_set1_ps(sphere.w);
+		auto const zero = _mm_setzero_ps();
+
+		auto distance = [&](Vector<F32> const& minimum, Vector<F32> const& maximum, 
+			U32 index, __m128 centre)
+		{
+			auto below = _mm_sub_ps(_mm_loadu_ps(&minimum[index]), centre);
+			auto above = _mm_sub_ps(centre, _mm_loadu_ps(&maximum[index]));
+			return _mm_max_ps(_mm_max_ps(below, above), zero);
+		};
+
+		for (auto x = firstTile & ~3u; x <= lastTile; x += 4)
+		{
+			auto index = row * TilesX + x;
+
+			// Squared distance from the sphere centre to each box
+			auto dx = distance(this->boundsMinX_, this->boundsMaxX_, index, centreX);
+			auto dy = distance(this->boundsMinY_, this->boundsMaxY_, index, centreY);
+			auto dz = distance(this->boundsMinZ_, this->boundsMaxZ_, index, centreZ);
+			auto distanceSquared = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+			auto mask = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, radiusSquared));
+			for (U32 lane = 0; lane < 4; ++lane)
+			{
+				if (mask & (1 << lane))
+				{
+					++this->clusters_[index + lane].count;
+					this->hits_.push_back(((index + lane) << 16) | lightIndex);
+				}
+			}
+		}
+	}
+
+} }
\ No newline at end of file
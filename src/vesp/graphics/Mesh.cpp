@@ -4,11 +4,23 @@
 #include "vesp/graphics/Camera.hpp"
 #include "vesp/graphics/Shader.hpp"
 #include "vesp/graphics/ShaderManager.hpp"
+#include "vesp/graphics/MeshOptimiser.hpp"
 
 #include "vesp/Assert.hpp"
+#include "vesp/Metrics.hpp"
+
+#include <glm/common.hpp>
+
+#include <cfloat>
 
 namespace vesp { namespace graphics {
 
+	namespace
+	{
+		Counter DrawCalls("draw_calls", "Draw calls submitted");
+		Counter SubmittedVertices("vertices_submitted", "Vertices submitted across all instances of each draw");
+	}
+
 	Mesh::Mesh()
 	{
 		this->scale_ = Vec3(1, 1, 1);
@@ -26,11 +38,31 @@ namespace vesp { namespace graphics {
 		return this->exists_;
 	}
 
+	bool Mesh::Create(ArrayView<Vertex> vertices, ArrayView<U16> indices, D3D11_PRIMITIVE_TOPOLOGY topology)
+	{
+		auto ret = this->Create(vertices, topology);
+		if (!ret)
+			return this->exists_;
+
+		if (!this->indexBuffer_.Create(indices))
+			this->exists_ = false;
+
+		return this->exists_;
+	}
+
 	bool Mesh::Create(ArrayView<Vertex> vertices, D3D11_PRIMITIVE_TOPOLOGY topology)
 	{
 		if (!this->vertexBuffer_.Create(vertices))
 			return this->exists_;
 
+		this->boundsMin_ = Vec3(FLT_MAX);
+		this->boundsMax_ = Vec3(-FLT_MAX);
+		for (auto& vertex : vertices)
+		{
+			this->boundsMin_ = glm::min(this->boundsMin_, vertex.position);
+			this->boundsMax_ = glm::max(this->boundsMax_, vertex.position);
+		}
+
 		PerMeshConstants constants;
 
 		if (!this->perMeshConstantBuffer_.Create(constants))
@@ -42,6 +74,24 @@ namespace vesp { namespace graphics {
 		return this->exists_;
 	}
 
+	bool Mesh::CreateOptimised(ArrayView<Vertex> vertices, MeshOptimiserStats* stats)
+	{
+		return this->CreateOptimised(vertices, ArrayView<U32>(), stats);
+	}
+
+	bool Mesh::CreateOptimised(ArrayView<Vertex> vertices, ArrayView<U32> indices, MeshOptimiserStats* stats)
+	{
+		auto optimised = OptimiseMesh(vertices, indices);
+
+		if (stats)
+			*stats = optimised.stats;
+
+		if (optimised.Uses16BitIndices())
+			return this->Create(optimised.vertices, optimised.indices16);
+		else
+			return this->Create(optimised.vertices, optimised.indices32);
+	}
+
 	Vec3 Mesh::GetPosition()
 	{
 		return this->position_;
@@ -68,6 +118,21 @@ namespace vesp { namespace graphics {
 		this->angle_ = angle;
 	}
 
+	Mat4 Mesh::GetWorld()
+	{
+		return math::Transform(this->position_, this->angle_, this->scale_);
+	}
+
+	Vec3 const& Mesh::GetBoundsMin() const
+	{
+		return this->boundsMin_;
+	}
+
+	Vec3 const& Mesh::GetBoundsMax() const
+	{
+		return this->boundsMax_;
+	}
+
 	Colour Mesh::GetColour()
 	{
 		return this->colour_;
@@ -113,6 +178,11 @@ namespace vesp { namespace graphics {
 		this->pixelShader_ = shaderId.CopyToVector();
 	}
 
+	void Mesh::SetStereoInstancing(bool enabled)
+	{
+		this->stereoInstancing_ = enabled;
+	}
+
 	bool Mesh::Exists() const
 	{
 		return this->exists_;
@@ -124,8 +194,13 @@ namespace vesp { namespace graphics {
 		VESP_ASSERT(this->vertexShader_.size() != 0);
 		VESP_ASSERT(this->pixelShader_.size() != 0);
 
-		ShaderManager::Get()->GetVertexShader(this->vertexShader_)->Activate();
-		ShaderManager::Get()->GetPixelShader(this->pixelShader_)->Activate();
+		auto vertexShader = ShaderManager::Get()->GetVertexShader(this->vertexShader_);
+		auto pixelShader = ShaderManager::Get()->GetPixelShader(this->pixelShader_);
+		if (!vertexShader || !pixelShader)
+			return;
+
+		vertexShader->Activate();
+		pixelShader->Activate();
 
 		this->UpdateMatrix();
 		this->vertexBuffer_.Use(0);
@@ -133,16 +208,26 @@ namespace vesp { namespace graphics {
 		this->perMeshConstantBuffer_.UseVS(1);
 		Engine::ImmediateContext->IASetPrimitiveTopology(this->topology_);
 
+		auto instanceCount = this->stereoInstancing_ ? 
+			Engine::Get()->GetCamera()->GetEyeCount() : 1;
+
+		auto vertexCount = this->indexBuffer_.Initialized() ?
+			this->indexBuffer_.GetCount() : this->vertexBuffer_.GetCount();
+
 		if (this->indexBuffer_.Initialized())
 		{
 			this->indexBuffer_.Use();
-			Engine::ImmediateContext->DrawIndexed(
-				this->indexBuffer_.GetCount(), 0, 0);
+			Engine::ImmediateContext->DrawIndexedInstanced(
+				vertexCount, instanceCount, 0, 0, 0);
 		}
 		else
 		{
-			Engine::ImmediateContext->Draw(this->vertexBuffer_.GetCount(), 0);
+			Engine::ImmediateContext->DrawInstanced(
+				vertexCount, instanceCount, 0, 0);
 		}
+
+		DrawCalls.Add();
+		SubmittedVertices.Add(U64(vertexCount) * instanceCount);
 	}
 
 	void Mesh::UpdateMatrix()
@@ -152,7 +237,7 @@ namespace vesp { namespace graphics {
 		PerMeshConstants constants;
 		constants.world = this->world_;
 		constants.worldView = 
-			this->world_ * Engine::Get()->GetCamera()->GetView();
+			Engine::Get()->GetCamera()->GetView() * this->world_;
 		constants.worldViewInverseTranspose = 
 			glm::transpose(glm::inverse(constants.worldView));
 		constants.colour = this->colour_;
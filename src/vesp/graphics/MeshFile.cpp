@@ -0,0 +1,242 @@
+#include "vesp/graphics/MeshFile.hpp"
+#include "vesp/graphics/MeshOptimiser.hpp"
+#include "vesp/graphics/Mesh.hpp"
+
+#include "vesp/Assert.hpp"
+#include "vesp/Log.hpp"
+
+#include <glm/common.hpp>
+
+#include <limits>
+
+namespace vesp { namespace graphics {
+
+	namespace
+	{
+		U32 AlignOffset(U32 offset)
+		{
+			return (offset + MeshFileAlignment - 1) & ~(MeshFileAlignment - 1);
+		}
+	}
+
+	MeshFile::MeshFile()
+	{
+	}
+
+	template <typename T>
+	ArrayView<T> MeshFile::GetSection(U32 offset, U32 count)
+	{
+		VESP_ASSERT(this->IsLoaded());
+
+		if (count == 0)
+			return ArrayView<T>();
+
+		auto data = this->file_.GetData();
+		return ArrayView<T>(reinterpret_cast<T*>(data.data() + offset), count);
+	}
+
+	bool MeshFile::Load(StringView path)
+	{
+		this->header_ = nullptr;
+		this->file_ = FileSystem::Get()->Map(path);
+
+		if (!this->file_.Exists())
+		{
+			LogError("Failed to map mesh %.*s", path.size(), path.data());
+			return false;
+		}
+
+		auto data = this->file_.GetData();
+		if (data.size() < sizeof(MeshFileHeader))
+		{
+			LogError("Mesh %.*s is too small to be a mesh file", path.size(), path.data());
+			return false;
+		}
+
+		auto header = reinterpret_cast<MeshFileHeader const*>(data.data());
+		if (header->magic != MeshFileHeader::Magic)
+		{
+			LogError("Mesh %.*s is not a mesh file", path.size(), path.data());
+			return false;
+		}
+
+		if (header->version != MeshFileHeader::CurrentVersion)
+		{
+			LogError("Mesh %.*s has unsupported version %u (expected %u)", 
+				path.size(), path.data(), header->version, MeshFileHeader::CurrentVersion);
+			return false;
+		}
+
+		if (header->indexSize != 0 && header->indexSize != sizeof(U16) && header->indexSize != sizeof(U32))
+		{
+			LogError("Mesh %.*s has invalid index size %u", 
+				path.size(), path.data(), header->indexSize);
+			return false;
+		}
+
+		auto sectionValid = [&](U32 offset, U32 count, U32 elementSize)
+		{
+			if (count == 0)
+				return true;
+
+			auto end = U64(offset) + U64(count) * elementSize;
+			return offset % MeshFileAlignment == 0 && end <= data.size();
+		};
+
+		if (!sectionValid(header->vertexOffset, header->vertexCount, sizeof(Vertex)) ||
+			!sectionValid(header->indexOffset, header->indexCount, header->indexSize) ||
+			!sectionValid(header->lodOffset, header->lodCount, sizeof(MeshFileLod)))
+		{
+			LogError("Mesh %.*s has out of bounds sections", path.size(), path.data());
+			return false;
+		}
+
+		this->header_ = header;
+
+		for (auto& lod : this->GetLods())
+		{
+			if (U64(lod.firstIndex) + lod.indexCount > header->indexCount)
+			{
+				LogError("Mesh %.*s has out of bounds LOD", path.size(), path.data());
+				this->header_ = nullptr;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool MeshFile::IsLoaded() const
+	{
+		return this->header_ != nullptr;
+	}
+
+	MeshFileHeader const& MeshFile::GetHeader() const
+	{
+		VESP_ASSERT(this->IsLoaded());
+		return *this->header_;
+	}
+
+	ArrayView<Vertex> MeshFile::GetVertices()
+	{
+		return this->GetSection<Vertex>(
+			this->header_->vertexOffset, this->header_->vertexCount);
+	}
+
+	ArrayView<U16> MeshFile::GetIndices16()
+	{
+		VESP_ASSERT(this->header_->indexSize == sizeof(U16));
+		return this->GetSection<U16>(
+			this->header_->indexOffset, this->header_->indexCount);
+	}
+
+	ArrayView<U32> MeshFile::GetIndices32()
+	{
+		VESP_ASSERT(this->header_->indexSize == sizeof(U32));
+		return this->GetSection<U32>(
+			this->header_->indexOffset, this->header_->indexCount);
+	}
+
+	ArrayView<MeshFileLod> MeshFile::GetLods()
+	{
+		return this->GetSection<MeshFileLod>(
+			this->header_->lodOffset, this->header_->lodCount);
+	}
+
+	bool MeshFile::CreateMesh(Mesh& mesh, U32 lod)
+	{
+		VESP_ASSERT(this->IsLoaded());
+
+		auto vertices = this->GetVertices();
+		if (this->header_->indexSize == 0)
+			return mesh.Create(vertices);
+
+		U32 firstIndex = 0;
+		U32 indexCount = this->header_->indexCount;
+
+		auto lods = this->GetLods();
+		if (lods.size())
+		{
+			VESP_ASSERT(lod < lods.size());
+			firstIndex = lods[lod].firstIndex;
+			indexCount = lods[lod].indexCount;
+		}
+
+		if (this->header_->indexSize == sizeof(U16))
+		{
+			auto indices = this->GetIndices16();
+			return mesh.Create(vertices, ArrayView<U16>(indices.data() + firstIndex, indexCount));
+		}
+		else
+		{
+			auto indices = this->GetIndices32();
+			return mesh.Create(vertices, ArrayView<U32>(indices.data() + firstIndex, indexCount));
+		}
+	}
+
+	bool MeshFile::Write(StringView path, OptimisedMesh const& mesh, ArrayView<MeshFileLod> lods)
+	{
+		auto const indexSize = mesh.Uses16BitIndices() ? sizeof(U16) : sizeof(U32);
+		auto const indexCount = mesh.Uses16BitIndices() ? mesh.indices16.size() : mesh.indices32.size();
+		void const* indexData = mesh.Uses16BitIndices() ? 
+			static_cast<void const*>(mesh.indices16.data()) : 
+			static_cast<void const*>(mesh.indices32.data());
+
+		MeshFileHeader header;
+		header.magic = MeshFileHeader::Magic;
+		header.version = MeshFileHeader::CurrentVersion;
+		header.indexSize = U16(indexSize);
+
+		header.vertexOffset = AlignOffset(sizeof(MeshFileHeader));
+		header.vertexCount = mesh.vertices.size();
+		header.indexOffset = AlignOffset(header.vertexOffset + header.vertexCount * sizeof(Vertex));
+		header.indexCount = indexCount;
+		header.lodOffset = AlignOffset(header.indexOffset + header.indexCount * indexSize);
+		header.lodCount = lods.size();
+
+		auto const max = std::numeric_limits<F32>::max();
+		header.boundsMin = Vec3(max, max, max);
+		header.boundsMax = Vec3(-max, -max, -max);
+		for (auto& vertex : mesh.vertices)
+		{
+			header.boundsMin = glm::min(header.boundsMin, vertex.position);
+			header.boundsMax = glm::max(header.boundsMax, vertex.position);
+		}
+
+		auto file = FileSystem::Get()->Open(path, 
+			FileSystem::Mode::Enum(FileSystem::Mode::Write | FileSystem::Mode::Binary));
+		if (!file.Exists())
+		{
+			LogError("Failed to open %.*s for writing", path.size(), path.data());
+			return false;
+		}
+
+		U32 position = 0;
+		auto write = [&](void const* data, size_t size)
+		{
+			file.Write(ArrayView<U8>(const_cast<U8*>(static_cast<U8 const*>(data)), size));
+			position += size;
+		};
+
+		auto padTo = [&](U32 offset)
+		{
+			static const U8 Padding[MeshFileAlignment] = {};
+			VESP_ASSERT(offset >= position && offset - position < MeshFileAlignment);
+			write(Padding, offset - position);
+		};
+
+		write(&header, sizeof(header));
+
+		padTo(header.vertexOffset);
+		write(mesh.vertices.data(), header.vertexCount * sizeof(Vertex));
+
+		padTo(header.indexOffset);
+		write(indexData, header.indexCount * indexSize);
+
+		padTo(header.lodOffset);
+		write(lods.data(), header.lodCount * sizeof(MeshFileLod));
+
+		return true;
+	}
+
+} }
\ No newline at end of file
@@ -0,0 +1,370 @@
+#include "vesp/graphics/MeshOptimiser.hpp"
+
+#include "vesp/util/MurmurHash.hpp"
+
+#include "vesp/Assert.hpp"
+#include "vesp/String.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace vesp { namespace graphics {
+
+	namespace
+	{
+		const U32 InvalidIndex = std::numeric_limits<U32>::max();
+
+		// Scoring parameters from Forsyth's "Linear-Speed Vertex Cache Optimisation"
+		const U32 ForsythCacheSize = 32;
+		const U32 ForsythMaxValence = 32;
+		const F32 ForsythCacheDecayPower = 1.5f;
+		const F32 ForsythLastTriangleScore = 0.75f;
+		const F32 ForsythValenceBoostScale = 2.0f;
+		const F32 ForsythValenceBoostPower = 0.5f;
+
+		struct ForsythScoreTable
+		{
+			ForsythScoreTable()
+			{
+				for (U32 i = 0; i < ForsythCacheSize; ++i)
+				{
+					if (i < 3)
+					{
+						cache[i] = ForsythLastTriangleScore;
+					}
+					else
+					{
+						auto scaler = 1.0f / (ForsythCacheSize - 3);
+						cache[i] = std::pow(1.0f - (i - 3) * scaler, ForsythCacheDecayPower);
+					}
+				}
+
+				valence[0] = 0.0f;
+				for (U32 i = 1; i < ForsythMaxValence; ++i)
+					valence[i] = ForsythValenceBoostScale * std::pow(F32(i), -ForsythValenceBoostPower);
+			}
+
+			F32 Score(S32 cachePosition, U32 activeTriangles) const
+			{
+				// No triangles left to emit, so the vertex is useless
+				if (activeTriangles == 0)
+					return -1.0f;
+
+				auto score = cachePosition < 0 ? 0.0f : this->cache[cachePosition];
+
+				if (activeTriangles < ForsythMaxValence)
+					score += this->valence[activeTriangles];
+				else
+					score += ForsythValenceBoostScale * std::pow(F32(activeTriangles), -ForsythValenceBoostPower);
+
+				return score;
+			}
+
+			F32 cache[ForsythCacheSize];
+			F32 valence[ForsythMaxValence];
+		};
+
+		U32 NextPowerOfTwo(U32 value)
+		{
+			U32 result = 1;
+			while (result < value)
+				result <<= 1;
+			return result;
+		}
+	}
+
+	bool OptimisedMesh::Uses16BitIndices() const
+	{
+		return this->indices32.empty();
+	}
+
+	OptimisedMesh OptimiseMesh(ArrayView<Vertex> vertices)
+	{
+		return OptimiseMesh(vertices, ArrayView<U32>());
+	}
+
+	OptimisedMesh OptimiseMesh(ArrayView<Vertex> vertices, ArrayView<U32> indices)
+	{
+		OptimisedMesh result;
+		auto& stats = result.stats;
+
+		bool const indexed = indices.size() > 0;
+		stats.vertexCountBefore = vertices.size();
+		stats.indexCountBefore = indices.size();
+		stats.bytesBefore = vertices.size() * sizeof(Vertex) + indices.size() * sizeof(U32);
+		// Unindexed geometry transforms every vertex of every triangle
+		stats.acmrBefore = indexed ? CalculateACMR(indices, vertices.size()) : 3.0f;
+
+		Vector<U32> weldedIndices;
+		WeldVertices(vertices, indices, result.vertices, weldedIndices);
+
+		auto optimisedIndices = OptimiseVertexCache(weldedIndices, result.vertices.size());
+		OptimiseVertexFetch(result.vertices, optimisedIndices);
+
+		stats.vertexCountAfter = result.vertices.size();
+		stats.indexCountAfter = optimisedIndices.size();
+		stats.acmrAfter = CalculateACMR(optimisedIndices, result.vertices.size());
+
+		U32 indexSize = 0;
+		if (result.vertices.size() <= std::numeric_limits<U16>::max())
+		{
+			result.indices16.assign(optimisedIndices.begin(), optimisedIndices.end());
+			indexSize = sizeof(U16);
+		}
+		else
+		{
+			result.indices32 = std::move(optimisedIndices);
+			indexSize = sizeof(U32);
+		}
+
+		stats.bytesAfter = 
+			stats.vertexCountAfter * sizeof(Vertex) + stats.indexCountAfter * indexSize;
+
+		return result;
+	}
+
+	void WeldVertices(ArrayView<Vertex> vertices, ArrayView<U32> indices,
+		Vector<Vertex>& outVertices, Vector<U32>& outIndices)
+	{
+		size_t const count = indices.size() ? indices.size() : vertices.size();
+
+		// Open-addressed table of indices into outVertices, at most half full
+		auto const tableSize = NextPowerOfTwo(U32(vertices.size() * 2));
+		auto const tableMask = tableSize - 1;
+		Vector<U32> table(tableSize, InvalidIndex);
+
+		// Source vertex -> welded vertex, so that shared vertices are only hashed once
+		Vector<U32> remap(vertices.size(), InvalidIndex);
+
+		outVertices.clear();
+		outVertices.reserve(vertices.size());
+		outIndices.resize(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto source = indices.size() ? indices[i] : U32(i);
+			VESP_ASSERT(source < vertices.size());
+
+			if (remap[source] == InvalidIndex)
+			{
+				auto& vertex = vertices[source];
+				auto hash = util::MurmurHash(
+					StringView(reinterpret_cast<StringByte*>(&vertex), sizeof(Vertex)));
+
+				auto slot = hash & tableMask;
+				while (table[slot] != InvalidIndex && 
+					std::memcmp(&outVertices[table[slot]], &vertex, sizeof(Vertex)) != 0)
+				{
+					slot = (slot + 1) & tableMask;
+				}
+
+				if (table[slot] == InvalidIndex)
+				{
+					table[slot] = outVertices.size();
+					outVertices.push_back(vertex);
+				}
+
+				remap[source] = table[slot];
+			}
+
+			outIndices[i] = remap[source];
+		}
+	}
+
+	Vector<U32> OptimiseVertexCache(ArrayView<U32> indices, U32 vertexCount)
+	{
+		static const ForsythScoreTable scoreTable;
+
+		VESP_ASSERT(indices.size() % 3 == 0);
+		U32 const triangleCount = indices.size() / 3;
+
+		Vector<U32> result;
+		result.reserve(indices.size());
+
+		if (triangleCount == 0)
+			return result;
+
+		// Build vertex -> triangle adjacency; the first activeTriangles[v]
+		// entries of each vertex's range are the triangles yet to be emitted
+		Vector<U32> activeTriangles(vertexCount, 0);
+		for (size_t i = 0; i < indices.size(); ++i)
+			activeTriangles[indices[i]]++;
+
+		Vector<U32> adjacencyOffsets(vertexCount + 1, 0);
+		for (U32 v = 0; v < vertexCount; ++v)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + activeTriangles[v];
+
+		Vector<U32> adjacency(indices.size());
+		{
+			Vector<U32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (U32 t = 0; t < triangleCount; ++t)
+				for (U32 k = 0; k < 3; ++k)
+					adjacency[fill[indices[t * 3 + k]]++] = t;
+		}
+
+		Vector<S32> cachePositions(vertexCount, -1);
+		Vector<F32> vertexScores(vertexCount);
+		for (U32 v = 0; v < vertexCount; ++v)
+			vertexScores[v] = scoreTable.Score(-1, activeTriangles[v]);
+
+		Vector<F32> triangleScores(triangleCount);
+		Vector<U8> triangleEmitted(triangleCount, 0);
+		S32 bestTriangle = 0;
+		for (U32 t = 0; t < triangleCount; ++t)
+		{
+			triangleScores[t] = 
+				vertexScores[indices[t * 3 + 0]] +
+				vertexScores[indices[t * 3 + 1]] +
+				vertexScores[indices[t * 3 + 2]];
+
+			if (triangleScores[t] > triangleScores[bestTriangle])
+				bestTriangle = t;
+		}
+
+		U32 cache[ForsythCacheSize + 3];
+		U32 newCache[ForsythCacheSize + 3];
+		U32 cacheCount = 0;
+		U32 scanCursor = 0;
+
+		auto updateVertexScore = [&](U32 v)
+		{
+			auto score = scoreTable.Score(cachePositions[v], activeTriangles[v]);
+			auto delta = score - vertexScores[v];
+			vertexScores[v] = score;
+
+			auto begin = adjacency.data() + adjacencyOffsets[v];
+			for (U32 i = 0; i < activeTriangles[v]; ++i)
+				triangleScores[begin[i]] += delta;
+		};
+
+		for (U32 emitted = 0; emitted < triangleCount; ++emitted)
+		{
+			// If no cached vertex has an active triangle, fall back to the
+			// next unemitted triangle in input order
+			if (bestTriangle < 0)
+			{
+				while (triangleEmitted[scanCursor])
+					++scanCursor;
+				bestTriangle = scanCursor;
+			}
+
+			auto const triangle = &indices[bestTriangle * 3];
+			triangleEmitted[bestTriangle] = 1;
+
+			U32 newCacheCount = 0;
+			for (U32 k = 0; k < 3; ++k)
+			{
+				auto v = triangle[k];
+				result.push_back(v);
+
+				// Remove the triangle from the vertex's active list
+				auto begin = adjacency.data() + adjacencyOffsets[v];
+				auto end = begin + activeTriangles[v];
+				auto it = std::find(begin, end, U32(bestTriangle));
+				VESP_ASSERT(it != end);
+				std::swap(*it, *(end - 1));
+				activeTriangles[v]--;
+
+				// Degenerate triangles may reference the same vertex twice
+				if (std::find(newCache, newCache + newCacheCount, v) == newCache + newCacheCount)
+					newCache[newCacheCount++] = v;
+			}
+
+			// Emitted vertices move to the front of the cache; everything else shifts back
+			for (U32 i = 0; i < cacheCount; ++i)
+			{
+				auto v = cache[i];
+				if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+					newCache[newCacheCount++] = v;
+			}
+
+			// Vertices pushed out of the cache lose their cache score
+			for (U32 i = ForsythCacheSize; i < newCacheCount; ++i)
+			{
+				cachePositions[newCache[i]] = -1;
+				updateVertexScore(newCache[i]);
+			}
+
+			cacheCount = std::min(newCacheCount, ForsythCacheSize);
+			std::copy(newCache, newCache + cacheCount, cache);
+
+			for (U32 i = 0; i < cacheCount; ++i)
+			{
+				cachePositions[cache[i]] = i;
+				updateVertexScore(cache[i]);
+			}
+
+			// Only triangles touching the cache can have changed, so the best
+			// candidate must be among them
+			bestTriangle = -1;
+			F32 bestScore = -std::numeric_limits<F32>::max();
+			for (U32 i = 0; i < cacheCount; ++i)
+			{
+				auto v = cache[i];
+				auto begin = adjacency.data() + adjacencyOffsets[v];
+				for (U32 j = 0; j < activeTriangles[v]; ++j)
+				{
+					auto t = begin[j];
+					if (triangleScores[t] > bestScore)
+					{
+						bestScore = triangleScores[t];
+						bestTriangle = t;
+					}
+				}
+			}
+		}
+
+		return result;
+	}
+
+	void OptimiseVertexFetch(Vector<Vertex>& vertices, ArrayView<U32> indices)
+	{
+		Vector<U32> remap(vertices.size(), InvalidIndex);
+		U32 nextVertex = 0;
+
+		for (auto& index : indices)
+		{
+			if (remap[index] == InvalidIndex)
+				remap[index] = nextVertex++;
+
+			index = remap[index];
+		}
+
+		Vector<Vertex> reordered(nextVertex);
+		for (size_t v = 0; v < vertices.size(); ++v)
+		{
+			if (remap[v] != InvalidIndex)
+				reordered[remap[v]] = vertices[v];
+		}
+
+		vertices.swap(reordered);
+	}
+
+	F32 CalculateACMR(ArrayView<U32> indices, U32 vertexCount, U32 cacheSize)
+	{
+		VESP_ASSERT(indices.size() % 3 == 0);
+		if (indices.size() == 0)
+			return 0.0f;
+
+		// FIFO cache simulation: a vertex is resident if fewer than cacheSize
+		// misses have happened since it was last loaded
+		Vector<U32> timestamps(vertexCount, 0);
+		U32 timestamp = cacheSize + 1;
+		U32 misses = 0;
+
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			auto index = indices[i];
+			if (timestamp - timestamps[index] > cacheSize)
+			{
+				timestamps[index] = timestamp++;
+				misses++;
+			}
+		}
+
+		return F32(misses) / F32(indices.size() / 3);
+	}
+
+} }
\ No newline at end of file
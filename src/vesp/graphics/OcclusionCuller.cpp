@@ -0,0 +1,320 @@
+#include "vesp/graphics/OcclusionCuller.hpp"
+
+#include "vesp/Assert.hpp"
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace vesp { namespace graphics {
+
+	namespace
+	{
+		bool AllOutside(Vec4 const& a, Vec4 const& b, Vec4 const& c)
+		{
+			return 
+				(a.x > a.w && b.x > b.w && c.x > c.w) ||
+				(a.x < -a.w && b.x < -b.w && c.x < -c.w) ||
+				(a.y > a.w && b.y > b.w && c.y > c.w) ||
+				(a.y < -a.w && b.y < -b.w && c.y < -c.w) ||
+				(a.z < 0.0f && b.z < 0.0f && c.z < 0.0f);
+		}
+	}
+
+	OcclusionCuller::OcclusionCuller(U32 width, U32 height)
+	{
+		this->tilesX_ = std::max(1u, (width + TileWidth - 1) / TileWidth);
+		this->tilesY_ = std::max(1u, (height + TileHeight - 1) / TileHeight);
+		this->width_ = this->tilesX_ * TileWidth;
+		this->height_ = this->tilesY_ * TileHeight;
+
+		this->depth_.resize(this->width_ * this->height_, FLT_MAX);
+		this->tileDepth_.resize(this->tilesX_ * this->tilesY_, FLT_MAX);
+	}
+
+	void OcclusionCuller::Begin(Mat4 const& viewProjection)
+	{
+		this->viewProjection_ = viewProjection;
+		std::fill(this->depth_.begin(), this->depth_.end(), FLT_MAX);
+		std::fill(this->tileDepth_.begin(), this->tileDepth_.end(), FLT_MAX);
+
+		this->stats_ = OcclusionStats();
+	}
+
+	void OcclusionCuller::AddOccluder(ArrayView<Vec3> positions, ArrayView<U32> indices, Mat4 const& world)
+	{
+		VESP_ASSERT(indices.size() % 3 == 0);
+
+		auto transform = this->viewProjection_ * world;
+
+		auto& clip = this->clipVertices_;
+		clip.resize(positions.size());
+		for (size_t i = 0; i < positions.size(); ++i)
+			clip[i] = transform * Vec4(positions[i], 1.0f);
+
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			Vec4 const triangle[] = { clip[indices[i]], clip[indices[i + 1]], clip[indices[i + 2]] };
+			++this->stats_.occluderTriangles;
+
+			if (AllOutside(triangle[0], triangle[1], triangle[2]))
+				continue;
+
+			this->RasteriseClipped(triangle);
+		}
+	}
+
+	void OcclusionCuller::Finish()
+	{
+		for (U32 tileY = 0; tileY < this->tilesY_; ++tileY)
+		{
+			for (U32 tileX = 0; tileX < this->tilesX_; ++tileX)
+			{
+				auto maximum = _mm_setzero_ps();
+				for (U32 y = 0; y < TileHeight; ++y)
+				{
+					auto row = this->depth_.data() + 
+						(tileY * TileHeight + y) * this->width_ + tileX * TileWidth;
+
+					for (U32 x = 0; x < TileWidth; x += 4)
+						maximum = _mm_max_ps(maximum, _mm_loadu_ps(row + x));
+				}
+
+				maximum = _mm_max_ps(maximum, _mm_shuffle_ps(maximum, maximum, _MM_SHUFFLE(1, 0, 3, 2)));
+				maximum = _mm_max_ps(maximum, _mm_shuffle_ps(maximum, maximum, _MM_SHUFFLE(2, 3, 0, 1)));
+				this->tileDepth_[tileY * this->tilesX_ + tileX] = _mm_cvtss_f32(maximum);
+			}
+		}
+	}
+
+	bool OcclusionCuller::IsVisible(Vec3 const& boundsMin, Vec3 const& boundsMax, Mat4 const& world)
+	{
+		++this->stats_.tested;
+
+		auto transform = this->viewProjection_ * world;
+
+		Vec3 screenMin(FLT_MAX);
+		Vec3 screenMax(-FLT_MAX);
+		for (U32 i = 0; i < 8; ++i)
+		{
+			Vec3 corner(
+				(i & 1) ? boundsMax.x : boundsMin.x,
+				(i & 2) ? boundsMax.y : boundsMin.y,
+				(i & 4) ? boundsMax.z : boundsMin.z);
+
+			// Boxes crossing the near plane are always visible
+			auto clip = transform * Vec4(corner, 1.0f);
+			if (clip.z < 0.0f || clip.w <= 0.0f)
+				return true;
+
+			auto screen = this->ToScreen(clip);
+			screenMin = glm::min(screenMin, screen);
+			screenMax = glm::max(screenMax, screen);
+		}
+
+		if (screenMax.x < 0.0f || screenMax.y < 0.0f ||
+			screenMin.x >= F32(this->width_) || screenMin.y >= F32(this->height_))
+		{
+			++this->stats_.occluded;
+			return false;
+		}
+
+		auto x0 = S32(std::max(screenMin.x, 0.0f));
+		auto y0 = S32(std::max(screenMin.y, 0.0f));
+		auto x1 = std::min(S32(screenMax.x), S32(this->width_ - 1));
+		auto y1 = std::min(S32(screenMax.y), S32(this->height_ - 1));
+
+		auto const nearest = _mm_set1_ps(screenMin.z);
+		auto const columnMin = _mm_set1_ps(F32(x0));
+		auto const columnMax = _mm_set1_ps(F32(x1));
+		auto const lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+		for (S32 tileY = y0 / S32(TileHeight); tileY <= y1 / S32(TileHeight); ++tileY)
+		{
+			for (S32 tileX = x0 / S32(TileWidth); tileX <= x1 / S32(TileWidth); ++tileX)
+			{
+				// Everything in the tile is in front of the box
+				if (this->tileDepth_[tileY * this->tilesX_ + tileX] < screenMin.z)
+					continue;
+
+				auto rowStart = std::max(y0, tileY * S32(TileHeight));
+				auto rowEnd = std::min(y1, tileY * S32(TileHeight) + S32(TileHeight) - 1);
+
+				for (auto y = rowStart; y <= rowEnd; ++y)
+				{
+					auto row = this->depth_.data() + y * this->width_;
+					for (S32 x = tileX * S32(TileWidth); x < (tileX + 1) * S32(TileWidth); x += 4)
+					{
+						auto columns = _mm_add_ps(_mm_set1_ps(F32(x)), lanes);
+						auto inside = _mm_and_ps(
+							_mm_cmpge_ps(columns, columnMin), _mm_cmple_ps(columns, columnMax));
+
+						auto behind = _mm_cmpge_ps(_mm_loadu_ps(row + x), nearest);
+						if (_mm_movemask_ps(_mm_and_ps(inside, behind)))
+							return true;
+					}
+				}
+			}
+		}
+
+		++this->stats_.occluded;
+		return false;
+	}
+
+	U32 OcclusionCuller::GetWidth() const
+	{
+		return this->width_;
+	}
+
+	U32 OcclusionCuller::GetHeight() const
+	{
+		return this->height_;
+	}
+
+	ArrayView<F32> OcclusionCuller::GetDepth()
+	{
+		return this->depth_;
+	}
+
+	OcclusionStats const& OcclusionCuller::GetStats() const
+	{
+		return this->stats_;
+	}
+
+	void OcclusionCuller::RasteriseClipped(Vec4 const* vertices)
+	{
+		// Clip against the near plane, which can turn the triangle into a quad
+		Vec4 polygon[4];
+		U32 count = 0;
+
+		for (U32 i = 0; i < 3; ++i)
+		{
+			auto& a = vertices[i];
+			auto& b = vertices[(i + 1) % 3];
+
+			if (a.z >= 0.0f)
+				polygon[count++] = a;
+
+			if ((a.z >= 0.0f) != (b.z >= 0.0f))
+			{
+				auto t = a.z / (a.z - b.z);
+				polygon[count++] = a + (b - a) * t;
+			}
+		}
+
+		if (count < 3)
+			return;
+
+		Vec3 screen[4];
+		for (U32 i = 0; i < count; ++i)
+		{
+			if (polygon[i].w <= 0.0f)
+				return;
+
+			screen[i] = this->ToScreen(polygon[i]);
+		}
+
+		this->RasteriseTriangle(screen[0], screen[1], screen[2]);
+		if (count == 4)
+			this->RasteriseTriangle(screen[0], screen[2], screen[3]);
+	}
+
+	void OcclusionCuller::RasteriseTriangle(Vec3 v0, Vec3 v1, Vec3 v2)
+	{
+		auto area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+		if (std::abs(area) < 1e-6f)
+			return;
+
+		// Occluders are two-sided
+		if (area < 0.0f)
+		{
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		auto minX = std::max(std::floor(std::min(std::min(v0.x, v1.x), v2.x)), 0.0f);
+		auto minY = std::max(std::floor(std::min(std::min(v0.y, v1.y), v2.y)), 0.0f);
+		auto maxX = std::min(std::ceil(std::max(std::max(v0.x, v1.x), v2.x)), F32(this->width_ - 1));
+		auto maxY = std::min(std::ceil(std::max(std::max(v0.y, v1.y), v2.y)), F32(this->height_ - 1));
+		if (minX > maxX || minY > maxY)
+			return;
+
+		++this->stats_.rasterisedTriangles;
+
+		// Edge functions E(p) = a * p.x + b * p.y + c, positive inside.
+		// Coverage is sampled at pixel centres; requiring whole pixels would
+		// open cracks along the edges shared between triangles.
+		Vec3 const* edges[3][2] = { { &v0, &v1 }, { &v1, &v2 }, { &v2, &v0 } };
+		__m128 edgeA[3], edgeB[3], edgeC[3];
+		for (U32 i = 0; i < 3; ++i)
+		{
+			auto& from = *edges[i][0];
+			auto& to = *edges[i][1];
+
+			auto a = from.y - to.y;
+			auto b = to.x - from.x;
+			auto c = -(a * from.x + b * from.y);
+
+			edgeA[i] = _mm_set1_ps(a);
+			edgeB[i] = _mm_set1_ps(b);
+			edgeC[i] = _mm_set1_ps(c);
+		}
+
+		// Depth is planar in screen space; the farthest depth within a pixel
+		// is at one of its corners
+		auto dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+		auto dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+		auto dzc = v0.z - dzdx * v0.x - dzdy * v0.y + 0.5f * (std::abs(dzdx) + std::abs(dzdy));
+
+		auto const depthA = _mm_set1_ps(dzdx);
+		auto const farthest = _mm_set1_ps(std::max(std::max(v0.z, v1.z), v2.z));
+		auto const zero = _mm_setzero_ps();
+		auto const lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+		auto const startX = S32(minX) & ~3;
+		auto const endX = S32(maxX);
+
+		for (auto y = S32(minY); y <= S32(maxY); ++y)
+		{
+			auto centreY = _mm_set1_ps(F32(y) + 0.5f);
+			__m128 rowC[3];
+			for (U32 i = 0; i < 3; ++i)
+				rowC[i] = _mm_add_ps(_mm_mul_ps(edgeB[i], centreY), edgeC[i]);
+
+			auto depthC = _mm_set1_ps(dzdy * (F32(y) + 0.5f) + dzc);
+			auto row = this->depth_.data() + y * this->width_;
+
+			for (auto x = startX; x <= endX; x += 4)
+			{
+				auto centreX = _mm_add_ps(_mm_set1_ps(F32(x)), lanes);
+
+				auto e0 = _mm_add_ps(_mm_mul_ps(edgeA[0], centreX), rowC[0]);
+				auto e1 = _mm_add_ps(_mm_mul_ps(edgeA[1], centreX), rowC[1]);
+				auto e2 = _mm_add_ps(_mm_mul_ps(edgeA[2], centreX), rowC[2]);
+
+				auto covered = _mm_cmpge_ps(_mm_min_ps(_mm_min_ps(e0, e1), e2), zero);
+				if (!_mm_movemask_ps(covered))
+					continue;
+
+				auto depth = _mm_min_ps(_mm_add_ps(_mm_mul_ps(depthA, centreX), depthC), farthest);
+				auto previous = _mm_loadu_ps(row + x);
+				auto updated = _mm_min_ps(previous, depth);
+
+				_mm_storeu_ps(row + x, _mm_or_ps(
+					_mm_and_ps(covered, updated), _mm_andnot_ps(covered, previous)));
+			}
+		}
+	}
+
+	Vec3 OcclusionCuller::ToScreen(Vec4 const& clip) const
+	{
+		auto inverseW = 1.0f / clip.w;
+		return Vec3(
+			(clip.x * inverseW * 0.5f + 0.5f) * F32(this->width_),
+			(0.5f - clip.y * inverseW * 0.5f) * F32(this->height_),
+			clip.z * inverseW);
+	}
+
+} }
\ No newline at end of file
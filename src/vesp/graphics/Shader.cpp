@@ -1,6 +1,8 @@
 #pragma warning(disable: 4005)
 #include "vesp/graphics/Shader.hpp"
 #include "vesp/graphics/Engine.hpp"
+#include "vesp/graphics/ShaderManager.hpp"
+#include "vesp/graphics/ShaderCache.hpp"
 #include "vesp/Log.hpp"
 
 #include "vesp/Assert.hpp"
@@ -16,51 +18,42 @@ namespace vesp { namespace graphics {
 		this->name_ = std::move(name.CopyToVector());
 	}
 
-	void* Shader::Compile(StringView const shaderSource)
+	bool Shader::Compile(StringView const shaderSource)
 	{
-		HRESULT hr = S_OK;
 		const bool DebuggingEnabled = false;
-		U32 shaderFlags = D3DCOMPILE_ENABLE_STRICTNESS;
+
+		ShaderCompileOptions options;
+		options.name = this->name_;
+		options.entryPoint = StringView("main").CopyToVector();
+		options.flags = D3DCOMPILE_ENABLE_STRICTNESS;
 		if (DebuggingEnabled)
 		{
-			shaderFlags |= D3DCOMPILE_DEBUG;
-			shaderFlags |= D3DCOMPILE_SKIP_OPTIMIZATION;
+			options.flags |= D3DCOMPILE_DEBUG;
+			options.flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 		}
 
-		RawStringPtr target = nullptr;
 		switch (this->type_)
 		{
 		case ShaderType::Pixel:
-			target = "ps_4_0";
+			options.target = StringView("ps_4_0").CopyToVector();
 			break;
 		case ShaderType::Vertex:
-			target = "vs_4_0";
+			options.target = StringView("vs_4_0").CopyToVector();
 			break;
 		default:
-			LogError("Unsupported shader type! Type: %d", this->type_);
-			return nullptr;
+			this->compileErrors_ = StringView("Unsupported shader type").CopyToVector();
+			return false;
 		}
 
-		CComPtr<ID3DBlob> errorBlob = nullptr;
-		ID3DBlob* output = nullptr;
-
-		const auto name = ToCString(this->name_);
+		this->compileErrors_.clear();
 
-		hr = D3DCompile(
-			shaderSource.data(), shaderSource.size(),
-			name.get(), nullptr, nullptr, "main", target, 
-			shaderFlags, 0, &output, &errorBlob);
-
-		if (FAILED(hr))
-		{
-			auto error = static_cast<RawStringPtr>(errorBlob->GetBufferPointer());
-			LogError("Failed to compile shader %s! Error: %s",
-				name, error);
-
-			if (output) output->Release();
-		}
+		auto cache = ShaderManager::Get()->GetShaderCache();
+		return cache->Compile(shaderSource, options, this->bytecode_, this->compileErrors_);
+	}
 
-		return output;
+	StringView Shader::GetCompileErrors()
+	{
+		return StringView(this->compileErrors_);
 	}
 
 	ShaderType Shader::GetType() const {
@@ -82,14 +75,26 @@ namespace vesp { namespace graphics {
 		StringView const shaderSource, 
 		ArrayView<D3D11_INPUT_ELEMENT_DESC> inputLayoutElements)
 	{
-		CComPtr<ID3DBlob> blob = static_cast<ID3DBlob*>(this->Compile(shaderSource));
+		if (!this->Compile(shaderSource))
+		{
+			auto errors = this->GetCompileErrors();
+			LogError("Failed to compile shader %.*s! Error: %.*s",
+				this->name_.size(), this->name_.data(), errors.size(), errors.data());
+			return false;
+		}
+
+		return this->Create(inputLayoutElements);
+	}
 
-		if (!blob) return false;
+	bool VertexShader::Create(ArrayView<D3D11_INPUT_ELEMENT_DESC> inputLayoutElements)
+	{
+		VESP_ASSERT(!this->bytecode_.empty());
+		auto bytecode = std::move(this->bytecode_);
 
 		auto device = Engine::Device;
 
 		HRESULT hr = device->CreateVertexShader(
-			blob->GetBufferPointer(), blob->GetBufferSize(), 
+			bytecode.data(), bytecode.size(), 
 			nullptr, &this->shader_);
 
 		if (FAILED(hr))
@@ -101,7 +106,7 @@ namespace vesp { namespace graphics {
 
 		hr = device->CreateInputLayout(
 			inputLayoutElements.data(), inputLayoutElements.size(),
-			blob->GetBufferPointer(), blob->GetBufferSize(),
+			bytecode.data(), bytecode.size(),
 			&this->inputLayout_);
 
 		if (FAILED(hr))
@@ -131,12 +136,24 @@ namespace vesp { namespace graphics {
 
 	bool PixelShader::Load(StringView const shaderSource)
 	{
-		CComPtr<ID3DBlob> blob = static_cast<ID3DBlob*>(this->Compile(shaderSource));
+		if (!this->Compile(shaderSource))
+		{
+			auto errors = this->GetCompileErrors();
+			LogError("Failed to compile shader %.*s! Error: %.*s",
+				this->name_.size(), this->name_.data(), errors.size(), errors.data());
+			return false;
+		}
 
-		if (!blob) return false;
+		return this->Create();
+	}
+
+	bool PixelShader::Create()
+	{
+		VESP_ASSERT(!this->bytecode_.empty());
+		auto bytecode = std::move(this->bytecode_);
 
 		HRESULT hr = Engine::Device->CreatePixelShader(
-			blob->GetBufferPointer(), blob->GetBufferSize(), 
+			bytecode.data(), bytecode.size(), 
 			nullptr, &this->shader_);
 
 		return SUCCEEDED(hr);
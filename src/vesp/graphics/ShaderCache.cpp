@@ -0,0 +1,123 @@
+#include "vesp/graphics/ShaderCache.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+namespace vesp { namespace graphics {
+
+	ShaderCache::ShaderCache(ShaderCompiler& compiler, ShaderCacheStorage& storage)
+		: compiler_(compiler), storage_(storage)
+	{
+	}
+
+	bool ShaderCache::Compile(StringView const source, ShaderCompileOptions const& options,
+		Vector<U8>& bytecode, String& errors)
+	{
+		auto key = this->GetKey(source, options);
+
+		if (this->Read(key, bytecode))
+		{
+			++this->hits_;
+			return true;
+		}
+
+		++this->misses_;
+		if (!this->compiler_.Compile(source, options, bytecode, errors))
+			return false;
+
+		this->Write(key, bytecode);
+		return true;
+	}
+
+	U64 ShaderCache::GetKey(StringView const source, ShaderCompileOptions const& options) const
+	{
+		// Two independently seeded 32-bit hashes, chained over every field
+		U32 high = 0x8a5cd789;
+		U32 low = 0x35a7bd1a;
+
+		auto mix = [&](StringView const data)
+		{
+			high = util::MurmurHash(data, high);
+			low = util::MurmurHash(data, low);
+		};
+
+		auto mixValue = [&](U32 value)
+		{
+			mix(StringView(reinterpret_cast<StringByte*>(&value), sizeof(value)));
+		};
+
+		mix(this->compiler_.GetIdentifier());
+		mix(source);
+		mix(options.target);
+		mix(options.entryPoint);
+		mixValue(options.flags);
+
+		mixValue(U32(options.defines.size()));
+		for (auto& define : options.defines)
+		{
+			mix(define.name);
+			mix(define.value);
+		}
+
+		return (U64(high) << 32) | low;
+	}
+
+	String ShaderCache::GetName(U64 key) const
+	{
+		StringByte fileName[32];
+		auto length = snprintf(fileName, sizeof(fileName), "%016" PRIx64 ".cso", key);
+		
+		return String(fileName, fileName + length);
+	}
+
+	U32 ShaderCache::GetHits() const
+	{
+		return this->hits_;
+	}
+
+	U32 ShaderCache::GetMisses() const
+	{
+		return this->misses_;
+	}
+
+	bool ShaderCache::Read(U64 key, Vector<U8>& bytecode)
+	{
+		Vector<U8> blob;
+		if (!this->storage_.Read(this->GetName(key), blob) || blob.size() < sizeof(ShaderCacheHeader))
+			return false;
+
+		ShaderCacheHeader header;
+		std::memcpy(&header, blob.data(), sizeof(header));
+
+		// Anything unexpected is treated as a miss and overwritten
+		if (header.magic != ShaderCacheHeader::Magic ||
+			header.version != ShaderCacheHeader::CurrentVersion ||
+			header.key != key ||
+			header.size != blob.size() - sizeof(header))
+		{
+			return false;
+		}
+
+		bytecode.assign(blob.begin() + sizeof(header), blob.end());
+		return true;
+	}
+
+	void ShaderCache::Write(U64 key, ArrayView<U8> bytecode)
+	{
+		ShaderCacheHeader header;
+		header.magic = ShaderCacheHeader::Magic;
+		header.version = ShaderCacheHeader::CurrentVersion;
+		header.key = key;
+		header.size = U32(bytecode.size());
+		header.reserved = 0;
+
+		Vector<U8> blob(sizeof(header) + bytecode.size());
+		std::memcpy(blob.data(), &header, sizeof(header));
+		std::copy(bytecode.begin(), bytecode.end(), blob.begin() + sizeof(header));
+
+		this->storage_.Write(this->GetName(key), blob);
+	}
+
+} }
\ No newline at end of file
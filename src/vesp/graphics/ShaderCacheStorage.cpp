@@ -0,0 +1,58 @@
+#include "vesp/graphics/ShaderCacheStorage.hpp"
+
+#include "vesp/FileSystem.hpp"
+
+#include <thread>
+
+namespace vesp { namespace graphics {
+
+	FileShaderCacheStorage::FileShaderCacheStorage(StringView directory)
+	{
+		this->directory_ = directory.CopyToVector();
+		FileSystem::Get()->MakeDirectory(this->directory_);
+	}
+
+	bool FileShaderCacheStorage::Read(StringView const name, Vector<U8>& data)
+	{
+		auto path = this->GetPath(name);
+		if (!FileSystem::Get()->Exists(path))
+			return false;
+
+		auto file = FileSystem::Get()->Open(path, FileSystem::Mode::ReadBinary);
+		if (!file.Exists())
+			return false;
+
+		data.resize(file.Size());
+		return file.Read(data) == data.size();
+	}
+
+	void FileShaderCacheStorage::Write(StringView const name, ArrayView<U8> data)
+	{
+		// Write to a temporary first so that concurrent readers, including
+		// other instances of the engine, never see a partial blob
+		auto path = this->GetPath(name);
+		auto tempPath = path;
+		Concat(tempPath, ".tmp");
+		Concat(tempPath, ToString(size_t(std::hash<std::thread::id>()(std::this_thread::get_id()))));
+
+		{
+			auto file = FileSystem::Get()->Open(tempPath, 
+				FileSystem::Mode::Enum(FileSystem::Mode::Write | FileSystem::Mode::Binary));
+			if (!file.Exists())
+				return;
+
+			file.Write(data);
+		}
+
+		FileSystem::Get()->Rename(tempPath, path);
+	}
+
+	String FileShaderCacheStorage::GetPath(StringView const name) const
+	{
+		auto path = this->directory_;
+		path.push_back('/');
+		Concat(path, name);
+		return path;
+	}
+
+} }
\ No newline at end of file
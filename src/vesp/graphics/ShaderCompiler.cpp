@@ -0,0 +1,58 @@
+#include "vesp/graphics/ShaderCompiler.hpp"
+
+#include <atlbase.h>
+#include <d3dcompiler.h>
+
+namespace vesp { namespace graphics {
+
+	bool D3DShaderCompiler::Compile(StringView const source, ShaderCompileOptions const& options,
+		Vector<U8>& bytecode, String& errors)
+	{
+		auto name = ToCString(options.name);
+		auto target = ToCString(options.target);
+		auto entryPoint = ToCString(options.entryPoint);
+
+		Vector<UniquePtr<StringByte[]>> defineStrings;
+		Vector<D3D_SHADER_MACRO> macros;
+		for (auto& define : options.defines)
+		{
+			defineStrings.push_back(ToCString(define.name));
+			defineStrings.push_back(ToCString(define.value));
+
+			auto count = defineStrings.size();
+			macros.push_back({ defineStrings[count - 2].get(), defineStrings[count - 1].get() });
+		}
+		macros.push_back({ nullptr, nullptr });
+
+		CComPtr<ID3DBlob> output;
+		CComPtr<ID3DBlob> errorBlob;
+
+		HRESULT hr = D3DCompile(
+			source.data(), source.size(),
+			name.get(), macros.data(), nullptr, entryPoint.get(), target.get(),
+			options.flags, 0, &output, &errorBlob);
+
+		if (FAILED(hr))
+		{
+			errors.clear();
+			if (errorBlob)
+			{
+				auto error = static_cast<StringByte*>(errorBlob->GetBufferPointer());
+				errors.assign(error, error + strnlen(error, errorBlob->GetBufferSize()));
+			}
+
+			return false;
+		}
+
+		auto data = static_cast<U8*>(output->GetBufferPointer());
+		bytecode.assign(data, data + output->GetBufferSize());
+
+		return true;
+	}
+
+	StringView D3DShaderCompiler::GetIdentifier() const
+	{
+		return D3DCOMPILER_DLL_A;
+	}
+
+} }
\ No newline at end of file
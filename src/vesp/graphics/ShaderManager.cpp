@@ -1,6 +1,7 @@
 #include "vesp/graphics/ShaderManager.hpp"
 
-#include "vesp/FileSystem.hpp"
+#include "vesp/AssetLoader.hpp"
+#include "vesp/FileWatcher.hpp"
 #include "vesp/Assert.hpp"
 #include "vesp/Console.hpp"
 #include "vesp/Log.hpp"
@@ -10,10 +11,38 @@
 
 namespace vesp { namespace graphics {
 
-	ShaderManager::ShaderManager() {
+	namespace
+	{
+		D3D11_INPUT_ELEMENT_DESC VertexLayout[] =
+		{
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,
+			D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			{ "NORMAL", 0, DXGI_FORMAT_R16G16_UNORM, 0,
+			D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_UNORM, 0,
+			D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0,
+			D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		};
+
+		struct ShaderAsset
+		{
+			UniquePtr<Shader> shader;
+			bool compiled = false;
+		};
+	}
+
+	ShaderManager::ShaderManager()
+		: cacheStorage_("data/shadercache"), cache_(compiler_, cacheStorage_)
+	{
 		Console::Get()->AddCommand("shader.reloadall", [&]() {
 			this->ReloadAll();
 		});
+
+		Console::Get()->AddCommand("shader.cachestats", [&]() {
+			LogInfo("Shader cache: %u hits, %u misses", 
+				this->cache_.GetHits(), this->cache_.GetMisses());
+		});
 	}
 
 	void ShaderManager::LoadShader(StringView const name, ShaderType type)
@@ -31,49 +60,93 @@ namespace vesp { namespace graphics {
 		}
 		
 		Concat(filePath, extension);
-		auto file = FileSystem::Get()->Open(filePath, FileSystem::Mode::Read);
-		VESP_ASSERT(file.Exists());
 
-		auto shaderContents = file.Read<StringByte>();
+		// Compilation happens on an asset loader worker; only the device
+		// objects are created on the main thread. Any shader previously
+		// loaded under this name stays in use until the new one is ready.
+		auto shaderName = name.CopyToVector();
+		auto key = this->GetKey(name, type);
 
-		D3D11_INPUT_ELEMENT_DESC layout[] =
+		// Only the edited shader is recompiled when its file changes
+		auto fileWatcher = FileWatcher::Get();
+		if (!fileWatcher->IsWatched(filePath))
 		{
-			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,
-			D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			{ "NORMAL", 0, DXGI_FORMAT_R16G16_UNORM, 0,
-			D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_UNORM, 0,
-			D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0,
-			D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		};
+			fileWatcher->Watch(filePath, [this, shaderName, type](StringView) mutable {
+				this->LoadShader(shaderName, type);
+			});
+		}
 
-		UniquePtr<Shader> shader;
-		switch (type)
+		auto compile = [shaderName, type](ArrayView<U8> data, ShaderAsset& asset) mutable
 		{
-		case ShaderType::Vertex:
+			switch (type)
+			{
+			case ShaderType::Vertex:
+				asset.shader = std::make_unique<VertexShader>(shaderName);
+				break;
+			case ShaderType::Pixel:
+				asset.shader = std::make_unique<PixelShader>(shaderName);
+				break;
+			}
+
+			auto source = StringView(reinterpret_cast<StringByte*>(data.data()), data.size());
+			asset.compiled = asset.shader->Compile(source);
+			return true;
+		};
+
+		// A shader that has never loaded has nothing to fall back to, so
+		// that is still fatal; a failed reload keeps the previous version
+		auto keepPrevious = [this, key, shaderName]
 		{
-			auto vertexShader = std::make_unique<VertexShader>(name);
-			VESP_ENFORCE(vertexShader->Load(shaderContents, layout));
-			shader = std::move(vertexShader);
-			break;
-		}
-		case ShaderType::Pixel:
+			VESP_ENFORCE(this->shaders_.find(key) != this->shaders_.end());
+			LogWarn("Keeping the previous version of shader %.*s", 
+				shaderName.size(), shaderName.data());
+		};
+
+		auto create = [this, key, keepPrevious](ShaderAsset& asset)
 		{
-			auto pixelShader = std::make_unique<PixelShader>(name);
-			VESP_ENFORCE(pixelShader->Load(shaderContents));
-			shader = std::move(pixelShader);
-			break;
-		}
-		}
+			auto shader = asset.shader.get();
+			auto name = shader->GetName();
+
+			if (!asset.compiled)
+			{
+				auto errors = shader->GetCompileErrors();
+				LogError("Failed to compile shader %.*s! Error: %.*s",
+					name.size(), name.data(), errors.size(), errors.data());
+				keepPrevious();
+				return;
+			}
+
+			bool created = false;
+			switch (shader->GetType())
+			{
+			case ShaderType::Vertex:
+				created = static_cast<VertexShader*>(shader)->Create(VertexLayout);
+				break;
+			case ShaderType::Pixel:
+				created = static_cast<PixelShader*>(shader)->Create();
+				break;
+			}
+
+			if (!created)
+			{
+				LogError("Failed to create shader %.*s", name.size(), name.data());
+				keepPrevious();
+				return;
+			}
+
+			this->shaders_[key] = std::move(asset.shader);
+		};
 
-		this->shaders_[this->GetKey(name, type)] = std::move(shader);
+		// The loader has already logged a file that could not be read
+		AssetLoader::Get()->Load<ShaderAsset>(filePath, compile, create, keepPrevious);
 	}
 
 	Shader* ShaderManager::GetShader(StringView const name, ShaderType type) const
 	{
 		auto it = this->shaders_.find(this->GetKey(name, type));
-		VESP_ASSERT(it != this->shaders_.end());
+		if (it == this->shaders_.end())
+			return nullptr;
+
 		return it->second.get();
 	}
 
@@ -89,6 +162,11 @@ namespace vesp { namespace graphics {
 			this->GetShader(name, ShaderType::Pixel));
 	}
 
+	ShaderCache* ShaderManager::GetShaderCache()
+	{
+		return &this->cache_;
+	}
+
 	void ShaderManager::ReloadAll() {
 		struct ShaderInfo {
 			String name;
@@ -108,7 +186,7 @@ namespace vesp { namespace graphics {
 
 		for (auto& shader : shaders) {
 			this->LoadShader(shader.name, shader.type);
-			LogInfo("Reloaded %s shader %.*s", 
+			LogInfo("Reloading %s shader %.*s", 
 				shader.type == ShaderType::Pixel ? "pixel" : 
 				shader.type == ShaderType::Vertex ? "vertex" : 
 				"unknown",
@@ -0,0 +1,98 @@
+#include "vesp/graphics/Texture.hpp"
+#include "vesp/graphics/Engine.hpp"
+
+#include "vesp/Log.hpp"
+
+namespace vesp { namespace graphics {
+
+	namespace
+	{
+		DXGI_FORMAT GetDXGIFormat(TextureFormat format)
+		{
+			switch (format)
+			{
+			case TextureFormat::R8:
+				return DXGI_FORMAT_R8_UNORM;
+			case TextureFormat::RG8:
+				return DXGI_FORMAT_R8G8_UNORM;
+			case TextureFormat::RGBA8:
+				return DXGI_FORMAT_R8G8B8A8_UNORM;
+			case TextureFormat::BC1:
+				return DXGI_FORMAT_BC1_UNORM;
+			case TextureFormat::BC3:
+				return DXGI_FORMAT_BC3_UNORM;
+			case TextureFormat::BC4:
+				return DXGI_FORMAT_BC4_UNORM;
+			case TextureFormat::BC5:
+				return DXGI_FORMAT_BC5_UNORM;
+			}
+
+			return DXGI_FORMAT_UNKNOWN;
+		}
+	}
+
+	bool Texture::Create(TextureData& texture)
+	{
+		if (!HasValidDimensions(texture.format, texture.width, texture.height))
+		{
+			LogError("Cannot create a %ux%u texture in format %u; block compressed formats need dimensions that are multiples of 4",
+				texture.width, texture.height, U32(texture.format));
+			return false;
+		}
+
+		auto levelCount = U32(texture.levels.size());
+
+		D3D11_TEXTURE2D_DESC desc;
+		ZeroMemory(&desc, sizeof(desc));
+		desc.Width = texture.width;
+		desc.Height = texture.height;
+		desc.MipLevels = levelCount;
+		desc.ArraySize = 1;
+		desc.Format = GetDXGIFormat(texture.format);
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_IMMUTABLE;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+		Vector<D3D11_SUBRESOURCE_DATA> initData(levelCount);
+		for (U32 i = 0; i < levelCount; ++i)
+		{
+			initData[i].pSysMem = texture.GetLevel(i).data();
+			initData[i].SysMemPitch = texture.GetRowPitch(i);
+			initData[i].SysMemSlicePitch = texture.levels[i].size;
+		}
+
+		auto hr = Engine::Device->CreateTexture2D(&desc, initData.data(), &this->texture_);
+		if (FAILED(hr))
+		{
+			LogError("Failed to create texture (%ux%u, format: %d, error: %X)",
+				texture.width, texture.height, desc.Format, hr);
+			return false;
+		}
+
+		hr = Engine::Device->CreateShaderResourceView(this->texture_, nullptr, &this->view_);
+		if (FAILED(hr))
+		{
+			LogError("Failed to create texture view (error: %X)", hr);
+			this->texture_.Release();
+			return false;
+		}
+
+		return true;
+	}
+
+	void Texture::Use(U32 slot)
+	{
+		Engine::ImmediateContext->PSSetShaderResources(slot, 1, &this->view_.p);
+	}
+
+	bool Texture::Exists() const
+	{
+		return this->view_ != nullptr;
+	}
+
+	ID3D11ShaderResourceView* Texture::GetView()
+	{
+		return this->view_;
+	}
+
+} }
\ No newline at end of file
@@ -0,0 +1,868 @@
+#include "vesp/graphics/TextureBuilder.hpp"
+#include "vesp/graphics/stb_image.h"
+
+#include "vesp/util/ParallelFor.hpp"
+#include "vesp/util/MurmurHash.hpp"
+
+#include "vesp/FileSystem.hpp"
+#include "vesp/Assert.hpp"
+#include "vesp/Log.hpp"
+
+#include <emmintrin.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace vesp { namespace graphics {
+
+	namespace
+	{
+		struct TextureFileHeader
+		{
+			static const U32 Magic = 0x54505356; // "VSPT"
+			static const U32 CurrentVersion = 1;
+
+			U32 magic;
+			U32 version;
+			U64 key;
+			U32 width;
+			U32 height;
+			U32 levelCount;
+			U32 dataSize;
+			U8 format;
+			U8 reserved[7];
+		};
+
+		static_assert(sizeof(TextureFileHeader) == 40, "TextureFileHeader size is wrong");
+
+		// Mips are generated with one channel for single channel formats and
+		// four for everything else
+		U32 GetMipChannels(TextureFormat format)
+		{
+			return GetSourceChannels(format) == 1 ? 1 : 4;
+		}
+
+		// Box filter
+		void BoxDownsample(U8 const* source, U32 width, U32 height, U32 channels,
+			U8* dest, U32 destWidth, U32 destHeight)
+		{
+			auto const zero = _mm_setzero_si128();
+			auto const ones = _mm_set1_epi16(1);
+			auto const two = _mm_set1_epi16(2);
+
+			// Outputs below this have both of their columns inside the source
+			auto const pairCount = std::min(width / 2, destWidth);
+
+			for (U32 y = 0; y < destHeight; ++y)
+			{
+				auto row0 = source + std::min(2 * y, height - 1) * width * channels;
+				auto row1 = source + std::min(2 * y + 1, height - 1) * width * channels;
+				auto out = dest + y * destWidth * channels;
+
+				U32 x = 0;
+				if (channels == 1)
+				{
+					// 16 source texels per row to 8 destination texels
+					for (; x + 8 <= pairCount; x += 8)
+					{
+						auto a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row0 + 2 * x));
+						auto b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row1 + 2 * x));
+
+						auto lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+						auto hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+						// Horizontal neighbours are adjacent lanes
+						auto sums = _mm_packs_epi32(_mm_madd_epi16(lo, ones), _mm_madd_epi16(hi, ones));
+						auto result = _mm_srli_epi16(_mm_add_epi16(sums, two), 2);
+
+						_mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(result, result));
+					}
+				}
+				else if (channels == 4)
+				{
+					// 8 source texels per row to 4 destination texels
+					for (; x + 4 <= pairCount; x += 4)
+					{
+						auto a0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row0 + 8 * x));
+						auto a1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row0 + 8 * x + 16));
+						auto b0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row1 + 8 * x));
+						auto b1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row1 + 8 * x + 16));
+
+						// Each vector holds the vertical sums of two texels
+						auto v0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+						auto v1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+						auto v2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+						auto v3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+						// Add the upper texel onto the lower one
+						v0 = _mm_add_epi16(v0, _mm_srli_si128(v0, 8));
+						v1 = _mm_add_epi16(v1, _mm_srli_si128(v1, 8));
+						v2 = _mm_add_epi16(v2, _mm_srli_si128(v2, 8));
+						v3 = _mm_add_epi16(v3, _mm_srli_si128(v3, 8));
+
+						auto r0 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(v0, v1), two), 2);
+						auto r1 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(v2, v3), two), 2);
+
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * x), _mm_packus_epi16(r0, r1));
+					}
+				}
+
+				for (; x < destWidth; ++x)
+				{
+					auto x0 = std::min(2 * x, width - 1) * channels;
+					auto x1 = std::min(2 * x + 1, width - 1) * channels;
+
+					for (U32 c = 0; c < channels; ++c)
+					{
+						U32 sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+						out[x * channels + c] = U8((sum + 2) >> 2);
+					}
+				}
+			}
+		}
+
+		// Kaiser-windowed sinc, evaluated at the eight source texels around
+		// each destination texel
+		const U32 KaiserTaps = 8;
+		const F32 KaiserAlpha = 4.0f;
+
+		F32 BesselI0(F32 x)
+		{
+			F32 sum = 1.0f;
+			F32 term = 1.0f;
+			for (U32 k = 1; k < 16; ++k)
+			{
+				auto half = x / (2.0f * F32(k));
+				term *= half * half;
+				sum += term;
+			}
+			return sum;
+		}
+
+		Array<F32, KaiserTaps> CalculateKaiserWeights()
+		{
+			auto const pi = 3.14159265f;
+			auto const radius = KaiserTaps / 2.0f;
+
+			Array<F32, KaiserTaps> weights;
+			F32 total = 0.0f;
+
+			for (U32 k = 0; k < KaiserTaps; ++k)
+			{
+				// Distance in source texels from the destination texel centre
+				auto d = F32(k) - (KaiserTaps - 1) / 2.0f;
+
+				auto x = pi * d / 2.0f;
+				auto sinc = x == 0.0f ? 1.0f : std::sin(x) / x;
+
+				auto r = d / radius;
+				auto window = BesselI0(KaiserAlpha * std::sqrt(std::max(0.0f, 1.0f - r * r))) / 
+					BesselI0(KaiserAlpha);
+
+				weights[k] = sinc * window;
+				total += weights[k];
+			}
+
+			for (auto& weight : weights)
+				weight /= total;
+
+			return weights;
+		}
+
+		void KaiserDownsample(U8 const* source, U32 width, U32 height, U32 channels,
+			U8* dest, U32 destWidth, U32 destHeight)
+		{
+			static auto const Weights = CalculateKaiserWeights();
+			S32 const TapOffset = (KaiserTaps / 2) - 1;
+
+			// Horizontal pass into floats. Rows are padded to whole vectors
+			// and the source row is padded with its edge texels, so the inner
+			// loops never need to clamp.
+			auto const destRowFloats = channels == 1 ? 
+				(destWidth + 3) & ~3u : destWidth * channels;
+			auto const paddedTexels = 2 * ((destWidth + 3) & ~3u) + KaiserTaps;
+
+			Vector<F32> horizontal(height * destRowFloats);
+			Vector<F32> padded(paddedTexels * channels + 4);
+
+			for (U32 y = 0; y < height; ++y)
+			{
+				auto row = source + y * width * channels;
+				for (U32 i = 0; i < paddedTexels; ++i)
+				{
+					auto x = std::min(std::max(S32(i) - TapOffset, 0), S32(width - 1));
+					for (U32 c = 0; c < channels; ++c)
+						padded[i * channels + c] = row[x * channels + c];
+				}
+
+				auto out = horizontal.data() + y * destRowFloats;
+				if (channels == 1)
+				{
+					for (U32 x = 0; x < destWidth; x += 4)
+					{
+						auto sum = _mm_setzero_ps();
+						for (U32 k = 0; k < KaiserTaps; ++k)
+						{
+							// Every other texel from 2x + k onwards
+							auto a = _mm_loadu_ps(padded.data() + 2 * x + k);
+							auto b = _mm_loadu_ps(padded.data() + 2 * x + k + 4);
+							auto even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+							sum = _mm_add_ps(sum, _mm_mul_ps(even, _mm_set1_ps(Weights[k])));
+						}
+						_mm_storeu_ps(out + x, sum);
+					}
+				}
+				else
+				{
+					VESP_ASSERT(channels == 4);
+					for (U32 x = 0; x < destWidth; ++x)
+					{
+						auto sum = _mm_setzero_ps();
+						for (U32 k = 0; k < KaiserTaps; ++k)
+						{
+							auto texel = _mm_loadu_ps(padded.data() + (2 * x + k) * 4);
+							sum = _mm_add_ps(sum, _mm_mul_ps(texel, _mm_set1_ps(Weights[k])));
+						}
+						_mm_storeu_ps(out + x * 4, sum);
+					}
+				}
+			}
+
+			// Vertical pass, converting back to bytes
+			Vector<U8> rowBytes(destRowFloats + 16);
+			for (U32 y = 0; y < destHeight; ++y)
+			{
+				for (U32 i = 0; i < destRowFloats; i += 4)
+				{
+					auto sum = _mm_setzero_ps();
+					for (U32 k = 0; k < KaiserTaps; ++k)
+					{
+						auto sourceY = std::min(std::max(S32(2 * y + k) - TapOffset, 0), S32(height - 1));
+						auto value = _mm_loadu_ps(horizontal.data() + sourceY * destRowFloats + i);
+						sum = _mm_add_ps(sum, _mm_mul_ps(value, _mm_set1_ps(Weights[k])));
+					}
+
+					// Negative lobes can overshoot; the packs saturate to 0-255
+					auto integers = _mm_cvtps_epi32(sum);
+					auto words = _mm_packs_epi32(integers, integers);
+					auto bytes = _mm_packus_epi16(words, words);
+					*reinterpret_cast<S32*>(rowBytes.data() + i) = _mm_cvtsi128_si32(bytes);
+				}
+
+				memcpy(dest + y * destWidth * channels, rowBytes.data(), destWidth * channels);
+			}
+		}
+
+		// Block compression
+		void FetchBlock(U8 const* source, U32 width, U32 height, U32 channels,
+			U32 blockX, U32 blockY, U8* block)
+		{
+			for (U32 py = 0; py < 4; ++py)
+			{
+				auto y = std::min(blockY * 4 + py, height - 1);
+				for (U32 px = 0; px < 4; ++px)
+				{
+					auto x = std::min(blockX * 4 + px, width - 1);
+					memcpy(block + (py * 4 + px) * channels, 
+						source + (y * width + x) * channels, channels);
+				}
+			}
+		}
+
+		// 8 byte block: two endpoints and a 3-bit index per texel
+		void EncodeBC4(U8 const* values, U32 stride, U8* out)
+		{
+			U8 minValue = 255;
+			U8 maxValue = 0;
+			for (U32 i = 0; i < 16; ++i)
+			{
+				minValue = std::min(minValue, values[i * stride]);
+				maxValue = std::max(maxValue, values[i * stride]);
+			}
+
+			// The eight value mode is selected by the first endpoint being larger
+			out[0] = maxValue;
+			out[1] = minValue;
+
+			U64 bits = 0;
+			if (maxValue != minValue)
+			{
+				S32 palette[8];
+				palette[0] = maxValue;
+				palette[1] = minValue;
+				for (S32 i = 1; i < 7; ++i)
+					palette[i + 1] = ((7 - i) * maxValue + i * minValue + 3) / 7;
+
+				for (U32 i = 0; i < 16; ++i)
+				{
+					S32 value = values[i * stride];
+
+					U32 best = 0;
+					S32 bestError = 256;
+					for (U32 j = 0; j < 8; ++j)
+					{
+						auto error = std::abs(value - palette[j]);
+						if (error < bestError)
+						{
+							best = j;
+							bestError = error;
+						}
+					}
+
+					bits |= U64(best) << (3 * i);
+				}
+			}
+
+			for (U32 i = 0; i < 6; ++i)
+				out[2 + i] = U8(bits >> (8 * i));
+		}
+
+		U16 To565(F32 const* colour)
+		{
+			auto quantise = [](F32 value, U32 maximum)
+			{
+				auto clamped = std::min(std::max(value, 0.0f), 255.0f);
+				return U32(clamped * maximum / 255.0f + 0.5f);
+			};
+
+			return U16((quantise(colour[0], 31) << 11) | 
+				(quantise(colour[1], 63) << 5) | quantise(colour[2], 31));
+		}
+
+		void From565(U16 packed, S32* colour)
+		{
+			S32 r = (packed >> 11) & 31;
+			S32 g = (packed >> 5) & 63;
+			S32 b = packed & 31;
+
+			colour[0] = (r << 3) | (r >> 2);
+			colour[1] = (g << 2) | (g >> 4);
+			colour[2] = (b << 3) | (b >> 2);
+		}
+
+		U32 SelectBC1Indices(U8 const* rgba, U16 c0, U16 c1)
+		{
+			S32 palette[4][3];
+			From565(c0, palette[0]);
+			From565(c1, palette[1]);
+			for (U32 c = 0; c < 3; ++c)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+
+			U32 indices = 0;
+			for (U32 i = 0; i < 16; ++i)
+			{
+				auto texel = rgba + i * 4;
+
+				U32 best = 0;
+				S32 bestError = INT32_MAX;
+				for (U32 j = 0; j < 4; ++j)
+				{
+					S32 dr = texel[0] - palette[j][0];
+					S32 dg = texel[1] - palette[j][1];
+					S32 db = texel[2] - palette[j][2];
+					auto error = dr * dr + dg * dg + db * db;
+
+					if (error < bestError)
+					{
+						best = j;
+						bestError = error;
+					}
+				}
+
+				indices |= best << (2 * i);
+			}
+
+			return indices;
+		}
+
+		void WriteBC1(U16 c0, U16 c1, U32 indices, U8* out)
+		{
+			out[0] = U8(c0);
+			out[1] = U8(c0 >> 8);
+			out[2] = U8(c1);
+			out[3] = U8(c1 >> 8);
+			for (U32 i = 0; i < 4; ++i)
+				out[4 + i] = U8(indices >> (8 * i));
+		}
+
+		// 8 byte block: two 565 endpoints and a 2-bit index per texel. Only
+		// the four colour mode is used, so BC3 can share the encoder.
+		void EncodeBC1(U8 const* rgba, U8* out)
+		{
+			// Endpoints start at the extremes of the principal axis
+			F32 mean[3] = {};
+			for (U32 i = 0; i < 16; ++i)
+				for (U32 c = 0; c < 3; ++c)
+					mean[c] += F32(rgba[i * 4 + c]) / 16.0f;
+
+			F32 covariance[6] = {};
+			for (U32 i = 0; i < 16; ++i)
+			{
+				F32 r = rgba[i * 4 + 0] - mean[0];
+				F32 g = rgba[i * 4 + 1] - mean[1];
+				F32 b = rgba[i * 4 + 2] - mean[2];
+
+				covariance[0] += r * r;
+				covariance[1] += r * g;
+				covariance[2] += r * b;
+				covariance[3] += g * g;
+				covariance[4] += g * b;
+				covariance[5] += b * b;
+			}
+
+			F32 axis[3] = { 1.0f, 1.0f, 1.0f };
+			for (U32 iteration = 0; iteration < 4; ++iteration)
+			{
+				F32 next[3] = {
+					covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+					covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+					covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+				};
+
+				auto length = std::max(std::max(std::abs(next[0]), std::abs(next[1])), std::abs(next[2]));
+				if (length < 1e-6f)
+					break;
+
+				for (U32 c = 0; c < 3; ++c)
+					axis[c] = next[c] / length;
+			}
+
+			F32 minProjection = FLT_MAX;
+			F32 maxProjection = -FLT_MAX;
+			U32 minTexel = 0;
+			U32 maxTexel = 0;
+			for (U32 i = 0; i < 16; ++i)
+			{
+				auto projection = 
+					rgba[i * 4 + 0] * axis[0] + rgba[i * 4 + 1] * axis[1] + rgba[i * 4 + 2] * axis[2];
+
+				if (projection < minProjection)
+				{
+					minProjection = projection;
+					minTexel = i;
+				}
+				if (projection > maxProjection)
+				{
+					maxProjection = projection;
+					maxTexel = i;
+				}
+			}
+
+			F32 endpoints[2][3];
+			for (U32 c = 0; c < 3; ++c)
+			{
+				endpoints[0][c] = rgba[maxTexel * 4 + c];
+				endpoints[1][c] = rgba[minTexel * 4 + c];
+			}
+
+			auto c0 = To565(endpoints[0]);
+			auto c1 = To565(endpoints[1]);
+			if (c0 == c1)
+			{
+				WriteBC1(c0, c1, 0, out);
+				return;
+			}
+
+			if (c0 < c1)
+				std::swap(c0, c1);
+
+			auto indices = SelectBC1Indices(rgba, c0, c1);
+
+			// One least squares pass fits the endpoints to the chosen indices
+			static const F32 Weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+			F32 aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			F32 ax[3] = {};
+			F32 bx[3] = {};
+			for (U32 i = 0; i < 16; ++i)
+			{
+				auto a = Weights[(indices >> (2 * i)) & 3];
+				auto b = 1.0f - a;
+
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+
+				for (U32 c = 0; c < 3; ++c)
+				{
+					ax[c] += a * rgba[i * 4 + c];
+					bx[c] += b * rgba[i * 4 + c];
+				}
+			}
+
+			auto determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) > 1e-6f)
+			{
+				for (U32 c = 0; c < 3; ++c)
+				{
+					endpoints[0][c] = (ax[c] * bb - bx[c] * ab) / determinant;
+					endpoints[1][c] = (bx[c] * aa - ax[c] * ab) / determinant;
+				}
+
+				auto refined0 = To565(endpoints[0]);
+				auto refined1 = To565(endpoints[1]);
+				if (refined0 < refined1)
+					std::swap(refined0, refined1);
+
+				if (refined0 != refined1)
+				{
+					c0 = refined0;
+					c1 = refined1;
+					indices = SelectBC1Indices(rgba, c0, c1);
+				}
+			}
+
+			WriteBC1(c0, c1, indices, out);
+		}
+
+		U64 HashBytes(ArrayView<U8> data, U64 key)
+		{
+			auto view = StringView(reinterpret_cast<StringByte*>(data.data()), data.size());
+			auto high = util::MurmurHash(view, U32(key >> 32));
+			auto low = util::MurmurHash(view, U32(key));
+			return (U64(high) << 32) | low;
+		}
+	}
+
+	U32 GetSourceChannels(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::R8:
+		case TextureFormat::BC4:
+			return 1;
+		case TextureFormat::RG8:
+		case TextureFormat::BC5:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	bool IsBlockCompressed(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1:
+		case TextureFormat::BC3:
+		case TextureFormat::BC4:
+		case TextureFormat::BC5:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	U32 GetElementSize(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::R8:
+			return 1;
+		case TextureFormat::RG8:
+			return 2;
+		case TextureFormat::RGBA8:
+			return 4;
+		case TextureFormat::BC1:
+		case TextureFormat::BC4:
+			return 8;
+		case TextureFormat::BC3:
+		case TextureFormat::BC5:
+			return 16;
+		}
+
+		VESP_ASSERT(false && "Unknown texture format");
+		return 0;
+	}
+
+	U32 GetLevelSize(TextureFormat format, U32 width, U32 height)
+	{
+		if (IsBlockCompressed(format))
+			return std::max(1u, (width + 3) / 4) * std::max(1u, (height + 3) / 4) * GetElementSize(format);
+
+		return width * height * GetElementSize(format);
+	}
+
+	bool HasValidDimensions(TextureFormat format, U32 width, U32 height)
+	{
+		if (!width || !height)
+			return false;
+
+		return !IsBlockCompressed(format) || (width % 4 == 0 && height % 4 == 0);
+	}
+
+	ArrayView<U8> TextureData::GetLevel(U32 level)
+	{
+		auto& info = this->levels[level];
+		return ArrayView<U8>(this->data.data() + info.offset, info.size);
+	}
+
+	U32 TextureData::GetRowPitch(U32 level) const
+	{
+		auto width = this->levels[level].width;
+		if (IsBlockCompressed(this->format))
+			return std::max(1u, (width + 3) / 4) * GetElementSize(this->format);
+
+		return width * GetElementSize(this->format);
+	}
+
+	void GenerateMip(ArrayView<U8> source, U32 width, U32 height, U32 channels,
+		MipFilter filter, Vector<U8>& dest)
+	{
+		VESP_ASSERT(channels == 1 || channels == 4);
+		VESP_ASSERT(source.size() == width * height * channels);
+
+		auto destWidth = std::max(1u, width / 2);
+		auto destHeight = std::max(1u, height / 2);
+		dest.resize(destWidth * destHeight * channels);
+
+		if (filter == MipFilter::Kaiser)
+			KaiserDownsample(source.data(), width, height, channels, dest.data(), destWidth, destHeight);
+		else
+			BoxDownsample(source.data(), width, height, channels, dest.data(), destWidth, destHeight);
+	}
+
+	void CompressLevel(TextureFormat format, ArrayView<U8> source, 
+		U32 width, U32 height, ArrayView<U8> dest)
+	{
+		VESP_ASSERT(IsBlockCompressed(format));
+		VESP_ASSERT(dest.size() == GetLevelSize(format, width, height));
+
+		auto const channels = GetSourceChannels(format);
+		auto const blockSize = GetElementSize(format);
+		auto const blocksX = std::max(1u, (width + 3) / 4);
+		auto const blocksY = std::max(1u, (height + 3) / 4);
+
+		util::ParallelFor(blocksY, 4, [&](U32 blockY)
+		{
+			U8 block[16 * 4];
+			for (U32 blockX = 0; blockX < blocksX; ++blockX)
+			{
+				FetchBlock(source.data(), width, height, channels, blockX, blockY, block);
+				auto out = dest.data() + (blockY * blocksX + blockX) * blockSize;
+
+				switch (format)
+				{
+				case TextureFormat::BC1:
+					EncodeBC1(block, out);
+					break;
+				case TextureFormat::BC3:
+					EncodeBC4(block + 3, 4, out);
+					EncodeBC1(block, out + 8);
+					break;
+				case TextureFormat::BC4:
+					EncodeBC4(block, 1, out);
+					break;
+				case TextureFormat::BC5:
+					EncodeBC4(block, 2, out);
+					EncodeBC4(block + 1, 2, out + 8);
+					break;
+				default:
+					break;
+				}
+			}
+		});
+	}
+
+	TextureBuilder::TextureBuilder(StringView cacheDirectory)
+	{
+		this->directory_ = cacheDirectory.CopyToVector();
+		FileSystem::Get()->MakeDirectory(this->directory_);
+	}
+
+	bool TextureBuilder::Build(ArrayView<U8> encoded, TextureBuildOptions const& options, 
+		TextureData& texture)
+	{
+		auto key = this->GetKey(encoded, options);
+		if (this->Read(key, texture))
+			return true;
+
+		auto channels = GetMipChannels(options.format);
+
+		S32 width = 0, height = 0, components = 0;
+		auto pixels = stbi_load_from_memory(encoded.data(), S32(encoded.size()), 
+			&width, &height, &components, channels);
+		if (!pixels)
+			return false;
+
+		if (!HasValidDimensions(options.format, width, height))
+		{
+			LogError("Texture is %dx%d; block compressed formats need dimensions that are multiples of 4",
+				width, height);
+			stbi_image_free(pixels);
+			return false;
+		}
+
+		BuildFromPixels(ArrayView<U8>(pixels, width * height * channels), 
+			width, height, options, texture);
+		stbi_image_free(pixels);
+
+		this->Write(key, texture);
+		return true;
+	}
+
+	void TextureBuilder::BuildFromPixels(ArrayView<U8> pixels, U32 width, U32 height,
+		TextureBuildOptions const& options, TextureData& texture)
+	{
+		auto const mipChannels = GetMipChannels(options.format);
+		auto const sourceChannels = GetSourceChannels(options.format);
+		VESP_ASSERT(pixels.size() == width * height * mipChannels);
+		VESP_ASSERT(HasValidDimensions(options.format, width, height));
+
+		texture.format = options.format;
+		texture.width = width;
+		texture.height = height;
+		texture.levels.clear();
+		texture.data.clear();
+
+		Vector<U8> current(pixels.data(), pixels.data() + pixels.size());
+		Vector<U8> next;
+		Vector<U8> extracted;
+
+		for (;;)
+		{
+			TextureLevel level;
+			level.width = width;
+			level.height = height;
+			level.offset = U32(texture.data.size());
+			level.size = GetLevelSize(options.format, width, height);
+
+			texture.levels.push_back(level);
+			texture.data.resize(level.offset + level.size);
+
+			// Two channel formats are filtered with four channels and take
+			// the first two afterwards
+			ArrayView<U8> source = current;
+			if (sourceChannels != mipChannels)
+			{
+				extracted.resize(width * height * sourceChannels);
+				for (U32 i = 0; i < width * height; ++i)
+					memcpy(&extracted[i * sourceChannels], &current[i * mipChannels], sourceChannels);
+
+				source = extracted;
+			}
+
+			auto dest = texture.GetLevel(U32(texture.levels.size() - 1));
+			if (IsBlockCompressed(options.format))
+				CompressLevel(options.format, source, width, height, dest);
+			else
+				memcpy(dest.data(), source.data(), dest.size());
+
+			if (options.mipFilter == MipFilter::None || (width == 1 && height == 1))
+				break;
+
+			GenerateMip(current, width, height, mipChannels, options.mipFilter, next);
+			width = std::max(1u, width / 2);
+			height = std::max(1u, height / 2);
+			std::swap(current, next);
+		}
+	}
+
+	U64 TextureBuilder::GetKey(ArrayView<U8> encoded, TextureBuildOptions const& options) const
+	{
+		U64 key = (U64(TextureFileHeader::CurrentVersion) << 32) | 0x7a3f1c05;
+		key = HashBytes(encoded, key);
+
+		U8 settings[2] = { U8(options.format), U8(options.mipFilter) };
+		return HashBytes(ArrayView<U8>(settings), key);
+	}
+
+	String TextureBuilder::GetPath(U64 key) const
+	{
+		StringByte fileName[32];
+		snprintf(fileName, sizeof(fileName), "/%016" PRIx64 ".vspt", key);
+
+		return Concat(this->directory_, fileName);
+	}
+
+	bool TextureBuilder::Read(U64 key, TextureData& texture)
+	{
+		auto path = this->GetPath(key);
+		if (!FileSystem::Get()->Exists(path))
+			return false;
+
+		auto file = FileSystem::Get()->Open(path, FileSystem::Mode::ReadBinary);
+		if (!file.Exists())
+			return false;
+
+		TextureFileHeader header;
+		if (file.Read(ArrayView<U8>(reinterpret_cast<U8*>(&header), sizeof(header))) != sizeof(header))
+			return false;
+
+		if (header.magic != TextureFileHeader::Magic ||
+			header.version != TextureFileHeader::CurrentVersion ||
+			header.key != key ||
+			file.Size() != sizeof(header) + header.levelCount * sizeof(TextureLevel) + header.dataSize)
+		{
+			return false;
+		}
+
+		// The file may be truncated or from another build; nothing after
+		// this point should index past what was read
+		if (header.format > U8(TextureFormat::BC5))
+			return false;
+
+		texture.format = TextureFormat(header.format);
+		texture.width = header.width;
+		texture.height = header.height;
+		texture.levels.resize(header.levelCount);
+		texture.data.resize(header.dataSize);
+
+		auto levelBytes = U32(header.levelCount * sizeof(TextureLevel));
+		if (file.Read(ArrayView<U8>(reinterpret_cast<U8*>(texture.levels.data()), levelBytes)) != levelBytes ||
+			file.Read(texture.data) != header.dataSize)
+		{
+			return false;
+		}
+
+		for (auto& level : texture.levels)
+		{
+			if (U64(level.offset) + level.size > header.dataSize)
+				return false;
+		}
+
+		return true;
+	}
+
+	void TextureBuilder::Write(U64 key, TextureData& texture)
+	{
+		TextureFileHeader header = {};
+		header.magic = TextureFileHeader::Magic;
+		header.version = TextureFileHeader::CurrentVersion;
+		header.key = key;
+		header.width = texture.width;
+		header.height = texture.height;
+		header.levelCount = U32(texture.levels.size());
+		header.dataSize = U32(texture.data.size());
+		header.format = U8(texture.format);
+
+		auto path = this->GetPath(key);
+		auto tempPath = path;
+		Concat(tempPath, ".tmp");
+		Concat(tempPath, ToString(size_t(std::hash<std::thread::id>()(std::this_thread::get_id()))));
+
+		{
+			auto file = FileSystem::Get()->Open(tempPath, 
+				FileSystem::Mode::Enum(FileSystem::Mode::Write | FileSystem::Mode::Binary));
+			if (!file.Exists())
+				return;
+
+			file.Write(ArrayView<U8>(reinterpret_cast<U8*>(&header), sizeof(header)));
+			file.Write(ArrayView<U8>(reinterpret_cast<U8*>(texture.levels.data()), 
+				texture.levels.size() * sizeof(TextureLevel)));
+			file.Write(texture.data);
+		}
+
+		FileSystem::Get()->Rename(tempPath, path);
+	}
+
+} }
\ No newline at end of file
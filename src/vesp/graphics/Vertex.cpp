@@ -1,13 +1,79 @@
 #include "vesp/graphics/Vertex.hpp"
 #include "vesp/math/Util.hpp"
+#include "vesp/Assert.hpp"
 #include "vesp/Log.hpp"
 
-#include <glm/gtc/constants.hpp>
+#include <emmintrin.h>
+#include <cfloat>
+#include <cmath>
 
 namespace vesp { namespace graphics {
 
+	namespace
+	{
+		// Octahedral normal encoding: project onto the octahedron |x|+|y|+|z| = 1,
+		// fold the lower hemisphere over the diagonals, and store the resulting
+		// [-1, 1] square as two UNORM16 values. The scalar and SSE paths below
+		// must produce identical bits.
+		const F32 NormalRange = 65535.0f;
+
+		F32 SignNotZero(F32 value)
+		{
+			return value < 0.0f ? -1.0f : 1.0f;
+		}
+
+		U16 PackNormalComponent(F32 value)
+		{
+			return static_cast<U16>((value * 0.5f + 0.5f) * NormalRange + 0.5f);
+		}
+
+		F32 UnpackNormalComponent(U16 value)
+		{
+			return static_cast<F32>(value) * (2.0f / NormalRange) - 1.0f;
+		}
+
+		void EncodeNormal(Vec3 normal, U16 out[2])
+		{
+			auto l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+			auto invL1 = 1.0f / std::max(l1, FLT_MIN);
+
+			auto x = normal.x * invL1;
+			auto y = normal.y * invL1;
+
+			if (normal.z < 0.0f)
+			{
+				auto foldedX = (1.0f - std::abs(y)) * SignNotZero(x);
+				auto foldedY = (1.0f - std::abs(x)) * SignNotZero(y);
+				x = foldedX;
+				y = foldedY;
+			}
+
+			out[0] = PackNormalComponent(x);
+			out[1] = PackNormalComponent(y);
+		}
+
+		Vec3 DecodeNormal(U16 const in[2])
+		{
+			Vec3 v;
+			v.x = UnpackNormalComponent(in[0]);
+			v.y = UnpackNormalComponent(in[1]);
+			v.z = 1.0f - std::abs(v.x) - std::abs(v.y);
+
+			auto t = std::max(-v.z, 0.0f);
+			v.x -= v.x < 0.0f ? -t : t;
+			v.y -= v.y < 0.0f ? -t : t;
+
+			auto invLength = 1.0f / std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+			return v * invLength;
+		}
+	}
+
 	Vertex::Vertex()
+		: position(0.0f, 0.0f, 0.0f)
 	{
+		// Zero the packed fields so that vertices can be compared bytewise
+		this->normal[0] = this->normal[1] = 0;
+		this->texcoord[0] = this->texcoord[1] = 0;
 	}
 
 	Vertex::Vertex(Vec3 position, Vec3 normal, Vec2 texcoord)
@@ -40,26 +106,126 @@ namespace vesp { namespace graphics {
 
 	void Vertex::SetNormal(Vec3 normal)
 	{
-		float inclination = acos(normal.z);
-		float azimuth = atan2(normal.y, normal.x);
-
-		auto pi = glm::pi<float>();
-		this->normal[0] = math::PackFloat<U16>(inclination, 0, pi);
-		this->normal[1] = math::PackFloat<U16>(azimuth, -pi, pi);
+		EncodeNormal(normal, this->normal);
 	}
 
 	Vec3 Vertex::GetNormal() const
 	{
-		auto pi = glm::pi<float>();
-		float inclination = math::UnpackFloat<U16>(this->normal[0], 0, pi);
-		float azimuth = math::UnpackFloat<U16>(this->normal[1], -pi, pi);
-
-		float si = sin(inclination);
-		float ci = cos(inclination);
-		float sa = sin(azimuth);
-		float ca = cos(azimuth);
-		
-		return Vec3(si * ca, si * sa, ci);
+		return DecodeNormal(this->normal);
+	}
+
+	void PackNormals(ArrayView<Vertex> vertices, ArrayView<Vec3> normals)
+	{
+		VESP_ASSERT(vertices.size() == normals.size());
+		static_assert(sizeof(Vec3) == 3 * sizeof(F32), "Vec3 must be tightly packed");
+
+		auto const zero = _mm_setzero_ps();
+		auto const one = _mm_set1_ps(1.0f);
+		auto const half = _mm_set1_ps(0.5f);
+		auto const range = _mm_set1_ps(NormalRange);
+		auto const minimum = _mm_set1_ps(FLT_MIN);
+		auto const absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		auto const signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+
+		size_t const count = vertices.size();
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			// Load four tightly-packed Vec3s and transpose them to SoA
+			auto source = reinterpret_cast<F32 const*>(&normals[i]);
+			auto a = _mm_loadu_ps(source + 0); // x0 y0 z0 x1
+			auto b = _mm_loadu_ps(source + 4); // y1 z1 x2 y2
+			auto c = _mm_loadu_ps(source + 8); // z2 x3 y3 z3
+
+			auto bc = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 3, 2));
+			auto x = _mm_shuffle_ps(a, bc, _MM_SHUFFLE(3, 0, 3, 0));
+			auto y = _mm_shuffle_ps(
+				_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+				_mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)),
+				_MM_SHUFFLE(2, 0, 2, 0));
+			auto z = _mm_shuffle_ps(
+				_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+				_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)),
+				_MM_SHUFFLE(2, 0, 2, 0));
+
+			// Project onto the octahedron
+			auto l1 = _mm_add_ps(_mm_add_ps(
+				_mm_and_ps(x, absMask), _mm_and_ps(y, absMask)), _mm_and_ps(z, absMask));
+			auto invL1 = _mm_div_ps(one, _mm_max_ps(l1, minimum));
+			x = _mm_mul_ps(x, invL1);
+			y = _mm_mul_ps(y, invL1);
+
+			// Fold the lower hemisphere
+			auto signX = _mm_or_ps(one, _mm_and_ps(_mm_cmplt_ps(x, zero), signMask));
+			auto signY = _mm_or_ps(one, _mm_and_ps(_mm_cmplt_ps(y, zero), signMask));
+			auto foldedX = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(y, absMask)), signX);
+			auto foldedY = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(x, absMask)), signY);
+
+			auto lower = _mm_cmplt_ps(z, zero);
+			x = _mm_or_ps(_mm_and_ps(lower, foldedX), _mm_andnot_ps(lower, x));
+			y = _mm_or_ps(_mm_and_ps(lower, foldedY), _mm_andnot_ps(lower, y));
+
+			// Quantise and interleave as (x | y << 16)
+			auto qx = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(x, half), half), range), half));
+			auto qy = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(y, half), half), range), half));
+			auto packed = _mm_or_si128(qx, _mm_slli_epi32(qy, 16));
+
+			U32 results[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(results), packed);
+
+			for (size_t j = 0; j < 4; ++j)
+				memcpy(vertices[i + j].normal, &results[j], sizeof(results[j]));
+		}
+
+		for (; i < count; ++i)
+			EncodeNormal(normals[i], vertices[i].normal);
+	}
+
+	void UnpackNormals(ArrayView<Vertex> vertices, ArrayView<Vec3> normals)
+	{
+		VESP_ASSERT(vertices.size() == normals.size());
+
+		auto const zero = _mm_setzero_ps();
+		auto const one = _mm_set1_ps(1.0f);
+		auto const scale = _mm_set1_ps(2.0f / NormalRange);
+		auto const absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		auto const signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+		auto const lowMask = _mm_set1_epi32(0xFFFF);
+
+		size_t const count = vertices.size();
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			U32 encoded[4];
+			for (size_t j = 0; j < 4; ++j)
+				memcpy(&encoded[j], vertices[i + j].normal, sizeof(encoded[j]));
+
+			auto packed = _mm_loadu_si128(reinterpret_cast<__m128i const*>(encoded));
+			auto x = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(packed, lowMask)), scale), one);
+			auto y = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(packed, 16)), scale), one);
+			auto z = _mm_sub_ps(_mm_sub_ps(one, _mm_and_ps(x, absMask)), _mm_and_ps(y, absMask));
+
+			// Unfold the lower hemisphere
+			auto t = _mm_max_ps(_mm_sub_ps(zero, z), zero);
+			x = _mm_sub_ps(x, _mm_xor_ps(t, _mm_and_ps(_mm_cmplt_ps(x, zero), signMask)));
+			y = _mm_sub_ps(y, _mm_xor_ps(t, _mm_and_ps(_mm_cmplt_ps(y, zero), signMask)));
+
+			auto lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+			auto invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+
+			F32 xs[4], ys[4], zs[4];
+			_mm_storeu_ps(xs, _mm_mul_ps(x, invLength));
+			_mm_storeu_ps(ys, _mm_mul_ps(y, invLength));
+			_mm_storeu_ps(zs, _mm_mul_ps(z, invLength));
+
+			for (size_t j = 0; j < 4; ++j)
+				normals[i + j] = Vec3(xs[j], ys[j], zs[j]);
+		}
+
+		for (; i < count; ++i)
+			normals[i] = DecodeNormal(vertices[i].normal);
 	}
 
 } }
\ No newline at end of file
@@ -57,11 +57,11 @@ namespace vesp { namespace graphics {
 			break;
 
 		case WM_SETFOCUS:
-			EventManager::Get()->Fire("Window.Focus");
+			EventManager::Get()->Fire(events::WindowFocus());
 			break;
 
 		case WM_KILLFOCUS:
-			EventManager::Get()->Fire("Window.Unfocus");
+			EventManager::Get()->Fire(events::WindowUnfocus());
 			break;
 
 		case WM_SIZE:
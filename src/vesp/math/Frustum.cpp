@@ -0,0 +1,40 @@
+#include "vesp/math/Frustum.hpp"
+
+namespace vesp { namespace math {
+
+	Frustum Frustum::FromMatrix(Mat4 const& matrix)
+	{
+		auto row = [&](U32 i)
+		{
+			return Vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+		};
+
+		Frustum frustum;
+		frustum.planes[0] = row(3) + row(0); // Left
+		frustum.planes[1] = row(3) - row(0); // Right
+		frustum.planes[2] = row(3) + row(1); // Bottom
+		frustum.planes[3] = row(3) - row(1); // Top
+		frustum.planes[4] = row(2);          // Near
+		frustum.planes[5] = row(3) - row(2); // Far
+
+		return frustum;
+	}
+
+	bool Frustum::Intersects(Vec3 const& boundsMin, Vec3 const& boundsMax) const
+	{
+		for (auto& plane : this->planes)
+		{
+			// The corner furthest along the plane normal
+			Vec3 corner(
+				plane.x >= 0.0f ? boundsMax.x : boundsMin.x,
+				plane.y >= 0.0f ? boundsMax.y : boundsMin.y,
+				plane.z >= 0.0f ? boundsMax.z : boundsMin.z);
+
+			if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f)
+				return false;
+		}
+
+		return true;
+	}
+
+} }
\ No newline at end of file
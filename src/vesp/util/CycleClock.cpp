@@ -0,0 +1,67 @@
+#include "vesp/util/CycleClock.hpp"
+
+namespace vesp { namespace util {
+
+	namespace
+	{
+		typedef std::chrono::steady_clock::period SteadyPeriod;
+		const F64 SteadySecondsPerTick = F64(SteadyPeriod::num) / F64(SteadyPeriod::den);
+
+		bool HasInvariantCounter()
+		{
+			int info[4];
+			__cpuid(info, 0x80000000);
+			if (U32(info[0]) < 0x80000007)
+				return false;
+
+			// Advanced power management leaf: EDX bit 8 is the invariant TSC
+			__cpuid(info, 0x80000007);
+			return (info[3] & (1 << 8)) != 0;
+		}
+	}
+
+	bool CycleClock::useCounter_ = false;
+	F64 CycleClock::secondsPerTick_ = SteadySecondsPerTick;
+
+	void CycleClock::Calibrate()
+	{
+		typedef std::chrono::steady_clock Clock;
+
+		useCounter_ = false;
+		secondsPerTick_ = SteadySecondsPerTick;
+
+		if (!HasInvariantCounter())
+			return;
+
+		// Spin rather than sleep so that coarse scheduler ticks cannot
+		// stretch the interval between the two reads
+		auto startTime = Clock::now();
+		auto startCount = __rdtsc();
+
+		Clock::time_point endTime;
+		do
+		{
+			endTime = Clock::now();
+		}
+		while (endTime - startTime < std::chrono::milliseconds(20));
+		auto endCount = __rdtsc();
+
+		if (endCount <= startCount)
+			return;
+
+		auto seconds = std::chrono::duration<F64>(endTime - startTime).count();
+		secondsPerTick_ = seconds / F64(endCount - startCount);
+		useCounter_ = true;
+	}
+
+	F64 CycleClock::GetSecondsPerTick()
+	{
+		return secondsPerTick_;
+	}
+
+	bool CycleClock::UsesCounter()
+	{
+		return useCounter_;
+	}
+
+} }
\ No newline at end of file
@@ -1,28 +1,97 @@
 #include "vesp/world/HeightMapTerrain.hpp"
 
+#include "vesp/graphics/Engine.hpp"
 #include "vesp/graphics/ShaderManager.hpp"
+#include "vesp/graphics/MeshOptimiser.hpp"
 
 #include "vesp/math/Util.hpp"
 
 #include "vesp/Profiler.hpp"
 
+#include <algorithm>
+
 namespace vesp { namespace world {
 
-HeightMapTerrain::HeightMapTerrain()
+namespace {
+
+struct TerrainAsset
 {
-	this->heightMap_ = graphics::Image::FromPath("data/heightmap.png");
-	this->Load();
+	graphics::Image heightMap;
+	graphics::OptimisedMesh mesh;
+
+	Vector<Vec3> occluderVertices;
+	Vector<U32> occluderIndices;
+};
+
+// Builds a coarse grid for occlusion culling. Each vertex takes the lowest
+// height around it, so the grid never rises above the rendered terrain and
+// cannot hide anything the terrain itself would not.
+void BuildOccluder(graphics::Image const& heightMap, TerrainAsset& asset)
+{
+	const S32 Step = 8;
+
+	auto data = heightMap.data.get();
+	S32 sizeX = heightMap.sizeX;
+	S32 sizeY = heightMap.sizeY;
+
+	auto gridX = (sizeX - 1 + Step - 1) / Step + 1;
+	auto gridY = (sizeY - 1 + Step - 1) / Step + 1;
+
+	auto& vertices = asset.occluderVertices;
+	auto& indices = asset.occluderIndices;
+	vertices.reserve(gridX * gridY);
+	indices.reserve((gridX - 1) * (gridY - 1) * 6);
+
+	for (S32 gy = 0; gy < gridY; ++gy)
+	{
+		for (S32 gx = 0; gx < gridX; ++gx)
+		{
+			auto x = std::min(gx * Step, sizeX - 1);
+			auto y = std::min(gy * Step, sizeY - 1);
+
+			U8 lowest = 255;
+			for (S32 sy = std::max(y - Step, 0); sy <= std::min(y + Step, sizeY - 1); ++sy)
+			{
+				for (S32 sx = std::max(x - Step, 0); sx <= std::min(x + Step, sizeX - 1); ++sx)
+					lowest = std::min(lowest, data[sy * sizeX + sx]);
+			}
+
+			vertices.push_back(Vec3(F32(x), lowest / 2.0f, F32(y)));
+		}
+	}
+
+	for (S32 gy = 0; gy < gridY - 1; ++gy)
+	{
+		for (S32 gx = 0; gx < gridX - 1; ++gx)
+		{
+			U32 i = gy * gridX + gx;
+			indices.push_back(i + gridX + 1);
+			indices.push_back(i + 1);
+			indices.push_back(i);
+
+			indices.push_back(i);
+			indices.push_back(i + gridX);
+			indices.push_back(i + gridX + 1);
+		}
+	}
 }
 
-void HeightMapTerrain::Load()
+// Runs on an asset loader worker; everything up to the GPU upload
+bool BuildTerrain(ArrayView<U8> encoded, TerrainAsset& asset)
 {
-	auto data = this->heightMap_.data.get();
-	S32 sizeX = this->heightMap_.sizeX;
-	S32 sizeY = this->heightMap_.sizeY;
+	VESP_PROFILE_COUNTERS("Build terrain");
+	VESP_MEMORY_SCOPE(Terrain);
+
+	asset.heightMap = graphics::Image::FromMemory(encoded);
+	if (!asset.heightMap.data)
+		return false;
 
-	LogInfo("Loading heightmap (%d %d)", sizeX, sizeY);
+	auto data = asset.heightMap.data.get();
+	S32 sizeX = asset.heightMap.sizeX;
+	S32 sizeY = asset.heightMap.sizeY;
 
 	Vector<graphics::Vertex> vertices;
+	Vector<Vec3> normals;
 	Vector<U32> indices;
 
 	auto GetIndex = [&](S32 x, S32 y) -> U32
@@ -41,6 +110,11 @@ void HeightMapTerrain::Load()
 		v.position = Vec3(x, height / 2.0f, y);
 		v.colour = graphics::Colour(height, 0, 255-height);
 
+		return v;
+	};
+
+	auto SampleNormal = [&](S32 x, S32 y) -> Vec3
+	{
 		// Use Sobel filter to calculate normals
 		F32 s[9];
 		s[0] = data[GetIndex(x-1, y+1)];
@@ -59,19 +133,23 @@ void HeightMapTerrain::Load()
 		normal.x = -(s[2] - s[0] + 2*(s[5] - s[3]) + s[8] - s[6]);
 		normal.y = -(s[6] - s[0] + 2*(s[7] - s[1]) + s[8] - s[2]);
 		normal.z = 1.0f;
-		normal = glm::normalize(normal);
-
-		v.SetNormal(normal);
-
-		return v;
+		return glm::normalize(normal);
 	};
 
 	vertices.reserve(sizeX * sizeY);
+	normals.reserve(sizeX * sizeY);
 	indices.reserve(sizeX * sizeY * 6);
 
 	for (S32 y = 0; y < sizeY; y += 1)
+	{
 		for (S32 x = 0; x < sizeX; x += 1)
+		{
 			vertices.push_back(Sample(x, y));
+			normals.push_back(SampleNormal(x, y));
+		}
+	}
+
+	graphics::PackNormals(vertices, normals);
 
 	const S32 SampleRate = 4;
 	for (S32 y = 0; y < sizeY; y += SampleRate)
@@ -88,15 +166,66 @@ void HeightMapTerrain::Load()
 		}
 	}
 
-	auto shaderManager = graphics::ShaderManager::Get();
-	VESP_ENFORCE(this->terrainMesh_.Create(vertices, indices));
-	this->terrainMesh_.SetVertexShader("default");
-	this->terrainMesh_.SetPixelShader("grid");
+	// Only every SampleRate-th vertex is referenced, so the optimiser also
+	// strips the unused vertices
+	asset.mesh = graphics::OptimiseMesh(vertices, indices);
+	BuildOccluder(asset.heightMap, asset);
+	return true;
+}
+
+}
+
+HeightMapTerrain::HeightMapTerrain()
+{
+	this->Load();
+}
+
+void HeightMapTerrain::Load()
+{
+	auto upload = [this](TerrainAsset& asset)
+	{
+		LogInfo("Loaded heightmap (%d %d)", asset.heightMap.sizeX, asset.heightMap.sizeY);
+
+		auto& mesh = asset.mesh;
+		if (mesh.Uses16BitIndices())
+			VESP_ENFORCE(this->terrainMesh_.Create(mesh.vertices, mesh.indices16));
+		else
+			VESP_ENFORCE(this->terrainMesh_.Create(mesh.vertices, mesh.indices32));
+
+		mesh.stats.LogSummary("Terrain");
+		this->terrainMesh_.SetVertexShader("default");
+		this->terrainMesh_.SetPixelShader("grid");
+
+		// The mesh lives on the GPU now; only the heightmap and occluder stay cached
+		mesh = graphics::OptimisedMesh();
+	};
+
+	auto sizeOf = [](TerrainAsset const& asset)
+	{
+		return sizeof(TerrainAsset) + asset.heightMap.sizeX * asset.heightMap.sizeY +
+			asset.occluderVertices.size() * sizeof(Vec3) + asset.occluderIndices.size() * sizeof(U32);
+	};
+
+	this->terrain_ = ResourceCache::Get()->Load<TerrainAsset>(
+		"data/heightmap.png", &BuildTerrain, upload, sizeOf);
+}
+
+void HeightMapTerrain::AddOccluders(graphics::OcclusionCuller& culler)
+{
+	VESP_PROFILE_FN();
+	if (!this->terrainMesh_.Exists())
+		return;
+
+	auto asset = this->terrain_.Get<TerrainAsset>();
+	culler.AddOccluder(asset->occluderVertices, asset->occluderIndices, this->terrainMesh_.GetWorld());
 }
 
 void HeightMapTerrain::Draw()
 {
 	VESP_PROFILE_FN();
+	if (!this->terrainMesh_.Exists() || !graphics::Engine::Get()->IsVisible(this->terrainMesh_))
+		return;
+
 	this->terrainMesh_.Draw();
 }
 
@@ -2,6 +2,12 @@
 
 #include "vesp/graphics/ShaderManager.hpp"
 
+#include "vesp/math/Util.hpp"
+
+#include "vesp/Profiler.hpp"
+
+#include <glm/geometric.hpp>
+
 namespace vesp { namespace world {
 
 ScalarField::ScalarField()
@@ -16,12 +22,15 @@ void ScalarField::Load(Scalar const* data, U32 xSize, U32 ySize, U32 zSize)
 	this->ySize_ = ySize;
 	this->zSize_ = zSize;
 
-	this->data_.reset(new Scalar[count]);
-	std::copy(data, data + count, stdext::checked_array_iterator<Scalar*>(this->data_.get(), count));
+	VESP_MEMORY_SCOPE(ScalarField);
+	this->data_.assign(data, data + count);
 }
 
 Vector<graphics::Vertex> ScalarField::Polygonise(Scalar isolevel)
 {
+	VESP_PROFILE_COUNTERS("Polygonise");
+	VESP_MEMORY_SCOPE(ScalarField);
+
 	auto xSize = this->xSize_;
 	auto ySize = this->ySize_;
 	auto zSize = this->zSize_;
@@ -29,9 +38,28 @@ Vector<graphics::Vertex> ScalarField::Polygonise(Scalar isolevel)
 	Vector<graphics::Vertex> vertices;
 	vertices.reserve(xSize*ySize*zSize);
 
-	auto data = this->data_.get();
+	Vector<Vec3> normals;
+	normals.reserve(xSize*ySize*zSize);
+
+	auto data = this->data_.data();
 	auto idx = [=](int i, int j, int k) { return i * (ySize * xSize) + j * (xSize)+k; };
 
+	// Central differences, clamped at the edges of the field
+	auto sample = [&](int i, int j, int k)
+	{
+		i = math::Clamp(i, 0, int(xSize) - 1);
+		j = math::Clamp(j, 0, int(ySize) - 1);
+		k = math::Clamp(k, 0, int(zSize) - 1);
+		return data[idx(i, j, k)];
+	};
+	auto gradient = [&](int i, int j, int k)
+	{
+		return Vec3(
+			sample(i + 1, j, k) - sample(i - 1, j, k),
+			sample(i, j + 1, k) - sample(i, j - 1, k),
+			sample(i, j, k + 1) - sample(i, j, k - 1));
+	};
+
 	for (auto k = 0u; k < zSize - 1; k++)
 	{
 		for (auto j = 0u; j < ySize - 1; j++)
@@ -45,6 +73,7 @@ Vector<graphics::Vertex> ScalarField::Polygonise(Scalar isolevel)
 				{
 					grid.p[index] = (base + Vec3(x, y, z)) / static_cast<F32>(1.0f);
 					grid.val[index] = data[idx(i+x, j+y, k+z)];
+					grid.grad[index] = gradient(i+x, j+y, k+z);
 				};
 
 				updateGridcell(0, 0, 0, 0);
@@ -56,18 +85,21 @@ Vector<graphics::Vertex> ScalarField::Polygonise(Scalar isolevel)
 				updateGridcell(6, 1, 1, 1);
 				updateGridcell(7, 0, 1, 1);
 
-				this->PolygoniseCell(grid, isolevel, vertices);
+				this->PolygoniseCell(grid, isolevel, vertices, normals);
 			}
 		}
 	}
 
-	LogInfo("Polygonised, %d vertices", vertices.size());
+	graphics::PackNormals(vertices, normals);
+
+	LogInfoDeferred("Polygonised, %d vertices", vertices.size());
 
 	return vertices;
 }
 
 // With credits to Paul Bourke: http://paulbourke.net/geometry/polygonise/
-void ScalarField::PolygoniseCell(GRIDCELL grid, Scalar isolevel, Vector<graphics::Vertex>& vertices)
+void ScalarField::PolygoniseCell(GRIDCELL grid, Scalar isolevel,
+	Vector<graphics::Vertex>& vertices, Vector<Vec3>& normals)
 {
 	int edgeTable[256] = {
 		0x000, 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
@@ -380,48 +412,55 @@ void ScalarField::PolygoniseCell(GRIDCELL grid, Scalar isolevel, Vector<graphics
 	Return the point between two points in the same ratio as
 	isolevel is between valp1 and valp2
 	*/
-	auto interpolate = [&](Vec3 p1, Vec3 p2, Scalar valp1, Scalar valp2)
+	graphics::Vertex vertexList[12];
+	Vec3 normalList[12];
+
+	auto interpolate = [&](int index, int c1, int c2)
 	{
+		auto valp1 = grid.val[c1];
+		auto valp2 = grid.val[c2];
 		auto mu = static_cast<F32>((isolevel - valp1) / (valp2 - valp1));
-		Vec3 p = p1 + mu * (p2 - p1);
+		Vec3 p = grid.p[c1] + mu * (grid.p[c2] - grid.p[c1]);
 		graphics::Vertex v;
 		v.position = p;
 		v.colour = graphics::Colour(static_cast<U8>(mu * 255), 0, 0);
-		return v;
+		vertexList[index] = v;
+		normalList[index] = glm::normalize(grid.grad[c1] + mu * (grid.grad[c2] - grid.grad[c1]));
 	};
 
-	graphics::Vertex vertexList[12];
-
 	/* Find the vertices where the surface intersects the cube */
 	if (edgeTable[cubeindex] & 1)
-		vertexList[0] = interpolate(grid.p[0], grid.p[1], grid.val[0], grid.val[1]);
+		interpolate(0, 0, 1);
 	if (edgeTable[cubeindex] & 2)
-		vertexList[1] = interpolate(grid.p[1], grid.p[2], grid.val[1], grid.val[2]);
+		interpolate(1, 1, 2);
 	if (edgeTable[cubeindex] & 4)
-		vertexList[2] = interpolate(grid.p[2], grid.p[3], grid.val[2], grid.val[3]);
+		interpolate(2, 2, 3);
 	if (edgeTable[cubeindex] & 8)
-		vertexList[3] = interpolate(grid.p[3], grid.p[0], grid.val[3], grid.val[0]);
+		interpolate(3, 3, 0);
 	if (edgeTable[cubeindex] & 16)
-		vertexList[4] = interpolate(grid.p[4], grid.p[5], grid.val[4], grid.val[5]);
+		interpolate(4, 4, 5);
 	if (edgeTable[cubeindex] & 32)
-		vertexList[5] = interpolate(grid.p[5], grid.p[6], grid.val[5], grid.val[6]);
+		interpolate(5, 5, 6);
 	if (edgeTable[cubeindex] & 64)
-		vertexList[6] = interpolate(grid.p[6], grid.p[7], grid.val[6], grid.val[7]);
+		interpolate(6, 6, 7);
 	if (edgeTable[cubeindex] & 128)
-		vertexList[7] = interpolate(grid.p[7], grid.p[4], grid.val[7], grid.val[4]);
+		interpolate(7, 7, 4);
 	if (edgeTable[cubeindex] & 256)
-		vertexList[8] = interpolate(grid.p[0], grid.p[4], grid.val[0], grid.val[4]);
+		interpolate(8, 0, 4);
 	if (edgeTable[cubeindex] & 512)
-		vertexList[9] = interpolate(grid.p[1], grid.p[5], grid.val[1], grid.val[5]);
+		interpolate(9, 1, 5);
 	if (edgeTable[cubeindex] & 1024)
-		vertexList[10] = interpolate(grid.p[2], grid.p[6], grid.val[2], grid.val[6]);
+		interpolate(10, 2, 6);
 	if (edgeTable[cubeindex] & 2048)
-		vertexList[11] = interpolate(grid.p[3], grid.p[7], grid.val[3], grid.val[7]);
+		interpolate(11, 3, 7);
 
 	for (int i = 0; triTable[cubeindex][i] != -1; i += 3)
 	{
 		for (int j = 3; j --> 0;)
+		{
 			vertices.push_back(vertexList[triTable[cubeindex][i + j]]);
+			normals.push_back(normalList[triTable[cubeindex][i + j]]);
+		}
 	}
 }
 
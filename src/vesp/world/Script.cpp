@@ -1,21 +1,33 @@
 #include "vesp/world/Script.hpp"
 
+#include "vesp/graphics/Engine.hpp"
 #include "vesp/graphics/ShaderManager.hpp"
+#include "vesp/graphics/MeshOptimiser.hpp"
 #include "vesp/graphics/imgui.h"
 
+#include "vesp/AssetLoader.hpp"
 #include "vesp/EventManager.hpp"
 #include "vesp/FileSystem.hpp"
+#include "vesp/FileWatcher.hpp"
+#include "vesp/Metrics.hpp"
 #include "vesp/Console.hpp"
 #include "vesp/Profiler.hpp"
 
 namespace vesp { namespace world {
 
+namespace
+{
+	Counter LuaCalls("lua_calls", "Calls from the engine into Lua");
+}
+
 extern "C" __declspec(dllexport) U32 MeshAdd(graphics::Vertex* vertices, U32 verticesCount)
 {
 	auto shaderManager = graphics::ShaderManager::Get();
 
 	graphics::Mesh mesh;
-	mesh.Create(ArrayView<graphics::Vertex>(vertices, verticesCount));
+	graphics::MeshOptimiserStats stats;
+	mesh.CreateOptimised(ArrayView<graphics::Vertex>(vertices, verticesCount), &stats);
+	stats.LogSummary("Script mesh");
 	mesh.SetVertexShader("default");
 	mesh.SetPixelShader("default");
 
@@ -27,6 +39,24 @@ extern "C" __declspec(dllexport) void MeshRemove(U32 meshId)
 	Script::Get()->RemoveMesh(meshId);
 }
 
+extern "C" __declspec(dllexport) void MeshSetOccluder(U32 meshId, Vec3* positions, U32 count)
+{
+	Script::Get()->SetOccluder(meshId, ArrayView<Vec3>(positions, count));
+}
+
+extern "C" __declspec(dllexport) void MeshPackNormals(
+	graphics::Vertex* vertices, Vec3* normals, U32 count)
+{
+	graphics::PackNormals(
+		ArrayView<graphics::Vertex>(vertices, count), 
+		ArrayView<Vec3>(normals, count));
+}
+
+namespace
+{
+	RawStringPtr WorldPath = "data/world.lua";
+}
+
 Script::Script()
 {
 	this->Reload();
@@ -35,26 +65,24 @@ Script::Script()
 
 void Script::Reload()
 {
+	VESP_MEMORY_SCOPE(Script);
 	this->meshes_.clear();
+	this->occluders_.clear();
 	this->module_.reset(new script::Module("World"));
+	++this->generation_;
 
 	auto& state = this->module_->GetState();
 	
 	state["dofile"] = [&](RawStringPtr filename)
 	{
-		auto path = Concat("data/", filename);
-		if (!FileSystem::Get()->Exists(path))
-			return;
-
-		auto file = FileSystem::Get()->Open(path, FileSystem::Mode::ReadBinary);
-		auto fileContents = file.Read<StringByte>();
-		this->module_->RunString(fileContents);
+		this->RunFile(Concat("data/", filename));
 	};
 
 	auto imgui = state.create_named_table("imgui");
 	imgui["window"] = [](char const* title, sol::protected_function fn)
 	{
 		ImGui::Begin(title);
+		LuaCalls.Add();
 		fn();
 		ImGui::End();
 	};
@@ -72,7 +100,45 @@ void Script::Reload()
 	};
 	imgui["separator"] = &ImGui::Separator;
 	
-	auto file = FileSystem::Get()->Open("data/world.lua", FileSystem::Mode::ReadBinary);
+	auto readSource = [](ArrayView<U8> data, String& source)
+	{
+		source.assign(data.begin(), data.end());
+		return true;
+	};
+
+	// A later reload replaces the module, so only run the source if the
+	// reload it was requested by is still the latest
+	auto generation = this->generation_;
+	auto runSource = [this, generation](String& source)
+	{
+		if (this->generation_ == generation)
+			this->module_->RunString(source);
+	};
+
+	AssetLoader::Get()->Load<String>(WorldPath, readSource, runSource);
+
+	// Editing the world itself needs a full reload, as it owns every mesh
+	auto fileWatcher = FileWatcher::Get();
+	if (!fileWatcher->IsWatched(WorldPath))
+		fileWatcher->Watch(WorldPath, [&](StringView) { this->Reload(); });
+}
+
+void Script::RunFile(StringView path)
+{
+	if (!FileSystem::Get()->Exists(path))
+		return;
+
+	// Files pulled in through dofile only define functions and tables, so
+	// an edit re-runs just that file in the live state
+	auto fileWatcher = FileWatcher::Get();
+	if (!fileWatcher->IsWatched(path))
+	{
+		fileWatcher->Watch(path, [&](StringView changedPath) { 
+			this->RunFile(changedPath); 
+		});
+	}
+
+	auto file = FileSystem::Get()->Open(path, FileSystem::Mode::ReadBinary);
 	auto fileContents = file.Read<StringByte>();
 	this->module_->RunString(fileContents);
 }
@@ -87,24 +153,59 @@ void Script::RemoveMesh(U32 meshId)
 {
 	VESP_ASSERT(this->meshes_.find(meshId) != this->meshes_.end());
 	this->meshes_.erase(meshId);
+	this->occluders_.erase(meshId);
+}
+
+void Script::SetOccluder(U32 meshId, ArrayView<Vec3> positions)
+{
+	VESP_ASSERT(this->meshes_.find(meshId) != this->meshes_.end());
+	VESP_ASSERT(positions.size() % 3 == 0);
+
+	auto& occluder = this->occluders_[meshId];
+	occluder.positions.assign(positions.begin(), positions.end());
+	occluder.indices.resize(positions.size());
+	for (U32 i = 0; i < occluder.indices.size(); ++i)
+		occluder.indices[i] = i;
+}
+
+void Script::AddOccluders(graphics::OcclusionCuller& culler)
+{
+	VESP_PROFILE_FN();
+	for (auto& occluderPair : this->occluders_)
+	{
+		auto& occluder = occluderPair.second;
+		auto world = this->meshes_.find(occluderPair.first)->second.GetWorld();
+		culler.AddOccluder(occluder.positions, occluder.indices, world);
+	}
 }
 
 void Script::Draw()
 {
 	VESP_PROFILE_FN();
+	auto engine = graphics::Engine::Get();
 	for (auto& meshPair : this->meshes_)
-		meshPair.second.Draw();
+	{
+		if (engine->IsVisible(meshPair.second))
+			meshPair.second.Draw();
+	}
 }
 
 void Script::Pulse()
 {
 	VESP_PROFILE_FN();
+	VESP_MEMORY_SCOPE(Script);
 	auto& state = this->module_->GetState();
 
+	// LuaJIT allocates its own heap, so it is reported rather than tracked
+	auto luaState = state.lua_state();
+	MemoryTracker::SetLiveBytes(MemoryTag::Lua, 
+		U64(lua_gc(luaState, LUA_GCCOUNT, 0)) * 1024 + U64(lua_gc(luaState, LUA_GCCOUNTB, 0)));
+
 	sol::object pulse = state["pulse"];
 	if (!pulse.is<sol::protected_function>())
 		return;
 
+	LuaCalls.Add();
 	auto runResult = pulse.as<sol::protected_function>()();
 
 	if (runResult.status() != sol::call_status::ok)
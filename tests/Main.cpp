@@ -0,0 +1,59 @@
+#include "Test.hpp"
+
+#include <cstdio>
+#include <vector>
+
+namespace vesp { namespace test {
+
+	namespace
+	{
+		struct Test
+		{
+			RawStringPtr name;
+			TestFunction function;
+		};
+
+		// Registrations run during static initialisation, so the list
+		// cannot be a global that might be constructed after them
+		std::vector<Test>& GetTests()
+		{
+			static std::vector<Test> tests;
+			return tests;
+		}
+
+		U32 failures = 0;
+	}
+
+	TestRegistration::TestRegistration(RawStringPtr name, TestFunction function)
+	{
+		GetTests().push_back({name, function});
+	}
+
+	void Fail(RawStringPtr condition, RawStringPtr file, U32 line)
+	{
+		printf("  %s:%u: check failed: %s\n", file, line, condition);
+		++failures;
+	}
+
+} }
+
+int main()
+{
+	using namespace vesp::test;
+
+	vesp::U32 failedTests = 0;
+	for (auto& test : GetTests())
+	{
+		auto failuresBefore = failures;
+		test.function();
+
+		auto passed = failures == failuresBefore;
+		if (!passed)
+			++failedTests;
+
+		printf("%s %s\n", passed ? "[pass]" : "[FAIL]", test.name);
+	}
+
+	printf("%u of %u tests failed\n", failedTests, vesp::U32(GetTests().size()));
+	return failedTests == 0 ? 0 : 1;
+}
\ No newline at end of file
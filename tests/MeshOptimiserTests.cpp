@@ -0,0 +1,265 @@
+#include "Test.hpp"
+
+#include "vesp/graphics/MeshOptimiser.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+using namespace vesp;
+using namespace vesp::graphics;
+
+namespace
+{
+	typedef std::array<U32, 3> Triangle;
+
+	bool SameVertex(Vertex const& a, Vertex const& b)
+	{
+		return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+	}
+
+	// Rotated so the smallest index comes first; the winding is kept
+	Triangle MakeTriangle(U32 a, U32 b, U32 c)
+	{
+		if (b < a && b < c)
+			return Triangle{{b, c, a}};
+		if (c < a && c < b)
+			return Triangle{{c, a, b}};
+		return Triangle{{a, b, c}};
+	}
+
+	Vector<Triangle> SortedTriangles(ArrayView<U32> indices)
+	{
+		Vector<Triangle> triangles;
+		for (size_t i = 0; i < indices.size(); i += 3)
+			triangles.push_back(MakeTriangle(indices[i], indices[i + 1], indices[i + 2]));
+
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	// A size x size grid of quads, with its triangles shuffled so that the
+	// original order is bad for the vertex cache
+	void MakeGrid(U32 size, Vector<Vertex>& vertices, Vector<U32>& indices)
+	{
+		vertices.clear();
+		indices.clear();
+
+		for (U32 y = 0; y <= size; ++y)
+		{
+			for (U32 x = 0; x <= size; ++x)
+				vertices.push_back(Vertex(Vec3(F32(x), 0.0f, F32(y)), Vec3(0.0f, 1.0f, 0.0f)));
+		}
+
+		Vector<Triangle> triangles;
+		for (U32 y = 0; y < size; ++y)
+		{
+			for (U32 x = 0; x < size; ++x)
+			{
+				auto i = y * (size + 1) + x;
+				triangles.push_back(Triangle{{i, i + size + 1, i + 1}});
+				triangles.push_back(Triangle{{i + 1, i + size + 1, i + size + 2}});
+			}
+		}
+
+		U32 seed = 12345;
+		for (size_t i = triangles.size() - 1; i > 0; --i)
+		{
+			seed = seed * 1664525 + 1013904223;
+			std::swap(triangles[i], triangles[(seed >> 8) % (i + 1)]);
+		}
+
+		for (auto& triangle : triangles)
+			indices.insert(indices.end(), triangle.begin(), triangle.end());
+	}
+
+	// Every output triangle uses the same vertex data, in the same winding,
+	// as an input triangle, and each input triangle is used exactly once
+	template <typename Index>
+	bool SameGeometry(ArrayView<Vertex> vertices, ArrayView<U32> indices,
+		ArrayView<Vertex> outVertices, ArrayView<Index> outIndices)
+	{
+		if (indices.size() != outIndices.size())
+			return false;
+
+		// Map output vertices back to the first matching input vertex, so
+		// that both sides can be compared as triangles of input indices
+		Vector<U32> outToIn(outVertices.size());
+		for (size_t o = 0; o < outVertices.size(); ++o)
+		{
+			auto it = std::find_if(vertices.begin(), vertices.end(),
+				[&](Vertex const& v) { return SameVertex(v, outVertices[o]); });
+			if (it == vertices.end())
+				return false;
+
+			outToIn[o] = U32(it - vertices.begin());
+		}
+
+		Vector<U32> expected, actual;
+		for (auto index : indices)
+		{
+			auto it = std::find_if(vertices.begin(), vertices.end(),
+				[&](Vertex const& v) { return SameVertex(v, vertices[index]); });
+			expected.push_back(U32(it - vertices.begin()));
+		}
+
+		for (auto index : outIndices)
+			actual.push_back(outToIn[index]);
+
+		return SortedTriangles(expected) == SortedTriangles(actual);
+	}
+}
+
+VESP_TEST(MeshOptimiserWeldsTriangleSoup)
+{
+	Vec3 const up(0.0f, 1.0f, 0.0f);
+	Vertex const a(Vec3(0, 0, 0), up), b(Vec3(1, 0, 0), up);
+	Vertex const c(Vec3(1, 0, 1), up), d(Vec3(0, 0, 1), up);
+	Vector<Vertex> soup = {a, b, c, a, c, d};
+
+	Vector<Vertex> vertices;
+	Vector<U32> indices;
+	WeldVertices(soup, ArrayView<U32>(), vertices, indices);
+
+	VESP_CHECK(vertices.size() == 4);
+	VESP_CHECK(indices.size() == soup.size());
+	for (size_t i = 0; i < indices.size(); ++i)
+		VESP_CHECK(SameVertex(vertices[indices[i]], soup[i]));
+
+	VESP_CHECK(indices[0] == indices[3]);
+	VESP_CHECK(indices[2] == indices[4]);
+}
+
+VESP_TEST(MeshOptimiserWeldsOnlyIdenticalVertices)
+{
+	// Same position but a different normal or colour is a different vertex
+	Vertex const a(Vec3(0, 0, 0), Vec3(0, 1, 0));
+	Vertex const b(Vec3(0, 0, 0), Vec3(1, 0, 0));
+	Vertex const c(Vec3(0, 0, 0), Vec3(0, 1, 0), Colour::Red);
+	Vector<Vertex> source = {a, b, c, a, b, c};
+	Vector<U32> sourceIndices = {0, 1, 2, 5, 4, 3};
+
+	Vector<Vertex> vertices;
+	Vector<U32> indices;
+	WeldVertices(source, sourceIndices, vertices, indices);
+
+	VESP_CHECK(vertices.size() == 3);
+	VESP_CHECK(indices.size() == sourceIndices.size());
+	for (size_t i = 0; i < indices.size(); ++i)
+		VESP_CHECK(SameVertex(vertices[indices[i]], source[sourceIndices[i]]));
+
+	Vector<U32> const expected = {0, 1, 2, 2, 1, 0};
+	VESP_CHECK(indices == expected);
+}
+
+VESP_TEST(MeshOptimiserCacheReorderKeepsTriangles)
+{
+	Vector<Vertex> vertices;
+	Vector<U32> indices;
+	MakeGrid(32, vertices, indices);
+
+	auto reordered = OptimiseVertexCache(indices, vertices.size());
+	VESP_CHECK(SortedTriangles(reordered) == SortedTriangles(indices));
+
+	auto before = CalculateACMR(indices, vertices.size());
+	auto after = CalculateACMR(reordered, vertices.size());
+	VESP_CHECK(after < before);
+	// A regular grid should come out well under one miss per triangle
+	VESP_CHECK(after < 1.0f);
+}
+
+VESP_TEST(MeshOptimiserFetchReorderUsesFirstUseOrder)
+{
+	Vector<Vertex> vertices;
+	for (U32 i = 0; i < 6; ++i)
+		vertices.push_back(Vertex(Vec3(F32(i), 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f)));
+
+	// Vertex 2 is never referenced
+	Vector<U32> indices = {5, 3, 0, 0, 3, 4, 1, 4, 3};
+	auto const original = vertices;
+	auto const originalIndices = indices;
+
+	OptimiseVertexFetch(vertices, indices);
+
+	VESP_CHECK(vertices.size() == 5);
+	Vector<U32> const expected = {0, 1, 2, 2, 1, 3, 4, 3, 1};
+	VESP_CHECK(indices == expected);
+	for (size_t i = 0; i < indices.size(); ++i)
+		VESP_CHECK(SameVertex(vertices[indices[i]], original[originalIndices[i]]));
+}
+
+VESP_TEST(MeshOptimiserKeepsGeometry)
+{
+	Vector<Vertex> vertices;
+	Vector<U32> indices;
+	MakeGrid(16, vertices, indices);
+
+	// Duplicate the grid's vertices so that welding has work to do
+	auto const original = vertices;
+	auto const originalCount = U32(original.size());
+	vertices.insert(vertices.end(), original.begin(), original.end());
+	for (size_t i = 0; i < indices.size(); i += 2)
+		indices[i] += originalCount;
+
+	auto mesh = OptimiseMesh(vertices, indices);
+	VESP_CHECK(mesh.Uses16BitIndices());
+	VESP_CHECK(mesh.vertices.size() == originalCount);
+	VESP_CHECK(SameGeometry<U16>(vertices, indices, mesh.vertices, mesh.indices16));
+
+	auto const& stats = mesh.stats;
+	VESP_CHECK(stats.vertexCountBefore == vertices.size());
+	VESP_CHECK(stats.vertexCountAfter == originalCount);
+	VESP_CHECK(stats.indexCountBefore == indices.size());
+	VESP_CHECK(stats.indexCountAfter == indices.size());
+	VESP_CHECK(stats.acmrAfter < stats.acmrBefore);
+	VESP_CHECK(stats.bytesAfter ==
+		originalCount * sizeof(Vertex) + indices.size() * sizeof(U16));
+}
+
+VESP_TEST(MeshOptimiserKeepsGeometryFromSoup)
+{
+	Vector<Vertex> vertices;
+	Vector<U32> indices;
+	MakeGrid(8, vertices, indices);
+
+	Vector<Vertex> soup;
+	for (auto index : indices)
+		soup.push_back(vertices[index]);
+
+	auto mesh = OptimiseMesh(soup);
+	VESP_CHECK(mesh.vertices.size() == vertices.size());
+	VESP_CHECK(SameGeometry<U16>(vertices, indices, mesh.vertices, mesh.indices16));
+	VESP_CHECK(mesh.stats.acmrBefore == 3.0f);
+}
+
+VESP_TEST(MeshOptimiserPicksIndexWidth)
+{
+	// One degenerate triangle per vertex; only the vertex count matters
+	auto makeMesh = [](U32 vertexCount)
+	{
+		Vector<Vertex> vertices;
+		Vector<U32> indices;
+		for (U32 i = 0; i < vertexCount; ++i)
+		{
+			vertices.push_back(Vertex(Vec3(F32(i), 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f)));
+			indices.insert(indices.end(), {i, i, i});
+		}
+
+		return OptimiseMesh(vertices, indices);
+	};
+
+	auto const maxU16 = U32(std::numeric_limits<U16>::max());
+
+	auto small = makeMesh(maxU16);
+	VESP_CHECK(small.Uses16BitIndices());
+	VESP_CHECK(small.indices16.size() == maxU16 * 3);
+	VESP_CHECK(small.indices32.empty());
+	VESP_CHECK(*std::max_element(small.indices16.begin(), small.indices16.end()) == maxU16 - 1);
+
+	auto large = makeMesh(maxU16 + 2);
+	VESP_CHECK(!large.Uses16BitIndices());
+	VESP_CHECK(large.indices16.empty());
+	VESP_CHECK(large.indices32.size() == (maxU16 + 2) * 3);
+	VESP_CHECK(*std::max_element(large.indices32.begin(), large.indices32.end()) == maxU16 + 1);
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "Test.hpp"
+
+#include "vesp/graphics/OcclusionCuller.hpp"
+#include "vesp/math/Matrix.hpp"
+
+using namespace vesp;
+using namespace vesp::graphics;
+
+namespace
+{
+	// Looking down +z from the origin, as the engine's cameras do
+	Mat4 MakeViewProjection()
+	{
+		return math::DXPerspective(glm::radians(60.0f), 320.0f / 192.0f, 1.0f, 1000.0f);
+	}
+
+	// A square in the plane z = depth, centred on the view axis
+	void AddWall(OcclusionCuller& culler, F32 depth, F32 halfSize, bool reversed = false)
+	{
+		Vector<Vec3> positions = {
+			Vec3(-halfSize, -halfSize, depth), Vec3(halfSize, -halfSize, depth),
+			Vec3(halfSize, halfSize, depth), Vec3(-halfSize, halfSize, depth)
+		};
+		Vector<U32> indices = {0, 1, 2, 0, 2, 3};
+		if (reversed)
+			indices = {0, 2, 1, 0, 3, 2};
+
+		culler.AddOccluder(positions, indices, Mat4());
+	}
+
+	bool IsBoxVisible(OcclusionCuller& culler, Vec3 centre, F32 halfSize)
+	{
+		return culler.IsVisible(centre - Vec3(halfSize), centre + Vec3(halfSize), Mat4());
+	}
+}
+
+VESP_TEST(OcclusionCullerEmptyBufferHidesNothing)
+{
+	OcclusionCuller culler;
+	culler.Begin(MakeViewProjection());
+	culler.Finish();
+
+	VESP_CHECK(IsBoxVisible(culler, Vec3(0, 0, 10), 1.0f));
+	VESP_CHECK(IsBoxVisible(culler, Vec3(0, 0, 900), 1.0f));
+	VESP_CHECK(culler.GetStats().occluded == 0);
+}
+
+VESP_TEST(OcclusionCullerHidesBoxesBehindOccluders)
+{
+	OcclusionCuller culler;
+	culler.Begin(MakeViewProjection());
+	AddWall(culler, 20.0f, 10.0f);
+	culler.Finish();
+
+	// Behind the wall
+	VESP_CHECK(!IsBoxVisible(culler, Vec3(0, 0, 40), 1.0f));
+	VESP_CHECK(!IsBoxVisible(culler, Vec3(2, -2, 500), 5.0f));
+	// In front of it, or reaching through it
+	VESP_CHECK(IsBoxVisible(culler, Vec3(0, 0, 10), 1.0f));
+	VESP_CHECK(IsBoxVisible(culler, Vec3(0, 0, 21), 2.0f));
+	// Behind it, but showing past its edge
+	VESP_CHECK(IsBoxVisible(culler, Vec3(30, 0, 40), 1.0f));
+	VESP_CHECK(IsBoxVisible(culler, Vec3(0, 0, 40), 25.0f));
+
+	auto& stats = culler.GetStats();
+	VESP_CHECK(stats.occluderTriangles == 2);
+	VESP_CHECK(stats.rasterisedTriangles == 2);
+	VESP_CHECK(stats.tested == 6);
+	VESP_CHECK(stats.occluded == 2);
+}
+
+VESP_TEST(OcclusionCullerOccludersAreTwoSided)
+{
+	OcclusionCuller culler;
+	culler.Begin(MakeViewProjection());
+	AddWall(culler, 20.0f, 10.0f, true);
+	culler.Finish();
+
+	VESP_CHECK(!IsBoxVisible(culler, Vec3(0, 0, 40), 1.0f));
+}
+
+VESP_TEST(OcclusionCullerLeavesNoCracksBetweenTriangles)
+{
+	OcclusionCuller culler;
+	culler.Begin(MakeViewProjection());
+	AddWall(culler, 20.0f, 10.0f);
+	culler.Finish();
+
+	// Small boxes along the diagonal the two triangles share
+	for (F32 t = -5.0f; t <= 5.0f; t += 0.5f)
+		VESP_CHECK(!IsBoxVisible(culler, Vec3(t * 4.0f, t * 4.0f, 100.0f), 0.05f));
+}
+
+VESP_TEST(OcclusionCullerClipsOccludersAtTheNearPlane)
+{
+	OcclusionCuller culler;
+	culler.Begin(MakeViewProjection());
+
+	// Ground below the camera, reaching from behind it into the distance
+	Vector<Vec3> positions = {
+		Vec3(-500, -2, -50), Vec3(500, -2, -50), Vec3(500, -2, 900), Vec3(-500, -2, 900)
+	};
+	Vector<U32> indices = {0, 1, 2, 0, 2, 3};
+	culler.AddOccluder(positions, indices, Mat4());
+	culler.Finish();
+
+	VESP_CHECK(culler.GetStats().rasterisedTriangles > 0);
+	// Under the ground, and standing on it
+	VESP_CHECK(!IsBoxVisible(culler, Vec3(0, -10, 100), 2.0f));
+	VESP_CHECK(IsBoxVisible(culler, Vec3(0, 0, 100), 1.5f));
+}
+
+VESP_TEST(OcclusionCullerTreatsBoxesAtTheNearPlaneAsVisible)
+{
+	OcclusionCuller culler;
+	culler.Begin(MakeViewProjection());
+	AddWall(culler, 2.0f, 10.0f);
+	culler.Finish();
+
+	// Crosses the near plane, so its screen bounds are unknown
+	VESP_CHECK(IsBoxVisible(culler, Vec3(0, 0, 1), 0.5f));
+}
+
+VESP_TEST(OcclusionCullerRejectsBoxesOffScreen)
+{
+	OcclusionCuller culler;
+	culler.Begin(MakeViewProjection());
+	culler.Finish();
+
+	VESP_CHECK(!IsBoxVisible(culler, Vec3(200, 0, 10), 1.0f));
+	VESP_CHECK(!IsBoxVisible(culler, Vec3(0, -200, 10), 1.0f));
+}
+
+VESP_TEST(OcclusionCullerAppliesWorldTransforms)
+{
+	OcclusionCuller culler;
+	culler.Begin(MakeViewProjection());
+
+	// The wall is built at the origin and moved in front of the camera
+	Vector<Vec3> positions = {
+		Vec3(-10, -10, 0), Vec3(10, -10, 0), Vec3(10, 10, 0), Vec3(-10, 10, 0)
+	};
+	Vector<U32> indices = {0, 1, 2, 0, 2, 3};
+	culler.AddOccluder(positions, indices, glm::translate(Mat4(), Vec3(0, 0, 20)));
+	culler.Finish();
+
+	auto boxWorld = glm::translate(Mat4(), Vec3(0, 0, 40));
+	VESP_CHECK(!culler.IsVisible(Vec3(-1), Vec3(1), boxWorld));
+	VESP_CHECK(culler.IsVisible(Vec3(-1), Vec3(1), glm::translate(Mat4(), Vec3(0, 0, 10))));
+}
+
+VESP_TEST(OcclusionCullerBeginClearsThePreviousView)
+{
+	OcclusionCuller culler;
+	culler.Begin(MakeViewProjection());
+	AddWall(culler, 20.0f, 10.0f);
+	culler.Finish();
+	VESP_CHECK(!IsBoxVisible(culler, Vec3(0, 0, 40), 1.0f));
+
+	culler.Begin(MakeViewProjection());
+	culler.Finish();
+	VESP_CHECK(IsBoxVisible(culler, Vec3(0, 0, 40), 1.0f));
+	VESP_CHECK(culler.GetStats().tested == 1);
+}
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "Test.hpp"
+
+#include "vesp/graphics/ShaderCache.hpp"
+
+using namespace vesp;
+using namespace vesp::graphics;
+
+namespace
+{
+	// Output depends on every input, so a blob reused for the wrong key
+	// shows up as the wrong bytecode
+	class FakeShaderCompiler : public ShaderCompiler
+	{
+	public:
+		bool Compile(StringView const source, ShaderCompileOptions const& options,
+			Vector<U8>& bytecode, String& errors) override
+		{
+			++this->compiles;
+			if (source == "error")
+			{
+				errors = StringView("syntax error").CopyToVector();
+				return false;
+			}
+
+			bytecode.clear();
+			auto append = [&](StringView const data) {
+				bytecode.insert(bytecode.end(), data.cbegin(), data.cend());
+				bytecode.push_back(0);
+			};
+
+			append(source);
+			append(options.target);
+			append(options.entryPoint);
+			bytecode.push_back(U8(options.flags));
+			for (auto& define : options.defines)
+			{
+				append(define.name);
+				append(define.value);
+			}
+
+			return true;
+		}
+
+		StringView GetIdentifier() const override
+		{
+			return this->identifier;
+		}
+
+		U32 compiles = 0;
+		RawStringPtr identifier = "fake 1";
+	};
+
+	class MemoryStorage : public ShaderCacheStorage
+	{
+	public:
+		bool Read(StringView const name, Vector<U8>& data) override
+		{
+			auto it = this->blobs.find(name.CopyToVector());
+			if (it == this->blobs.end())
+				return false;
+
+			data = it->second;
+			return true;
+		}
+
+		void Write(StringView const name, ArrayView<U8> data) override
+		{
+			this->blobs[name.CopyToVector()] = Vector<U8>(data.begin(), data.end());
+		}
+
+		UnorderedMap<String, Vector<U8>> blobs;
+	};
+
+	ShaderCompileOptions MakeOptions()
+	{
+		ShaderCompileOptions options;
+		options.name = StringView("test").CopyToVector();
+		options.target = StringView("ps_4_0").CopyToVector();
+		options.entryPoint = StringView("main").CopyToVector();
+		options.flags = 1;
+		options.defines.push_back({StringView("LIGHTS").CopyToVector(), StringView("4").CopyToVector()});
+		return options;
+	}
+}
+
+VESP_TEST(ShaderCacheMissThenHit)
+{
+	FakeShaderCompiler compiler;
+	MemoryStorage storage;
+	ShaderCache cache(compiler, storage);
+
+	auto options = MakeOptions();
+	Vector<U8> compiled, cached;
+	String errors;
+
+	VESP_CHECK(cache.Compile("source", options, compiled, errors));
+	VESP_CHECK(cache.GetMisses() == 1 && cache.GetHits() == 0);
+	VESP_CHECK(compiler.compiles == 1);
+	VESP_CHECK(storage.blobs.size() == 1);
+
+	VESP_CHECK(cache.Compile("source", options, cached, errors));
+	VESP_CHECK(cache.GetMisses() == 1 && cache.GetHits() == 1);
+	VESP_CHECK(compiler.compiles == 1);
+	VESP_CHECK(cached == compiled);
+}
+
+VESP_TEST(ShaderCacheHitsAcrossInstances)
+{
+	FakeShaderCompiler compiler;
+	MemoryStorage storage;
+	auto options = MakeOptions();
+	Vector<U8> compiled, cached;
+	String errors;
+
+	{
+		ShaderCache cache(compiler, storage);
+		VESP_CHECK(cache.Compile("source", options, compiled, errors));
+	}
+
+	ShaderCache cache(compiler, storage);
+	VESP_CHECK(cache.Compile("source", options, cached, errors));
+	VESP_CHECK(cache.GetHits() == 1);
+	VESP_CHECK(compiler.compiles == 1);
+	VESP_CHECK(cached == compiled);
+}
+
+VESP_TEST(ShaderCacheKeyCoversEveryInput)
+{
+	FakeShaderCompiler compiler;
+	MemoryStorage storage;
+	ShaderCache cache(compiler, storage);
+
+	auto base = MakeOptions();
+	auto key = cache.GetKey("source", base);
+	VESP_CHECK(cache.GetKey("source", MakeOptions()) == key);
+	VESP_CHECK(cache.GetKey("source2", base) != key);
+
+	auto options = base;
+	options.target = StringView("vs_4_0").CopyToVector();
+	VESP_CHECK(cache.GetKey("source", options) != key);
+
+	options = base;
+	options.entryPoint = StringView("main2").CopyToVector();
+	VESP_CHECK(cache.GetKey("source", options) != key);
+
+	options = base;
+	options.flags = 2;
+	VESP_CHECK(cache.GetKey("source", options) != key);
+
+	options = base;
+	options.defines[0].value = StringView("8").CopyToVector();
+	VESP_CHECK(cache.GetKey("source", options) != key);
+
+	options = base;
+	options.defines[0].name = StringView("SHADOWS").CopyToVector();
+	VESP_CHECK(cache.GetKey("source", options) != key);
+
+	options = base;
+	options.defines.push_back({StringView("SHADOWS").CopyToVector(), StringView("1").CopyToVector()});
+	VESP_CHECK(cache.GetKey("source", options) != key);
+
+	options = base;
+	options.defines.clear();
+	VESP_CHECK(cache.GetKey("source", options) != key);
+
+	// Moving text between a define's name and value must not collide
+	options = base;
+	options.defines[0].name = StringView("LIGHTS4").CopyToVector();
+	options.defines[0].value.clear();
+	VESP_CHECK(cache.GetKey("source", options) != key);
+
+	// The name is only used for diagnostics
+	options = base;
+	options.name = StringView("renamed").CopyToVector();
+	VESP_CHECK(cache.GetKey("source", options) == key);
+
+	compiler.identifier = "fake 2";
+	VESP_CHECK(cache.GetKey("source", base) != key);
+}
+
+VESP_TEST(ShaderCacheRecompilesChangedInputs)
+{
+	FakeShaderCompiler compiler;
+	MemoryStorage storage;
+	ShaderCache cache(compiler, storage);
+
+	auto base = MakeOptions();
+	Vector<U8> bytecode, expected;
+	String errors;
+
+	VESP_CHECK(cache.Compile("source", base, bytecode, errors));
+
+	auto check = [&](StringView const source, ShaderCompileOptions const& options)
+	{
+		auto compiles = compiler.compiles;
+		VESP_CHECK(cache.Compile(source, options, bytecode, errors));
+		VESP_CHECK(compiler.compiles == compiles + 1);
+
+		compiler.Compile(source, options, expected, errors);
+		VESP_CHECK(bytecode == expected);
+	};
+
+	check("source2", base);
+
+	auto options = base;
+	options.target = StringView("ps_5_0").CopyToVector();
+	check("source", options);
+
+	options = base;
+	options.flags = 4;
+	check("source", options);
+
+	options = base;
+	options.defines[0].value = StringView("8").CopyToVector();
+	check("source", options);
+
+	// Nothing above replaced the original entry
+	auto compiles = compiler.compiles;
+	VESP_CHECK(cache.Compile("source", base, bytecode, errors));
+	VESP_CHECK(compiler.compiles == compiles);
+}
+
+VESP_TEST(ShaderCacheIgnoresDamagedBlobs)
+{
+	FakeShaderCompiler compiler;
+	MemoryStorage storage;
+	ShaderCache cache(compiler, storage);
+
+	auto options = MakeOptions();
+	Vector<U8> compiled, bytecode;
+	String errors;
+	VESP_CHECK(cache.Compile("source", options, compiled, errors));
+
+	auto& blob = storage.blobs.begin()->second;
+	blob.pop_back();
+	VESP_CHECK(cache.Compile("source", options, bytecode, errors));
+	VESP_CHECK(compiler.compiles == 2);
+	VESP_CHECK(bytecode == compiled);
+
+	// The recompiled blob replaced the damaged one
+	storage.blobs.begin()->second[0] ^= 0xFF;
+	VESP_CHECK(cache.Compile("source", options, bytecode, errors));
+	VESP_CHECK(compiler.compiles == 3);
+
+	storage.blobs.begin()->second.resize(4);
+	VESP_CHECK(cache.Compile("source", options, bytecode, errors));
+	VESP_CHECK(compiler.compiles == 4);
+
+	VESP_CHECK(cache.Compile("source", options, bytecode, errors));
+	VESP_CHECK(compiler.compiles == 4);
+	VESP_CHECK(bytecode == compiled);
+}
+
+VESP_TEST(ShaderCacheDoesNotStoreFailures)
+{
+	FakeShaderCompiler compiler;
+	MemoryStorage storage;
+	ShaderCache cache(compiler, storage);
+
+	auto options = MakeOptions();
+	Vector<U8> bytecode;
+	String errors;
+
+	VESP_CHECK(!cache.Compile("error", options, bytecode, errors));
+	VESP_CHECK(!errors.empty());
+	VESP_CHECK(storage.blobs.empty());
+
+	VESP_CHECK(!cache.Compile("error", options, bytecode, errors));
+	VESP_CHECK(compiler.compiles == 2);
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "vesp/Assert.hpp"
+#include "vesp/Memory.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+// The test and benchmark programs only link the modules they cover. These
+// stand in for the engine systems those modules reach: assertions, which
+// report through the log, and the memory tracker, which feeds the metrics.
+namespace vesp
+{
+	void AssertFail(RawStringPtr error, RawStringPtr file, U32 line)
+	{
+		printf("Assertion failed! `%s` in %s:%u\n", error, file, line);
+		fflush(stdout);
+	}
+
+	thread_local MemoryTag::Enum MemoryTracker::currentTag_ = MemoryTag::General;
+
+	void* MemoryTracker::Allocate(size_t size, size_t alignment)
+	{
+		// Untracked, but aligned like the real thing; the original pointer
+		// is kept just before the one handed out
+		alignment = std::max(alignment, sizeof(void*));
+
+		auto base = static_cast<U8*>(malloc(size + alignment));
+		if (!base)
+			return nullptr;
+
+		auto ptr = base + alignment - reinterpret_cast<uintptr_t>(base) % alignment;
+		reinterpret_cast<void**>(ptr)[-1] = base;
+		return ptr;
+	}
+
+	void MemoryTracker::Free(void* ptr)
+	{
+		if (ptr)
+			free(static_cast<void**>(ptr)[-1]);
+	}
+}
\ No newline at end of file
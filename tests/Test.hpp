@@ -0,0 +1,31 @@
+#pragma once
+
+#include "vesp/Types.hpp"
+
+namespace vesp { namespace test {
+
+	typedef void (*TestFunction)();
+
+	// Adds a test to the list that Main.cpp runs, in no particular order
+	struct TestRegistration
+	{
+		TestRegistration(RawStringPtr name, TestFunction function);
+	};
+
+	// Marks the running test as failed; it carries on so that one run
+	// reports every broken check
+	void Fail(RawStringPtr condition, RawStringPtr file, U32 line);
+
+} }
+
+#define VESP_TEST(name) \
+	static void name(); \
+	static vesp::test::TestRegistration name##Registration(#name, &name); \
+	static void name()
+
+#define VESP_CHECK(cond) \
+	do \
+	{ \
+		if (!(cond)) \
+			vesp::test::Fail(#cond, __FILE__, __LINE__); \
+	} while(__LINE__ == -1)